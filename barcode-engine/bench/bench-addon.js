@@ -0,0 +1,160 @@
+/**
+ * Micro-benchmarks for the N-API boundary of the addon: InputToMat for every
+ * accepted input format, MatToRawJS, and the decoder calls including the
+ * JS <-> native conversion. Complements bench/bench.cpp, which measures the
+ * same primitives without N-API.
+ *
+ * Output follows the Google Benchmark JSON schema.
+ *
+ * Usage: node bench/bench-addon.js [--images DIR] [--filter TEXT] [--min-time SECONDS] [--out FILE]
+ */
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const barcode = require(path.join(__dirname, '../build/Release/barcode.node'));
+
+function parseArgs(argv) {
+  const args = { images: null, filter: '', minTime: 0.5, out: null };
+  for (let i = 0; i < argv.length; i++) {
+    const value = argv[i + 1];
+    switch (argv[i]) {
+      case '--images': args.images = value; i++; break;
+      case '--filter': args.filter = value; i++; break;
+      case '--min-time': args.minTime = parseFloat(value); i++; break;
+      case '--out': args.out = value; i++; break;
+      default:
+        console.error('Usage: node bench/bench-addon.js [--images DIR] [--filter TEXT] [--min-time SECONDS] [--out FILE]');
+        process.exit(1);
+    }
+  }
+  return args;
+}
+
+/**
+ * Deterministic gradient + noise frame (xorshift), channels: 1, 3 or 4
+ */
+function makeFrame(width, height, channels) {
+  const data = Buffer.alloc(width * height * channels);
+  let seed = 42;
+  for (let y = 0; y < height; y++) {
+    for (let x = 0; x < width; x++) {
+      seed ^= seed << 13; seed ^= seed >>> 17; seed ^= seed << 5;
+      const value = 64 + ((x * 96 / width) | 0) + ((y * 64 / height) | 0) + (seed & 15);
+      const offset = (y * width + x) * channels;
+      data.fill(value, offset, offset + channels);
+    }
+  }
+  return data;
+}
+
+function rawCases(label, width, height) {
+  const gray = makeFrame(width, height, 1);
+  const rgb = makeFrame(width, height, 3);
+  const shared = new SharedArrayBuffer(rgb.length);
+  new Uint8Array(shared).set(rgb);
+  const grayImage = { width, height, data: gray, colorSpace: 'GRAY' };
+
+  return [
+    // InputToMat (raw wrap, no copy) + MatToRawJS
+    { name: `convertToMat/buffer_gray/${label}`, bytes: gray.length, fn: () => barcode.convertToMat(grayImage) },
+    { name: `convertToMat/buffer_rgb/${label}`, bytes: rgb.length, fn: () => barcode.convertToMat({ width, height, data: rgb, colorSpace: 'RGB' }) },
+    { name: `convertToMat/uint8array_rgb/${label}`, bytes: rgb.length, fn: () => barcode.convertToMat({ width, height, data: new Uint8Array(rgb.buffer, rgb.byteOffset, rgb.length), colorSpace: 'RGB' }) },
+    { name: `convertToMat/arraybuffer_rgb/${label}`, bytes: rgb.length, fn: () => barcode.convertToMat({ width, height, data: rgb.buffer.slice(rgb.byteOffset, rgb.byteOffset + rgb.length), colorSpace: 'RGB' }) },
+    { name: `convertToMat/sharedarraybuffer_rgb/${label}`, bytes: rgb.length, fn: () => barcode.convertToMat({ width, height, data: new Uint8Array(shared), colorSpace: 'RGB' }) },
+    // Full addon calls, to compare with the native numbers of bench.cpp
+    { name: `preprocess_original/rgb/${label}`, bytes: rgb.length, fn: () => barcode.preprocess_original({ width, height, data: rgb, colorSpace: 'RGB' }) },
+    { name: `decode_zbar/${label}`, bytes: gray.length, fn: () => barcode.decode_zbar(grayImage) },
+    { name: `decode_zxing/${label}`, bytes: gray.length, fn: () => barcode.decode_zxing(grayImage, false) }
+  ];
+}
+
+function encodedCases(dir) {
+  return fs.readdirSync(dir)
+    .filter(name => !name.startsWith('.'))
+    .sort()
+    .map(name => ({ name, data: fs.readFileSync(path.join(dir, name)) }))
+    .map(file => ({
+      // InputToMat (imdecode) + MatToRawJS
+      name: `convertToMat/encoded/${file.name}`,
+      bytes: file.data.length,
+      fn: () => barcode.convertToMat(file.data)
+    }));
+}
+
+function run(benchCase, minTime) {
+  // Warm-up
+  benchCase.fn();
+
+  let iterations = 1;
+  for (;;) {
+    const cpuStart = process.cpuUsage();
+    const start = process.hrtime.bigint();
+    for (let i = 0; i < iterations; i++) {
+      benchCase.fn();
+    }
+    const elapsed = Number(process.hrtime.bigint() - start) / 1e9;
+    const cpu = process.cpuUsage(cpuStart);
+    const cpuElapsed = (cpu.user + cpu.system) / 1e6;
+
+    if (elapsed >= minTime || iterations >= 1e9) {
+      return {
+        name: benchCase.name,
+        run_name: benchCase.name,
+        run_type: 'iteration',
+        iterations: iterations,
+        real_time: elapsed * 1e9 / iterations,
+        cpu_time: cpuElapsed * 1e9 / iterations,
+        time_unit: 'ns',
+        bytes_per_second: benchCase.bytes * iterations / elapsed
+      };
+    }
+
+    // Aim slightly past minTime on the next round
+    const scale = elapsed > 0 ? Math.min(minTime * 1.4 / elapsed, 10) : 10;
+    iterations = Math.max(iterations + 1, Math.floor(iterations * scale));
+  }
+}
+
+function main() {
+  const args = parseArgs(process.argv.slice(2));
+
+  const cases = args.images
+    ? encodedCases(args.images)
+    : [
+      ...rawCases('640x480', 640, 480),
+      ...rawCases('1920x1080', 1920, 1080),
+      ...rawCases('4096x3072', 4096, 3072)
+    ];
+
+  const benchmarks = [];
+  for (const benchCase of cases) {
+    if (args.filter && !benchCase.name.includes(args.filter)) {
+      continue;
+    }
+    const result = run(benchCase, args.minTime);
+    benchmarks.push(result);
+    console.error(`${result.name}: ${(result.real_time / 1e6).toFixed(3)} ms`);
+  }
+
+  const report = {
+    context: {
+      date: new Date().toISOString(),
+      host_name: os.hostname(),
+      executable: process.argv[1],
+      num_cpus: os.cpus().length,
+      node_version: process.version,
+      library_build_type: 'release'
+    },
+    benchmarks: benchmarks
+  };
+
+  const json = JSON.stringify(report, null, 2) + '\n';
+  if (args.out) {
+    fs.writeFileSync(args.out, json);
+  } else {
+    process.stdout.write(json);
+  }
+}
+
+main();
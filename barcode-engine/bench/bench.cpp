@@ -0,0 +1,380 @@
+/*
+Native micro-benchmarks for the engine primitives (preprocessing, decoders,
+image decoding and colour conversion used by InputToMat).
+
+Output follows the Google Benchmark JSON schema, so results can be compared
+with its tools/compare.py or tracked by any CI dashboard that reads it.
+
+Usage: barcode_bench [--images DIR | --pack FILE] [--filter TEXT] [--min-time SECONDS] [--out FILE]
+  --images    Benchmark every image of DIR instead of synthetic frames
+  --pack      Benchmark every image of a packed corpus (tools/pack-corpus.js),
+              read from its memory mapping; encoded images also get an
+              imdecode/mapped case decoding the original file bytes
+  --filter    Only run benchmarks whose name contains TEXT
+  --min-time  Minimum measuring time per benchmark (default: 0.5)
+  --out       Write the JSON report to FILE instead of stdout
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "../src/decoder.h"
+#include "../src/pack.h"
+
+using namespace std;
+
+struct BenchCase {
+  string name;
+  function<size_t()> body;  // returns something derived from the work, so it cannot be optimised away
+  size_t bytesProcessed;
+};
+
+struct BenchResult {
+  string name;
+  int64_t iterations;
+  double realTimeNs;
+  double cpuTimeNs;
+  double bytesPerSecond;
+};
+
+struct NamedImage {
+  string label;
+  cv::Mat bgr;
+  const uint8_t* encoded = nullptr;  // original file bytes, when read from a pack
+  size_t encodedLength = 0;
+};
+
+static volatile size_t sink = 0;
+
+static string EscapeJson(const string& text)
+{
+  string out;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+// Deterministic frame with gradients, noise and a bar pattern, so the
+// decoders have edges to scan like on a real inspection image
+static cv::Mat MakeSyntheticFrame(int width, int height)
+{
+  cv::Mat frame(height, width, CV_8UC3);
+  cv::RNG rng(42);
+
+  for (int y = 0; y < height; y++) {
+    cv::Vec3b* row = frame.ptr<cv::Vec3b>(y);
+    for (int x = 0; x < width; x++) {
+      uchar base = static_cast<uchar>(64 + (x * 96 / width) + (y * 64 / height));
+      row[x] = cv::Vec3b(base, static_cast<uchar>(base + 16), static_cast<uchar>(base - 16));
+    }
+  }
+
+  cv::Mat noise(height, width, CV_8UC3);
+  rng.fill(noise, cv::RNG::NORMAL, 0, 12);
+  frame += noise;
+
+  int barLeft = width / 4;
+  int barTop = height / 3;
+  int module = max(2, width / 400);
+  for (int x = barLeft, i = 0; x < width * 3 / 4; x += module, i++) {
+    if (rng.uniform(0, 2) == 1) {
+      cv::rectangle(frame, cv::Rect(x, barTop, module, height / 3), cv::Scalar::all(20), cv::FILLED);
+    }
+  }
+  return frame;
+}
+
+static vector<NamedImage> LoadImages(const string& dir)
+{
+  vector<NamedImage> images;
+  DIR* handle = opendir(dir.c_str());
+  if (handle == nullptr) {
+    cerr << "Cannot open image directory: " << dir << endl;
+    return images;
+  }
+
+  vector<string> names;
+  while (struct dirent* entry = readdir(handle)) {
+    if (entry->d_name[0] != '.') {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(handle);
+  sort(names.begin(), names.end());
+
+  for (const string& name : names) {
+    cv::Mat image = cv::imread(dir + "/" + name, cv::IMREAD_COLOR);
+    if (!image.empty()) {
+      images.push_back({name, image});
+    }
+  }
+  return images;
+}
+
+// File names of a pack manifest, in index order. The manifest is written by
+// tools/pack-corpus.js with one { file, codes } object per image.
+static vector<string> PackFileNames(const string& manifest)
+{
+  vector<string> names;
+  const string key = "\"file\":";
+  for (size_t pos = manifest.find(key); pos != string::npos; pos = manifest.find(key, pos + key.size())) {
+    size_t start = manifest.find('"', pos + key.size());
+    size_t end = start == string::npos ? string::npos : manifest.find('"', start + 1);
+    if (end == string::npos) {
+      break;
+    }
+    names.push_back(manifest.substr(start + 1, end - start - 1));
+  }
+  return names;
+}
+
+// Images of a pack, wrapped in place; `pack` keeps the mapping alive
+static vector<NamedImage> LoadPack(const string& path, shared_ptr<const PackFile>& pack)
+{
+  vector<NamedImage> images;
+  string errorMsg;
+  pack = pack_read(path, errorMsg);
+  if (!pack) {
+    cerr << errorMsg << endl;
+    return images;
+  }
+
+  vector<string> names = PackFileNames(pack->manifest);
+  for (size_t i = 0; i < pack->entries.size(); i++) {
+    const PackEntry& entry = pack->entries[i];
+    uint8_t* data = const_cast<uint8_t*>(pack->data(i));
+    NamedImage image;
+    image.label = i < names.size() ? names[i] : "frame-" + to_string(i);
+
+    if (entry.colorSpace == PACK_ENCODED) {
+      image.bgr = cv::imdecode(cv::Mat(1, static_cast<int>(entry.length), CV_8UC1, data), cv::IMREAD_COLOR);
+      image.encoded = data;
+      image.encodedLength = entry.length;
+    } else {
+      cv::Mat raw(entry.height, entry.width, CV_8UC(entry.channels), data);
+      switch (entry.colorSpace) {
+        case PACK_GRAY: cv::cvtColor(raw, image.bgr, cv::COLOR_GRAY2BGR); break;
+        case PACK_RGB: cv::cvtColor(raw, image.bgr, cv::COLOR_RGB2BGR); break;
+        case PACK_BGRA: cv::cvtColor(raw, image.bgr, cv::COLOR_BGRA2BGR); break;
+        case PACK_RGBA: cv::cvtColor(raw, image.bgr, cv::COLOR_RGBA2BGR); break;
+        default: image.bgr = raw; break;
+      }
+    }
+
+    if (!image.bgr.empty()) {
+      images.push_back(image);
+    }
+  }
+  return images;
+}
+
+static void AddImageCases(vector<BenchCase>& cases, const NamedImage& image)
+{
+  const string& label = image.label;
+  const cv::Mat bgr = image.bgr;
+  const size_t colorBytes = bgr.total() * bgr.elemSize();
+  const size_t grayBytes = bgr.total();
+
+  cv::Mat gray = preprocess_original(bgr);
+  cv::Mat rgb;
+  cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+
+  vector<uchar> jpeg, png;
+  cv::imencode(".jpg", bgr, jpeg, {cv::IMWRITE_JPEG_QUALITY, 90});
+  cv::imencode(".png", bgr, png);
+
+  // InputToMat: encoded Buffer path
+  cases.push_back({"imdecode/jpeg/" + label, [jpeg]() {
+    return cv::imdecode(jpeg, cv::IMREAD_UNCHANGED).total();
+  }, jpeg.size()});
+  cases.push_back({"imdecode/png/" + label, [png]() {
+    return cv::imdecode(png, cv::IMREAD_UNCHANGED).total();
+  }, png.size()});
+
+  // The image's own file bytes, straight from the pack mapping
+  if (image.encoded != nullptr) {
+    cv::Mat mapped(1, static_cast<int>(image.encodedLength), CV_8UC1, const_cast<uint8_t*>(image.encoded));
+    cases.push_back({"imdecode/mapped/" + label, [mapped]() {
+      return cv::imdecode(mapped, cv::IMREAD_UNCHANGED).total();
+    }, image.encodedLength});
+  }
+
+  // InputToMat: raw RGB bitmap path
+  cases.push_back({"cvtColor/rgb2bgr/" + label, [rgb]() {
+    cv::Mat out;
+    cv::cvtColor(rgb, out, cv::COLOR_RGB2BGR);
+    return out.total();
+  }, colorBytes});
+
+  // Preprocessing primitives
+  cases.push_back({"preprocess_original/bgr/" + label, [bgr]() { return preprocess_original(bgr).total(); }, colorBytes});
+  cases.push_back({"preprocess_original/gray/" + label, [gray]() { return preprocess_original(gray).total(); }, grayBytes});
+  cases.push_back({"preprocess_histogram/bgr/" + label, [bgr]() { return preprocess_histogram(bgr).total(); }, colorBytes});
+  cases.push_back({"preprocess_otsu/bgr/" + label, [bgr]() { return preprocess_otsu(bgr).total(); }, colorBytes});
+
+  // Decoders on the grayscale image
+  cases.push_back({"decode_zbar/" + label, [gray]() { return decode_zbar(gray).size(); }, grayBytes});
+  cases.push_back({"decode_zxing/" + label, [gray]() { return decode_zxing(gray, false).size(); }, grayBytes});
+  cases.push_back({"decode_zxing_tryHarder/" + label, [gray]() { return decode_zxing(gray, true).size(); }, grayBytes});
+}
+
+static double CpuSeconds()
+{
+  return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+}
+
+static BenchResult RunCase(const BenchCase& benchCase, double minTime)
+{
+  // Warm-up (first-touch allocations, decoder tables)
+  sink = sink + benchCase.body();
+
+  int64_t iterations = 1;
+  while (true) {
+    auto start = chrono::steady_clock::now();
+    double cpuStart = CpuSeconds();
+    for (int64_t i = 0; i < iterations; i++) {
+      sink = sink + benchCase.body();
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double cpuElapsed = CpuSeconds() - cpuStart;
+
+    if (elapsed >= minTime || iterations >= 1000000000) {
+      return {
+        benchCase.name,
+        iterations,
+        elapsed * 1e9 / iterations,
+        cpuElapsed * 1e9 / iterations,
+        benchCase.bytesProcessed * iterations / elapsed
+      };
+    }
+
+    // Aim slightly past minTime on the next round
+    double scale = elapsed > 0 ? minTime * 1.4 / elapsed : 10.0;
+    iterations = max(iterations + 1, static_cast<int64_t>(iterations * min(scale, 10.0)));
+  }
+}
+
+static string CurrentDate()
+{
+  time_t now = time(nullptr);
+  char buf[64];
+  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+  return buf;
+}
+
+static void WriteJson(ostream& out, const vector<BenchResult>& results, const string& executable)
+{
+  char host[256] = {0};
+  gethostname(host, sizeof(host) - 1);
+
+  out << "{\n  \"context\": {\n"
+      << "    \"date\": \"" << CurrentDate() << "\",\n"
+      << "    \"host_name\": \"" << EscapeJson(host) << "\",\n"
+      << "    \"executable\": \"" << EscapeJson(executable) << "\",\n"
+      << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n"
+      << "    \"opencv_version\": \"" << CV_VERSION << "\",\n"
+      << "    \"library_build_type\": \"release\"\n"
+      << "  },\n  \"benchmarks\": [";
+
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult& r = results[i];
+    out << (i ? ",\n" : "\n")
+        << "    {\"name\": \"" << EscapeJson(r.name) << "\", \"run_name\": \"" << EscapeJson(r.name)
+        << "\", \"run_type\": \"iteration\", \"iterations\": " << r.iterations
+        << ", \"real_time\": " << r.realTimeNs << ", \"cpu_time\": " << r.cpuTimeNs
+        << ", \"time_unit\": \"ns\", \"bytes_per_second\": " << r.bytesPerSecond << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+  string imagesDir, packPath, filter, outPath;
+  double minTime = 0.5;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--images" && i + 1 < argc) {
+      imagesDir = argv[++i];
+    } else if (arg == "--pack" && i + 1 < argc) {
+      packPath = argv[++i];
+    } else if (arg == "--filter" && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (arg == "--min-time" && i + 1 < argc) {
+      minTime = atof(argv[++i]);
+    } else if (arg == "--out" && i + 1 < argc) {
+      outPath = argv[++i];
+    } else {
+      cerr << "Usage: " << argv[0] << " [--images DIR | --pack FILE] [--filter TEXT] [--min-time SECONDS] [--out FILE]" << endl;
+      return 1;
+    }
+  }
+
+  vector<NamedImage> images;
+  shared_ptr<const PackFile> pack;
+  if (!packPath.empty()) {
+    images = LoadPack(packPath, pack);
+    if (images.empty()) {
+      cerr << "No readable images in " << packPath << endl;
+      return 1;
+    }
+  } else if (!imagesDir.empty()) {
+    images = LoadImages(imagesDir);
+    if (images.empty()) {
+      cerr << "No readable images in " << imagesDir << endl;
+      return 1;
+    }
+  } else {
+    images.push_back({"640x480", MakeSyntheticFrame(640, 480)});
+    images.push_back({"1920x1080", MakeSyntheticFrame(1920, 1080)});
+    images.push_back({"4096x3072", MakeSyntheticFrame(4096, 3072)});
+  }
+
+  vector<BenchCase> cases;
+  for (const NamedImage& image : images) {
+    AddImageCases(cases, image);
+  }
+
+  vector<BenchResult> results;
+  for (const BenchCase& benchCase : cases) {
+    if (!filter.empty() && benchCase.name.find(filter) == string::npos) {
+      continue;
+    }
+    results.push_back(RunCase(benchCase, minTime));
+    cerr << benchCase.name << ": " << results.back().realTimeNs / 1e6 << " ms" << endl;
+  }
+
+  if (outPath.empty()) {
+    WriteJson(cout, results, argv[0]);
+  } else {
+    ofstream out(outPath);
+    WriteJson(out, results, argv[0]);
+  }
+  return 0;
+}
@@ -5,77 +5,153 @@
     "zbar_include_dir%": "",
     "zbar_lib_dir%": "",
     "zxing_include_dir%": "",
-    "zxing_lib_dir%": ""
+    "zxing_lib_dir%": "",
+    "build_tools%": "false"
+  },
+  "target_defaults": {
+    "cflags!": [ "-fno-exceptions", "-fno-rtti" ],
+    "cflags_cc!": [ "-fno-exceptions", "-fno-rtti" ],
+    "cflags": [ "-fexceptions" ],
+    "cflags_cc": [ "-std=c++17", "-fexceptions" ],
+    "conditions": [
+      ["OS=='linux'", {
+        "libraries": [ "-lrt" ]
+      }],
+      ["opencv_lib_dir!='' and zbar_lib_dir!='' and zxing_lib_dir!=''", {
+        "include_dirs": [
+          "<(opencv_include_dir)",
+          "<(opencv_include_dir)/../libjpeg-turbo",
+          "<(zbar_include_dir)",
+          "<(zxing_include_dir)",
+          "<!@(node -p \"require('node-addon-api').include\")"
+        ],
+        "libraries": [
+          "<(zbar_lib_dir)/libzbar.a",
+          "<(zxing_lib_dir)/libZXing.a",
+          "<(opencv_lib_dir)/libopencv_imgcodecs.a",
+          "<(opencv_lib_dir)/libopencv_imgproc.a",
+          "<(opencv_lib_dir)/libopencv_core.a",
+          "<(opencv_lib_dir)/opencv4/3rdparty/liblibtiff.a",
+          "<(opencv_lib_dir)/opencv4/3rdparty/liblibjpeg-turbo.a",
+          "<(opencv_lib_dir)/opencv4/3rdparty/liblibpng.a",
+          "<(opencv_lib_dir)/opencv4/3rdparty/liblibwebp.a",
+          "<(opencv_lib_dir)/opencv4/3rdparty/libzlib.a",
+          "-lpthread",
+          "-ldl",
+          "-lm"
+        ],
+        "ldflags": [
+          "-static-libgcc",
+          "-static-libstdc++"
+        ]
+      }, {
+        "libraries": [
+          "-L/usr/local/lib",
+          "-L/opt/homebrew/lib",
+          "-lzbar",
+          "-lZXing",
+          "-lopencv_core",
+          "-lopencv_imgcodecs",
+          "-lopencv_imgproc",
+          "-ljpeg"
+        ],
+        "include_dirs": [
+          "<!@(node -p \"require('node-addon-api').include\")",
+          "/usr/include/opencv4",
+          "/usr/local/include/opencv4",
+          "/opt/homebrew/include/opencv4",
+          "/usr/local/include",
+          "/opt/homebrew/include",
+          "/usr/include/ZXing",
+          "/usr/local/include/ZXing",
+          "/opt/homebrew/include/ZXing"
+        ]
+      }]
+    ],
+    "xcode_settings": {
+      "GCC_ENABLE_CPP_EXCEPTIONS": "YES"
+    },
+    "msvs_settings": {
+      "VCCLCompilerTool": {
+        "ExceptionHandling": 1
+      }
+    }
   },
   "targets": [
+    # Engine library: pipeline, decoders, I/O helpers and the C API
+    # (include/barcode_engine.h), without Node.js. Written to
+    # build/Release/barcode_engine.a for programs that link it directly.
     {
-      "target_name": "barcode",
-      "cflags!": [ "-fno-exceptions", "-fno-rtti" ],
-      "cflags_cc!": [ "-fno-exceptions", "-fno-rtti" ],
-      "cflags": [ "-fexceptions" ],
-      "cflags_cc": [ "-std=c++17", "-fexceptions" ],
+      "target_name": "barcode_engine",
+      "type": "static_library",
+      "standalone_static_library": 1,
+      "cflags": [ "-fPIC" ],
       "sources": [
         "./src/decoder.cpp",
+        "./src/pipeline.cpp",
+        "./src/metrics.cpp",
+        "./src/trace.cpp",
+        "./src/shm.cpp",
+        "./src/affinity.cpp",
+        "./src/record.cpp",
+        "./src/pack.cpp",
+        "./src/filemap.cpp",
+        "./src/json.cpp",
+        "./src/engine.cpp",
+        "./src/strip.cpp",
+        "./src/mjpeg.cpp",
+        "./src/jpeg.cpp"
+      ],
+      "direct_dependent_settings": {
+        "include_dirs": [ "./include" ]
+      }
+    },
+    # N-API binding over the engine library
+    {
+      "target_name": "barcode",
+      "dependencies": [ "barcode_engine" ],
+      "sources": [
         "./src/index.cpp"
       ],
-      "defines": [ "NAPI_CPP_EXCEPTIONS" ],
-      "conditions": [
-        ["opencv_lib_dir!='' and zbar_lib_dir!='' and zxing_lib_dir!=''", {
-          "include_dirs": [
-            "<(opencv_include_dir)",
-            "<(zbar_include_dir)",
-            "<(zxing_include_dir)",
-            "<!@(node -p \"require('node-addon-api').include\")"
-          ],
-          "libraries": [
-            "<(zbar_lib_dir)/libzbar.a",
-            "<(zxing_lib_dir)/libZXing.a",
-            "<(opencv_lib_dir)/libopencv_imgcodecs.a",
-            "<(opencv_lib_dir)/libopencv_imgproc.a",
-            "<(opencv_lib_dir)/libopencv_core.a",
-            "<(opencv_lib_dir)/opencv4/3rdparty/liblibjpeg-turbo.a",
-            "<(opencv_lib_dir)/opencv4/3rdparty/liblibpng.a",
-            "<(opencv_lib_dir)/opencv4/3rdparty/liblibwebp.a",
-            "<(opencv_lib_dir)/opencv4/3rdparty/libzlib.a",
-            "-lpthread",
-            "-ldl",
-            "-lm"
-          ],
-          "ldflags": [
-            "-static-libgcc",
-            "-static-libstdc++"
+      "defines": [ "NAPI_CPP_EXCEPTIONS" ]
+    }
+  ],
+  "conditions": [
+    # Developer tools, built with: node-gyp rebuild --build_tools=true
+    ["build_tools=='true'", {
+      "targets": [
+        {
+          "target_name": "barcode_bench",
+          "type": "executable",
+          "dependencies": [ "barcode_engine" ],
+          "sources": [
+            "./bench/bench.cpp"
           ]
-        }, {
-          "libraries": [
-            "-L/usr/local/lib",
-            "-L/opt/homebrew/lib",
-            "-lzbar",
-            "-lZXing",
-            "-lopencv_core",
-            "-lopencv_imgcodecs",
-            "-lopencv_imgproc"
-          ],
-          "include_dirs": [
-            "<!@(node -p \"require('node-addon-api').include\")",
-            "/usr/include/opencv4",
-            "/usr/local/include/opencv4",
-            "/opt/homebrew/include/opencv4",
-            "/usr/local/include",
-            "/opt/homebrew/include",
-            "/usr/include/ZXing",
-            "/usr/local/include/ZXing",
-            "/opt/homebrew/include/ZXing"
+        },
+        {
+          "target_name": "barcode_scan",
+          "type": "executable",
+          "dependencies": [ "barcode_engine" ],
+          "sources": [
+            "./tools/scan.cpp"
+          ]
+        },
+        {
+          "target_name": "barcode_serve",
+          "type": "executable",
+          "dependencies": [ "barcode_engine" ],
+          "sources": [
+            "./tools/serve.cpp"
+          ]
+        },
+        {
+          "target_name": "barcode_gen_corpus",
+          "type": "executable",
+          "sources": [
+            "./tools/gen-corpus.cpp"
           ]
-        }]
-      ],
-      "xcode_settings": {
-        "GCC_ENABLE_CPP_EXCEPTIONS": "YES"
-      },
-      "msvs_settings": {
-        "VCCLCompilerTool": {
-          "ExceptionHandling": 1
         }
-      }
-    }
+      ]
+    }]
   ]
 }
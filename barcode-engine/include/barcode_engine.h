@@ -0,0 +1,91 @@
+#ifndef BARCODE_ENGINE_H
+#define BARCODE_ENGINE_H
+
+/*
+ * C API of the barcode engine (libbarcode_engine.a).
+ *
+ * The same block pipeline as the Node-RED node and the addon, callable from
+ * any C or C++ program without Node.js: build a pipeline from the node's
+ * block configuration once, then decode images with it. Results are the
+ * JSON the node outputs for the image.
+ *
+ * A pipeline is immutable once created: any number of threads may decode
+ * with it concurrently. Strings returned through out-parameters are
+ * allocated by the library and released with barcode_free().
+ *
+ * The API is versioned with BARCODE_ENGINE_API_VERSION; existing functions
+ * keep their signature and behaviour within a version.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BARCODE_ENGINE_API_VERSION 1
+
+typedef enum {
+  BARCODE_OK = 0,
+  BARCODE_INVALID_ARGUMENT = 1,  /* null pointer, bad dimensions or configuration */
+  BARCODE_IMAGE_ERROR = 2,       /* the image could not be read or decoded */
+  BARCODE_INTERNAL_ERROR = 3
+} barcode_status;
+
+/* Layout of raw pixels, 8 bits per sample */
+typedef enum {
+  BARCODE_GRAY = 1,
+  BARCODE_BGR = 2,
+  BARCODE_RGB = 3,
+  BARCODE_BGRA = 4,
+  BARCODE_RGBA = 5
+} barcode_pixel_format;
+
+typedef struct {
+  const uint8_t* data;          /* first row */
+  int width;
+  int height;
+  size_t stride;                /* bytes per row, 0 = width * channels */
+  barcode_pixel_format format;
+} barcode_image;
+
+/* Configured block pipeline */
+typedef struct barcode_pipeline barcode_pipeline;
+
+/* BARCODE_ENGINE_API_VERSION the library was built with */
+int barcode_api_version(void);
+
+/*
+ * Create a pipeline from the node's configuration JSON:
+ *   { "blocks": [{ "decoder": "zbar" | "zxing", "preprocessing": "original" |
+ *     "histogram" | "otsu", "scale": 0.5, "options": { ... } }],
+ *     "executionMode": "parallel" | "sequential" }
+ * Returns NULL and, when error is not NULL, an error message on failure.
+ */
+barcode_pipeline* barcode_pipeline_create(const char* config_json, char** error);
+
+void barcode_pipeline_destroy(barcode_pipeline* pipeline);
+
+/*
+ * Decode raw pixels, an encoded image (JPEG, PNG, ...) in memory, or an image
+ * file (read through a memory mapping). On success *results_json receives the
+ * results array and, when warnings_json is not NULL, *warnings_json a JSON
+ * array of the blocks that failed. On failure *error (when not NULL) receives
+ * the reason. Raw pixels are read in place, only RGB/RGBA are copied.
+ */
+barcode_status barcode_decode_pixels(const barcode_pipeline* pipeline, const barcode_image* image,
+                                     char** results_json, char** warnings_json, char** error);
+barcode_status barcode_decode_encoded(const barcode_pipeline* pipeline, const uint8_t* data, size_t length,
+                                      char** results_json, char** warnings_json, char** error);
+barcode_status barcode_decode_file(const barcode_pipeline* pipeline, const char* path,
+                                   char** results_json, char** warnings_json, char** error);
+
+/* Release a string returned by the library (NULL is ignored) */
+void barcode_free(char* text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BARCODE_ENGINE_H */
@@ -0,0 +1,80 @@
+#ifndef BARCODE_SERVICE_H
+#define BARCODE_SERVICE_H
+
+/*
+ * Wire protocol of the decode service (barcode_serve), for producers on the
+ * same host that send images over a Unix-domain stream socket instead of
+ * posting them to Node-RED.
+ *
+ * A client writes requests, each a fixed 48-byte header followed by
+ * `payload` bytes, and reads one reply per request. Requests on one
+ * connection are decoded concurrently, so replies come back in completion
+ * order: match them by `id`. All integers are little-endian.
+ *
+ * Payload by kind:
+ *   BARCODE_SERVICE_PIXELS      raw pixels, `height` rows of `stride` bytes
+ *                               (the last row may end after width * channels)
+ *   BARCODE_SERVICE_ENCODED     an encoded image (JPEG, PNG, ...)
+ *   BARCODE_SERVICE_FILE        path of an image file on the host
+ *   BARCODE_SERVICE_SHM_PIXELS  name of a POSIX shared-memory segment holding
+ *                               raw pixels at `offset`; nothing is copied
+ *   BARCODE_SERVICE_SHM_ENCODED name of a segment holding `length` bytes of an
+ *                               encoded image at `offset`
+ *
+ * With BARCODE_SERVICE_NDJSON in `flags` the reply is one JSON line,
+ *   {"id":7,"results":[...],"warnings":[...],"decodeMs":3.2}  or
+ *   {"id":7,"error":"..."}
+ * otherwise a barcode_service_reply header followed by the results JSON
+ * array (or the error message) and the warnings JSON array.
+ */
+
+#include <stdint.h>
+
+#include "barcode_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BARCODE_SERVICE_REQUEST_MAGIC 0x31524342u  /* "BCR1" */
+#define BARCODE_SERVICE_REPLY_MAGIC 0x31534342u    /* "BCS1" */
+
+typedef enum {
+  BARCODE_SERVICE_PIXELS = 1,
+  BARCODE_SERVICE_ENCODED = 2,
+  BARCODE_SERVICE_FILE = 3,
+  BARCODE_SERVICE_SHM_PIXELS = 4,
+  BARCODE_SERVICE_SHM_ENCODED = 5
+} barcode_service_kind;
+
+/* Request flags */
+#define BARCODE_SERVICE_NDJSON 0x0001u
+
+typedef struct {
+  uint32_t magic;      /* BARCODE_SERVICE_REQUEST_MAGIC */
+  uint16_t kind;       /* barcode_service_kind */
+  uint16_t flags;
+  uint32_t id;         /* echoed in the reply */
+  uint32_t width;      /* raw pixels */
+  uint32_t height;
+  uint32_t stride;     /* bytes per row, 0 = width * channels */
+  uint32_t format;     /* barcode_pixel_format of raw pixels */
+  uint32_t payload;    /* bytes following the header */
+  uint64_t offset;     /* shared memory: start of the frame in the segment */
+  uint64_t length;     /* shared memory: bytes of the encoded image */
+} barcode_service_request;
+
+typedef struct {
+  uint32_t magic;      /* BARCODE_SERVICE_REPLY_MAGIC */
+  uint32_t id;
+  uint32_t status;     /* barcode_status */
+  uint32_t results;    /* bytes of the results array, or of the error message */
+  uint32_t warnings;   /* bytes of the warnings array (0 on error) */
+  uint32_t reserved;
+} barcode_service_reply;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BARCODE_SERVICE_H */
@@ -0,0 +1,143 @@
+#include "affinity.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+
+// From <numaif.h>; declared here to avoid a libnuma dependency
+static const int MPOL_BIND_MODE = 2;
+
+static bool BuildCpuSet(const vector<int>& cpus, cpu_set_t& set, string& errorMsg)
+{
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      errorMsg = "Invalid CPU index: " + to_string(cpu);
+      return false;
+    }
+    CPU_SET(cpu, &set);
+  }
+  if (CPU_COUNT(&set) == 0) {
+    errorMsg = "CPU list is empty";
+    return false;
+  }
+  return true;
+}
+
+bool set_thread_affinity(const vector<int>& cpus, string& errorMsg)
+{
+  cpu_set_t set;
+  if (!BuildCpuSet(cpus, set, errorMsg)) {
+    return false;
+  }
+
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    errorMsg = string("pthread_setaffinity_np failed: ") + strerror(err);
+    return false;
+  }
+  return true;
+}
+
+bool set_process_affinity(const vector<int>& cpus, string& errorMsg)
+{
+  cpu_set_t set;
+  if (!BuildCpuSet(cpus, set, errorMsg)) {
+    return false;
+  }
+
+  // sched_setaffinity only affects one thread; the runtime already started
+  // several (libuv pool, V8 platform), so apply it to every task of the process
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    errorMsg = string("Cannot list /proc/self/task: ") + strerror(errno);
+    return false;
+  }
+
+  bool ok = true;
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    pid_t tid = static_cast<pid_t>(atoi(entry->d_name));
+    // Threads may exit while we iterate (ESRCH), that is fine
+    if (sched_setaffinity(tid, sizeof(set), &set) != 0 && errno != ESRCH) {
+      errorMsg = string("sched_setaffinity failed: ") + strerror(errno);
+      ok = false;
+    }
+  }
+  closedir(dir);
+  return ok;
+}
+
+vector<int> get_thread_affinity()
+{
+  vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+bool numa_bind_memory(void* address, size_t size, int node, string& errorMsg)
+{
+  const size_t bitsPerWord = sizeof(unsigned long) * 8;
+  if (node < 0 || node >= static_cast<int>(bitsPerWord * 16)) {
+    errorMsg = "Invalid NUMA node: " + to_string(node);
+    return false;
+  }
+
+  unsigned long nodemask[16] = {0};
+  nodemask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+
+  if (syscall(SYS_mbind, address, size, MPOL_BIND_MODE, nodemask, bitsPerWord * 16, 0) != 0) {
+    errorMsg = string("mbind failed: ") + strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+#else
+
+bool set_thread_affinity(const vector<int>&, string& errorMsg)
+{
+  errorMsg = "CPU affinity is only supported on Linux";
+  return false;
+}
+
+bool set_process_affinity(const vector<int>&, string& errorMsg)
+{
+  errorMsg = "CPU affinity is only supported on Linux";
+  return false;
+}
+
+vector<int> get_thread_affinity()
+{
+  return vector<int>();
+}
+
+bool numa_bind_memory(void*, size_t, int, string& errorMsg)
+{
+  errorMsg = "NUMA binding is only supported on Linux";
+  return false;
+}
+
+#endif
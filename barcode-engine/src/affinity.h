@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Pin the calling thread to the given CPUs
+bool set_thread_affinity(const std::vector<int>& cpus, std::string& errorMsg);
+
+// Pin every thread of the process (and the threads it creates later) to the given CPUs
+bool set_process_affinity(const std::vector<int>& cpus, std::string& errorMsg);
+
+// CPUs the calling thread may run on
+std::vector<int> get_thread_affinity();
+
+// Bind the pages of a mapping to a NUMA node (MPOL_BIND). Pages not yet
+// allocated are allocated on that node when first touched or reserved.
+bool numa_bind_memory(void* address, size_t size, int node, std::string& errorMsg);
@@ -7,12 +7,16 @@ https://www.learnopencv.com/barcode-and-qr-code-scanner-using-zbar-and-opencv/
 #include <vector>
 #include <map>
 #include <set>
+#include <sstream>
 #include <zbar.h>
 #include <ZXing/ReadBarcode.h>
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include "decoder.h"
+#include "json.h"
+
 
 using namespace std;
 using namespace cv;
@@ -34,8 +38,47 @@ typedef struct
   vector<string> detectedBy;
 } decodedObject;
 
+// ZBar symbology names accepted in ZBarOptions::symbologies
+static const map<string, zbar_symbol_type_t> ZBAR_SYMBOLOGIES = {
+  {"ean8", ZBAR_EAN8},
+  {"ean13", ZBAR_EAN13},
+  {"upca", ZBAR_UPCA},
+  {"upce", ZBAR_UPCE},
+  {"isbn10", ZBAR_ISBN10},
+  {"isbn13", ZBAR_ISBN13},
+  {"i25", ZBAR_I25},
+  {"databar", ZBAR_DATABAR},
+  {"databar-exp", ZBAR_DATABAR_EXP},
+  {"codabar", ZBAR_CODABAR},
+  {"code39", ZBAR_CODE39},
+  {"code93", ZBAR_CODE93},
+  {"code128", ZBAR_CODE128},
+  {"qrcode", ZBAR_QRCODE}
+};
+
+static vector<string> SplitList(const string& list)
+{
+  vector<string> items;
+  stringstream stream(list);
+  string item;
+  while (getline(stream, item, ',')) {
+    item.erase(0, item.find_first_not_of(" \t"));
+    item.erase(item.find_last_not_of(" \t") + 1);
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
 // Simple ZBar decoder - takes grayscale image only
 string decode_zbar(const cv::Mat& grayscale)
+{
+  return decode_zbar(grayscale, ZBarOptions());
+}
+
+// ZBar decoder with symbology and density options
+string decode_zbar(const cv::Mat& grayscale, const ZBarOptions& options)
 {
   // Ensure we have a valid grayscale image
   if (grayscale.empty()) {
@@ -54,10 +97,31 @@ string decode_zbar(const cv::Mat& grayscale)
   ImageScanner scanner;
 
   // Configure scanner
-  scanner.set_config(ZBAR_QRCODE, ZBAR_CFG_ENABLE, 1);
+  vector<string> symbologies = SplitList(options.symbologies);
+  if (symbologies.empty()) {
+    scanner.set_config(ZBAR_QRCODE, ZBAR_CFG_ENABLE, 1);
+  } else {
+    // Only the requested symbologies: fewer candidate decoders per scan line
+    scanner.set_config(ZBAR_NONE, ZBAR_CFG_ENABLE, 0);
+    for (const string& name : symbologies) {
+      auto symbology = ZBAR_SYMBOLOGIES.find(name);
+      if (symbology == ZBAR_SYMBOLOGIES.end()) {
+        return "{\"error\": " + json_string("Unknown ZBar symbology: " + name) + "}";
+      }
+      scanner.set_config(symbology->second, ZBAR_CFG_ENABLE, 1);
+    }
+  }
+
+  // Scan every n-th row/column (1 = full density)
+  int density = max(1, options.density);
+  scanner.set_config(ZBAR_NONE, ZBAR_CFG_X_DENSITY, density);
+  scanner.set_config(ZBAR_NONE, ZBAR_CFG_Y_DENSITY, density);
+
+  // ZBar expects tightly packed rows (strided shared-memory frames are not)
+  Mat packed = grayscale.isContinuous() ? grayscale : grayscale.clone();
 
   // Wrap image data in a zbar image
-  Image image(grayscale.cols, grayscale.rows, "Y800", (uchar *)grayscale.data, grayscale.cols * grayscale.rows);
+  Image image(packed.cols, packed.rows, "Y800", (uchar *)packed.data, packed.cols * packed.rows);
 
   // Scan the image for barcodes and QRCodes
   scanner.scan(image);
@@ -109,6 +173,15 @@ string decode_zbar(const cv::Mat& grayscale)
 
 // Simple ZXing decoder - takes grayscale image only
 string decode_zxing(const cv::Mat& grayscale, bool tryHarder)
+{
+  ZXingOptions options;
+  options.tryHarder = tryHarder;
+  options.tryRotate = tryHarder;
+  return decode_zxing(grayscale, options);
+}
+
+// ZXing decoder with format, binarizer and search options
+string decode_zxing(const cv::Mat& grayscale, const ZXingOptions& options)
 {
   // Ensure we have a valid grayscale image
   if (grayscale.empty()) {
@@ -122,11 +195,32 @@ string decode_zxing(const cv::Mat& grayscale, bool tryHarder)
 
   // Configure ZXing options
   ZXing::DecodeHints hints;
-  hints.setTryHarder(tryHarder);
-  hints.setTryRotate(tryHarder);
+  hints.setTryHarder(options.tryHarder);
+  hints.setTryRotate(options.tryRotate);
+
+  if (!options.formats.empty()) {
+    try {
+      hints.setFormats(ZXing::BarcodeFormatsFromString(options.formats));
+    } catch (const exception&) {
+      return "{\"error\": " + json_string("Invalid ZXing formats: " + options.formats) + "}";
+    }
+  }
+
+  if (options.binarizer == "GlobalHistogram") {
+    hints.setBinarizer(ZXing::Binarizer::GlobalHistogram);
+  } else if (options.binarizer == "FixedThreshold") {
+    hints.setBinarizer(ZXing::Binarizer::FixedThreshold);
+  } else if (options.binarizer == "BoolCast") {
+    hints.setBinarizer(ZXing::Binarizer::BoolCast);
+  } else if (options.binarizer.empty() || options.binarizer == "LocalAverage") {
+    hints.setBinarizer(ZXing::Binarizer::LocalAverage);
+  } else {
+    return "{\"error\": " + json_string("Unknown ZXing binarizer: " + options.binarizer) + "}";
+  }
 
   // Create ImageView from cv::Mat
-  ZXing::ImageView imageView(grayscale.data, grayscale.cols, grayscale.rows, ZXing::ImageFormat::Lum);
+  ZXing::ImageView imageView(grayscale.data, grayscale.cols, grayscale.rows, ZXing::ImageFormat::Lum,
+                             static_cast<int>(grayscale.step));
 
   // Decode using ZXing
   ZXing::Results results = ZXing::ReadBarcodes(imageView, hints);
@@ -1,11 +1,32 @@
+#pragma once
+
 #include <string>
 #include <opencv2/opencv.hpp>
 
+// ZBar options: symbologies as a comma separated list of ZBar names
+// ("ean13,code128,qrcode"; empty = all), scan density in pixels (1 = every line)
+struct ZBarOptions {
+  std::string symbologies;
+  int density = 1;
+};
+
+// ZXing options: formats as accepted by ZXing::BarcodeFormatsFromString
+// ("QRCode,EAN-13"; empty = all), binarizer: LocalAverage, GlobalHistogram,
+// FixedThreshold or BoolCast
+struct ZXingOptions {
+  bool tryHarder = false;
+  bool tryRotate = false;
+  std::string formats;
+  std::string binarizer = "LocalAverage";
+};
+
 // Decoder primitives - take grayscale images only
 std::string decode_zbar(const cv::Mat& grayscale);
+std::string decode_zbar(const cv::Mat& grayscale, const ZBarOptions& options);
 std::string decode_zxing(const cv::Mat& grayscale, bool tryHarder);
+std::string decode_zxing(const cv::Mat& grayscale, const ZXingOptions& options);
 
 // Preprocessing primitives - convert BGR to preprocessed grayscale
 cv::Mat preprocess_original(const cv::Mat& bgr);
 cv::Mat preprocess_histogram(const cv::Mat& bgr);
-cv::Mat preprocess_otsu(const cv::Mat& bgr);
\ No newline at end of file
+cv::Mat preprocess_otsu(const cv::Mat& bgr);
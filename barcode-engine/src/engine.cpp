@@ -0,0 +1,186 @@
+// C API of the engine library (include/barcode_engine.h) over the C++
+// pipeline. No exception crosses the C boundary.
+
+#include "../include/barcode_engine.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "json.h"
+#include "pipeline.h"
+
+using namespace std;
+
+struct barcode_pipeline {
+  PipelineConfig config;
+};
+
+static char* CopyString(const string& text)
+{
+  char* copy = static_cast<char*>(malloc(text.size() + 1));
+  if (copy != nullptr) {
+    memcpy(copy, text.c_str(), text.size() + 1);
+  }
+  return copy;
+}
+
+static barcode_status Fail(barcode_status status, const string& message, char** error)
+{
+  if (error != nullptr) {
+    *error = CopyString(message);
+  }
+  return status;
+}
+
+static const char* ColorSpaceName(barcode_pixel_format format)
+{
+  switch (format) {
+    case BARCODE_GRAY: return "GRAY";
+    case BARCODE_BGR: return "BGR";
+    case BARCODE_RGB: return "RGB";
+    case BARCODE_BGRA: return "BGRA";
+    case BARCODE_RGBA: return "RGBA";
+    default: return nullptr;
+  }
+}
+
+// Run the pipeline on a decoded image and hand out its results
+static barcode_status Run(const barcode_pipeline* pipeline, const cv::Mat& image,
+                          char** results_json, char** warnings_json, char** error)
+{
+  vector<string> warnings;
+  string results = run_pipeline(image, pipeline->config, warnings);
+
+  *results_json = CopyString(results);
+  if (warnings_json != nullptr) {
+    string list = "[";
+    for (size_t i = 0; i < warnings.size(); i++) {
+      list += (i > 0 ? "," : "") + json_string(warnings[i]);
+    }
+    *warnings_json = CopyString(list + "]");
+  }
+  if (*results_json == nullptr) {
+    return Fail(BARCODE_INTERNAL_ERROR, "Out of memory", error);
+  }
+  return BARCODE_OK;
+}
+
+extern "C" {
+
+int barcode_api_version(void)
+{
+  return BARCODE_ENGINE_API_VERSION;
+}
+
+barcode_pipeline* barcode_pipeline_create(const char* config_json, char** error)
+{
+  if (config_json == nullptr) {
+    Fail(BARCODE_INVALID_ARGUMENT, "Configuration is null", error);
+    return nullptr;
+  }
+
+  try {
+    PipelineConfig config;
+    string errorMsg;
+    if (!read_pipeline_config(config_json, config, errorMsg)) {
+      Fail(BARCODE_INVALID_ARGUMENT, errorMsg, error);
+      return nullptr;
+    }
+    return new barcode_pipeline{config};
+  } catch (const exception& e) {
+    Fail(BARCODE_INTERNAL_ERROR, e.what(), error);
+    return nullptr;
+  }
+}
+
+void barcode_pipeline_destroy(barcode_pipeline* pipeline)
+{
+  delete pipeline;
+}
+
+barcode_status barcode_decode_pixels(const barcode_pipeline* pipeline, const barcode_image* image,
+                                     char** results_json, char** warnings_json, char** error)
+{
+  if (pipeline == nullptr || image == nullptr || image->data == nullptr || results_json == nullptr) {
+    return Fail(BARCODE_INVALID_ARGUMENT, "Pipeline, image, image data and results_json are required", error);
+  }
+  const char* colorSpace = ColorSpaceName(image->format);
+  if (colorSpace == nullptr) {
+    return Fail(BARCODE_INVALID_ARGUMENT, "Unknown pixel format " + to_string(image->format), error);
+  }
+
+  const int MAX_IMAGE_DIMENSION = 32768;
+  if (image->width <= 0 || image->height <= 0 || image->width > MAX_IMAGE_DIMENSION || image->height > MAX_IMAGE_DIMENSION) {
+    return Fail(BARCODE_INVALID_ARGUMENT, "Invalid image dimensions (width: " + to_string(image->width) +
+                ", height: " + to_string(image->height) + ")", error);
+  }
+
+  try {
+    int channels = 0;
+    int cvType = 0;
+    color_space_type(colorSpace, channels, cvType);
+    size_t rowBytes = static_cast<size_t>(image->width) * channels;
+    size_t stride = image->stride == 0 ? rowBytes : image->stride;
+    if (stride < rowBytes) {
+      return Fail(BARCODE_INVALID_ARGUMENT, "Stride (" + to_string(stride) + ") is smaller than a row (" +
+                  to_string(rowBytes) + " bytes)", error);
+    }
+
+    string errorMsg;
+    cv::Mat mat = wrap_pixels(image->data, image->width, image->height, stride, colorSpace, errorMsg);
+    if (mat.empty()) {
+      return Fail(BARCODE_IMAGE_ERROR, errorMsg, error);
+    }
+    return Run(pipeline, mat, results_json, warnings_json, error);
+  } catch (const exception& e) {
+    return Fail(BARCODE_INTERNAL_ERROR, e.what(), error);
+  }
+}
+
+barcode_status barcode_decode_encoded(const barcode_pipeline* pipeline, const uint8_t* data, size_t length,
+                                      char** results_json, char** warnings_json, char** error)
+{
+  if (pipeline == nullptr || data == nullptr || results_json == nullptr) {
+    return Fail(BARCODE_INVALID_ARGUMENT, "Pipeline, data and results_json are required", error);
+  }
+
+  try {
+    string errorMsg;
+    cv::Mat mat = decode_image_buffer(data, length, errorMsg);
+    if (mat.empty()) {
+      return Fail(BARCODE_IMAGE_ERROR, "Failed to decode image buffer: " + errorMsg, error);
+    }
+    return Run(pipeline, mat, results_json, warnings_json, error);
+  } catch (const exception& e) {
+    return Fail(BARCODE_INTERNAL_ERROR, e.what(), error);
+  }
+}
+
+barcode_status barcode_decode_file(const barcode_pipeline* pipeline, const char* path,
+                                   char** results_json, char** warnings_json, char** error)
+{
+  if (pipeline == nullptr || path == nullptr || results_json == nullptr) {
+    return Fail(BARCODE_INVALID_ARGUMENT, "Pipeline, path and results_json are required", error);
+  }
+
+  try {
+    string errorMsg;
+    cv::Mat mat = decode_image_file(path, errorMsg);
+    if (mat.empty()) {
+      return Fail(BARCODE_IMAGE_ERROR, errorMsg, error);
+    }
+    return Run(pipeline, mat, results_json, warnings_json, error);
+  } catch (const exception& e) {
+    return Fail(BARCODE_INTERNAL_ERROR, e.what(), error);
+  }
+}
+
+void barcode_free(char* text)
+{
+  free(text);
+}
+
+}  // extern "C"
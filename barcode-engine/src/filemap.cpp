@@ -0,0 +1,104 @@
+#include "filemap.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+MappedFile::~MappedFile()
+{
+  if (data != nullptr) {
+    munmap(const_cast<unsigned char*>(data), size);
+  }
+}
+
+shared_ptr<const MappedFile> file_map(const string& path, string& errorMsg)
+{
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    errorMsg = "open(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    errorMsg = "fstat(" + path + ") failed: " + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+  if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+    errorMsg = path + " is not a regular, non-empty file";
+    close(fd);
+    return nullptr;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    errorMsg = "mmap(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  // Decoders read the file once, front to back
+  madvise(address, size, MADV_SEQUENTIAL);
+
+  auto file = make_shared<MappedFile>();
+  file->path = path;
+  file->data = static_cast<const unsigned char*>(address);
+  file->size = size;
+  return file;
+}
+
+bool file_read(const string& path, vector<unsigned char>& bytes, string& errorMsg)
+{
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    errorMsg = "open(" + path + ") failed: " + strerror(errno);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    errorMsg = "fstat(" + path + ") failed: " + strerror(errno);
+    close(fd);
+    return false;
+  }
+  if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+    errorMsg = path + " is not a regular, non-empty file";
+    close(fd);
+    return false;
+  }
+
+  // Up to the size seen by fstat; a file cut short meanwhile ends the read early
+  bytes.resize(static_cast<size_t>(st.st_size));
+  size_t done = 0;
+  while (done < bytes.size()) {
+    ssize_t n = pread(fd, bytes.data() + done, bytes.size() - done, static_cast<off_t>(done));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      errorMsg = "read(" + path + ") failed: " + strerror(errno);
+      close(fd);
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+  close(fd);
+
+  bytes.resize(done);
+  if (done == 0) {
+    errorMsg = path + " was truncated while it was read";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only mapping of a whole file, used by the tools to decode large inputs
+// (recorded streams, documents) in place. The file stays mapped while any
+// shared_ptr to it is alive. A file truncated by another process while it is
+// mapped raises SIGBUS on access, so only files nobody rewrites are mapped.
+struct MappedFile {
+  std::string path;
+  const unsigned char* data = nullptr;
+  size_t size = 0;
+  ~MappedFile();
+};
+
+// Map a regular, non-empty file for one sequential read.
+// Returns nullptr and sets errorMsg on failure.
+std::shared_ptr<const MappedFile> file_map(const std::string& path, std::string& errorMsg);
+
+// Read a regular, non-empty file with pread(). Used for files that may be
+// overwritten or truncated while they are decoded (watched folders): a file
+// that shrinks yields a short buffer, which fails to decode, rather than a
+// SIGBUS in the decoder. Returns false and sets errorMsg on failure.
+bool file_read(const std::string& path, std::vector<unsigned char>& bytes, std::string& errorMsg);
@@ -1,15 +1,68 @@
 #include <napi.h>
+#include <cstdint>
 #include <fstream>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <opencv2/opencv.hpp>
 #include "decoder.h"
+#include "shm.h"
+#include "affinity.h"
+#include "pipeline.h"
+#include "metrics.h"
+#include "trace.h"
+#include "record.h"
+#include "pack.h"
+#include "strip.h"
+#include "mjpeg.h"
+#include "jpeg.h"
 
 // Type validation helper functions
 bool IsValidBuffer(const Napi::Value& val) {
   return !val.IsUndefined() && !val.IsNull() && val.IsBuffer();
 }
 
+// Binary data accepted as pixel or encoded input: Buffer, any TypedArray
+// (including views over a SharedArrayBuffer), DataView or ArrayBuffer
+bool IsBinaryData(const Napi::Value& val) {
+  return !val.IsUndefined() && !val.IsNull() &&
+         (val.IsTypedArray() || val.IsDataView() || val.IsArrayBuffer());
+}
+
+// Resolve binary data to its backing bytes without copying (respects byteOffset).
+// The pointer stays valid while the JS value is alive, i.e. for the duration of the call.
+bool GetBinaryData(const Napi::Value& val, const uint8_t*& data, size_t& length) {
+  napi_env env = val.Env();
+  void* raw = nullptr;
+
+  if (val.IsTypedArray()) {
+    napi_typedarray_type type;
+    size_t elementCount = 0;
+    // napi_get_typedarray_info returns the data pointer already adjusted by byteOffset
+    // and, unlike Napi::ArrayBuffer, also works for SharedArrayBuffer backing stores
+    if (napi_get_typedarray_info(env, val, &type, &elementCount, &raw, nullptr, nullptr) != napi_ok) {
+      return false;
+    }
+    data = static_cast<const uint8_t*>(raw);
+    length = val.As<Napi::TypedArray>().ByteLength();
+    return true;
+  }
+  if (val.IsDataView()) {
+    if (napi_get_dataview_info(env, val, &length, &raw, nullptr, nullptr) != napi_ok) {
+      return false;
+    }
+    data = static_cast<const uint8_t*>(raw);
+    return true;
+  }
+  if (val.IsArrayBuffer()) {
+    Napi::ArrayBuffer arrayBuffer = val.As<Napi::ArrayBuffer>();
+    data = static_cast<const uint8_t*>(arrayBuffer.Data());
+    length = arrayBuffer.ByteLength();
+    return true;
+  }
+  return false;
+}
+
 bool IsValidNumber(const Napi::Value& val) {
   return !val.IsUndefined() && !val.IsNull() && val.IsNumber();
 }
@@ -54,8 +107,8 @@ bool IsValidImageObject(const Napi::Object& obj, Napi::Env env, std::string& err
   }
   
   // Now safe to check types
-  if (!IsValidBuffer(dataVal)) {
-    errorMsg = "Property 'data' must be a Buffer";
+  if (!IsBinaryData(dataVal)) {
+    errorMsg = "Property 'data' must be a Buffer, TypedArray, DataView or ArrayBuffer";
     return false;
   }
   if (!IsValidNumber(widthVal)) {
@@ -95,9 +148,121 @@ bool IsValidImageObject(const Napi::Object& obj, Napi::Env env, std::string& err
   return true;
 }
 
+// Frame descriptor pointing into a POSIX shared-memory segment:
+// { shm: name, offset, width, height, stride, colorSpace, seq } for raw pixels, or
+// { shm: name, offset, length } for an encoded image (JPEG, PNG, ...)
+// Raw frames are wrapped in place, no copy is made: pin receives the segment
+// and keeps it mapped while the caller uses the Mat, even if another thread
+// releases it from the cache meanwhile.
+cv::Mat ShmFrameToMat(const Napi::Object& obj, std::string& errorMsg, std::shared_ptr<const ShmSegment>& pin,
+                      StageTimings* timings = nullptr) {
+  if (!IsValidString(obj.Get("shm"))) {
+    errorMsg = "Property 'shm' must be a string";
+    return cv::Mat();
+  }
+
+  std::string name = obj.Get("shm").As<Napi::String>().Utf8Value();
+  int64_t offset = IsValidNumber(obj.Get("offset")) ? obj.Get("offset").As<Napi::Number>().Int64Value() : 0;
+  if (offset < 0) {
+    errorMsg = "Property 'offset' must not be negative";
+    return cv::Mat();
+  }
+
+  // --- Encoded image stored in the segment ---
+  if (!obj.Has("width") && IsValidNumber(obj.Get("length"))) {
+    int64_t length = obj.Get("length").As<Napi::Number>().Int64Value();
+    if (length <= 0 || length > INT32_MAX) {
+      errorMsg = "Property 'length' must be a positive byte count";
+      return cv::Mat();
+    }
+
+    // Unsigned sum, checked: a descriptor must not wrap around the segment size
+    size_t start = static_cast<size_t>(offset);
+    size_t bytes = static_cast<size_t>(length);
+    if (start > SIZE_MAX - bytes) {
+      errorMsg = "Shared memory frame offset and length exceed the address space";
+      return cv::Mat();
+    }
+    std::shared_ptr<const ShmSegment> segment = shm_map(name, start + bytes, errorMsg);
+    if (!segment) {
+      return cv::Mat();
+    }
+    if (start > segment->size || bytes > segment->size - start) {
+      errorMsg = "Shared memory frame lies outside the " + std::to_string(segment->size) + " byte segment";
+      return cv::Mat();
+    }
+    pin = segment;
+
+    cv::Mat mat = decode_image_buffer(segment->data + offset, static_cast<size_t>(length), errorMsg, timings);
+    if (mat.empty()) {
+      errorMsg = "Failed to decode image stored in shared memory: " + errorMsg;
+    }
+    return mat;
+  }
+
+  // --- Raw pixels ---
+  if (!IsValidNumber(obj.Get("width")) || !IsValidNumber(obj.Get("height"))) {
+    errorMsg = "Shared memory frame requires numeric 'width' and 'height' (or 'length' for encoded images)";
+    return cv::Mat();
+  }
+
+  int width = obj.Get("width").As<Napi::Number>().Int32Value();
+  int height = obj.Get("height").As<Napi::Number>().Int32Value();
+
+  const int MAX_IMAGE_DIMENSION = 32768;
+  if (width <= 0 || height <= 0 || width > MAX_IMAGE_DIMENSION || height > MAX_IMAGE_DIMENSION) {
+    errorMsg = "Invalid shared memory frame dimensions (width: " + std::to_string(width) +
+               ", height: " + std::to_string(height) + ")";
+    return cv::Mat();
+  }
+
+  std::string colorSpace = "GRAY";
+  if (obj.Has("colorSpace") && IsValidString(obj.Get("colorSpace"))) {
+    colorSpace = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
+  }
+  int channels = 0;
+  int cvType = CV_8UC1;
+  if (!color_space_type(colorSpace, channels, cvType)) {
+    errorMsg = "Unsupported colorSpace: " + colorSpace + ". Supported values: GRAY, RGB, BGR, RGBA, BGRA";
+    return cv::Mat();
+  }
+
+  size_t rowBytes = static_cast<size_t>(width) * channels;
+  int64_t strideValue = IsValidNumber(obj.Get("stride")) ? obj.Get("stride").As<Napi::Number>().Int64Value()
+                                                          : static_cast<int64_t>(rowBytes);
+  if (strideValue < static_cast<int64_t>(rowBytes)) {
+    errorMsg = "Stride (" + std::to_string(strideValue) + ") is smaller than a row (" + std::to_string(rowBytes) + " bytes)";
+    return cv::Mat();
+  }
+  size_t stride = static_cast<size_t>(strideValue);
+
+  // offset + stride * (height - 1) + rowBytes, rejected before it can wrap
+  size_t start = static_cast<size_t>(offset);
+  if (start > SIZE_MAX - rowBytes ||
+      (height > 1 && stride > (SIZE_MAX - start - rowBytes) / static_cast<size_t>(height - 1))) {
+    errorMsg = "Shared memory frame offset and stride exceed the address space";
+    return cv::Mat();
+  }
+  size_t requiredBytes = start + stride * static_cast<size_t>(height - 1) + rowBytes;
+  std::shared_ptr<const ShmSegment> segment = shm_map(name, requiredBytes, errorMsg);
+  if (!segment) {
+    return cv::Mat();
+  }
+  if (requiredBytes > segment->size) {
+    errorMsg = "Shared memory frame lies outside the " + std::to_string(segment->size) + " byte segment";
+    return cv::Mat();
+  }
+  pin = segment;
+
+  return wrap_pixels(segment->data + offset, width, height, stride, colorSpace, errorMsg, timings);
+}
+
 // Helper function to convert input to cv::Mat (shared by decoder and convertToMat)
 // Returns empty Mat on error, check with mat.empty()
-cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg) {
+// When timings is given, input decoding and colour conversion times are added to it
+// pin holds the mapping of a shared-memory frame: keep it until done with the Mat
+cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg, std::shared_ptr<const ShmSegment>& pin,
+                   StageTimings* timings = nullptr) {
   Napi::Env env = input.Env();
   errorMsg.clear();
 
@@ -108,8 +273,22 @@ cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg) {
   }
 
   // --- 1. Handle raw object input ---
-  if (input.IsObject() && !input.IsBuffer()) {
+  if (input.IsObject() && !IsBinaryData(input)) {
     Napi::Object obj = input.As<Napi::Object>();
+
+    // Shared-memory frame descriptor
+    if (obj.Has("shm")) {
+      return ShmFrameToMat(obj, errorMsg, pin, timings);
+    }
+
+    // Image file on disk: { path }
+    if (obj.Has("path")) {
+      if (!IsValidString(obj.Get("path"))) {
+        errorMsg = "Property 'path' must be a string";
+        return cv::Mat();
+      }
+      return decode_image_file(obj.Get("path").As<Napi::String>().Utf8Value(), errorMsg, timings);
+    }
     
     // Validate the image object structure and types
     if (!IsValidImageObject(obj, env, errorMsg)) {
@@ -117,8 +296,13 @@ cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg) {
       return cv::Mat();
     }
     
-    // Safe casting after validation
-    auto dataBuf = obj.Get("data").As<Napi::Buffer<uint8_t>>();
+    // Safe access after validation
+    const uint8_t* data = nullptr;
+    size_t dataLength = 0;
+    if (!GetBinaryData(obj.Get("data"), data, dataLength)) {
+      errorMsg = "Failed to access image data";
+      return cv::Mat();
+    }
     int width = obj.Get("width").As<Napi::Number>().Int32Value();
     int height = obj.Get("height").As<Napi::Number>().Int32Value();
     
@@ -179,10 +363,10 @@ cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg) {
         return cv::Mat();
       }
       
-      if (dataBuf.Length() != expectedBytes) {
+      if (dataLength != expectedBytes) {
         errorMsg = "Data length mismatch: expected " + std::to_string(expectedBytes) + 
                    " bytes (" + std::to_string(width) + "x" + std::to_string(height) + "x" + 
-                   std::to_string(channels) + "), got " + std::to_string(dataBuf.Length()) + " bytes";
+                   std::to_string(channels) + "), got " + std::to_string(dataLength) + " bytes";
         return cv::Mat();
       }
     }
@@ -221,9 +405,9 @@ cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg) {
         return cv::Mat();
       }
       
-      channels = dataBuf.Length() / pixelCount;
-      if (dataBuf.Length() % pixelCount != 0) {
-        errorMsg = "Cannot infer channels: data.length (" + std::to_string(dataBuf.Length()) + 
+      channels = dataLength / pixelCount;
+      if (dataLength % pixelCount != 0) {
+        errorMsg = "Cannot infer channels: data.length (" + std::to_string(dataLength) + 
                    ") is not divisible by width*height (" + std::to_string(pixelCount) + ")";
         return cv::Mat();
       }
@@ -247,9 +431,10 @@ cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg) {
       }
     }
 
-    // Create a defensive copy of the data to prevent segmentation faults
-    // This ensures the Mat owns its data and won't access deallocated memory
-    cv::Mat mat(height, width, cvType);
+    // Wrap the caller's memory without copying. The input value is held by the
+    // calling frame, so the data outlives every use of the Mat in this call;
+    // anything kept beyond the call must be cloned.
+    cv::Mat mat(height, width, cvType, const_cast<uint8_t*>(data));
     if (mat.empty()) {
       errorMsg = "Failed to create Mat with dimensions " + std::to_string(width) + "x" + std::to_string(height);
       return cv::Mat();
@@ -257,37 +442,27 @@ cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg) {
     
     // Verify the Mat's expected data size matches our buffer
     size_t matDataSize = mat.total() * mat.elemSize();
-    if (matDataSize != dataBuf.Length()) {
+    if (matDataSize != dataLength) {
       errorMsg = "Internal error: Mat data size (" + std::to_string(matDataSize) + 
-                ") doesn't match buffer length (" + std::to_string(dataBuf.Length()) + ")";
+                ") doesn't match buffer length (" + std::to_string(dataLength) + ")";
       return cv::Mat();
     }
-    
-    // Safely copy the data
-    std::memcpy(mat.data, dataBuf.Data(), dataBuf.Length());
-
-    
-    cv::Mat bgrMat;
-    if (colorSpace == "RGB") {
-      cv::cvtColor(mat, bgrMat, cv::COLOR_RGB2BGR);
-      return bgrMat;
-    } else if (colorSpace == "RGBA") {
-      cv::cvtColor(mat, bgrMat, cv::COLOR_RGBA2BGRA);
-      return bgrMat;
-    }
 
-    return mat;
+    // String channel formats leave the colour space open: used as decoded (BGR)
+    return wrap_pixels(data, width, height, mat.step, colorSpace.empty() ? "BGR" : colorSpace, errorMsg, timings);
   }
-  // --- 2. Handle buffer input ---
-  else if (input.IsBuffer()) {
-    auto buf = input.As<Napi::Buffer<uint8_t>>();
-    cv::Mat tmp(1, buf.Length(), CV_8UC1, buf.Data());
-    cv::Mat mat = cv::imdecode(tmp, cv::IMREAD_UNCHANGED);
-
-    if (mat.empty()) {
-      errorMsg = "Failed to decode image buffer";
+  // --- 2. Handle encoded input (Buffer, TypedArray, DataView, ArrayBuffer) ---
+  else if (IsBinaryData(input)) {
+    const uint8_t* data = nullptr;
+    size_t length = 0;
+    if (!GetBinaryData(input, data, length) || length == 0) {
+      errorMsg = "Failed to access encoded image data";
       return cv::Mat();
     }
+    cv::Mat mat = decode_image_buffer(data, length, errorMsg, timings);
+    if (mat.empty()) {
+      errorMsg = "Failed to decode image buffer: " + errorMsg;
+    }
     return mat;
   }
   else {
@@ -296,7 +471,38 @@ cv::Mat InputToMat(const Napi::Value& input, std::string& errorMsg) {
   }
 }
 
-// ZBar decoder - expects grayscale image
+// Decoder options from a JS object, missing fields keep their defaults
+ZBarOptions ReadZBarOptions(const Napi::Object& obj) {
+  ZBarOptions options;
+  if (obj.Has("symbologies") && obj.Get("symbologies").IsString()) {
+    options.symbologies = obj.Get("symbologies").As<Napi::String>().Utf8Value();
+  }
+  if (obj.Has("density") && obj.Get("density").IsNumber()) {
+    options.density = obj.Get("density").As<Napi::Number>().Int32Value();
+  }
+  return options;
+}
+
+ZXingOptions ReadZXingOptions(const Napi::Object& obj) {
+  ZXingOptions options;
+  if (obj.Has("tryHarder") && obj.Get("tryHarder").IsBoolean()) {
+    options.tryHarder = obj.Get("tryHarder").As<Napi::Boolean>().Value();
+  }
+  // tryRotate follows tryHarder unless given, as with the boolean form
+  options.tryRotate = options.tryHarder;
+  if (obj.Has("tryRotate") && obj.Get("tryRotate").IsBoolean()) {
+    options.tryRotate = obj.Get("tryRotate").As<Napi::Boolean>().Value();
+  }
+  if (obj.Has("formats") && obj.Get("formats").IsString()) {
+    options.formats = obj.Get("formats").As<Napi::String>().Utf8Value();
+  }
+  if (obj.Has("binarizer") && obj.Get("binarizer").IsString()) {
+    options.binarizer = obj.Get("binarizer").As<Napi::String>().Utf8Value();
+  }
+  return options;
+}
+
+// ZBar decoder - expects grayscale image, optional options object
 Napi::Value decoder_zbar(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
@@ -313,12 +519,17 @@ Napi::Value decoder_zbar(const Napi::CallbackInfo& info) {
 
   try {
     std::string errorMsg;
-    cv::Mat mat = InputToMat(info[0], errorMsg);
+    std::shared_ptr<const ShmSegment> pin;
+    cv::Mat mat = InputToMat(info[0], errorMsg, pin);
     if (mat.empty()) {
       Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
       return env.Null();
     }
-    std::string result = decode_zbar(mat);
+    ZBarOptions options;
+    if (info.Length() > 1 && info[1].IsObject()) {
+      options = ReadZBarOptions(info[1].As<Napi::Object>());
+    }
+    std::string result = decode_zbar(mat, options);
     return Napi::String::New(env, result);
   } catch (const std::exception& e) {
     Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
@@ -326,12 +537,12 @@ Napi::Value decoder_zbar(const Napi::CallbackInfo& info) {
   }
 }
 
-// ZXing decoder - expects grayscale image with tryHarder option
+// ZXing decoder - expects grayscale image with tryHarder (boolean) or an options object
 Napi::Value decoder_zxing(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
   if (info.Length() < 2) {
-    Napi::TypeError::New(env, "Expected 2 arguments: grayscale image data, tryHarder (boolean)").ThrowAsJavaScriptException();
+    Napi::TypeError::New(env, "Expected 2 arguments: grayscale image data, tryHarder (boolean) or options").ThrowAsJavaScriptException();
     return env.Null();
   }
 
@@ -340,21 +551,23 @@ Napi::Value decoder_zxing(const Napi::CallbackInfo& info) {
     Napi::TypeError::New(env, "First argument must be a Buffer or image object").ThrowAsJavaScriptException();
     return env.Null();
   }
-  if (!info[1].IsBoolean()) {
-    Napi::TypeError::New(env, "Second argument (tryHarder) must be a boolean").ThrowAsJavaScriptException();
+  if (!info[1].IsBoolean() && !info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be a boolean (tryHarder) or an options object").ThrowAsJavaScriptException();
     return env.Null();
   }
 
   try {
     std::string errorMsg;
-    cv::Mat mat = InputToMat(info[0], errorMsg);
+    std::shared_ptr<const ShmSegment> pin;
+    cv::Mat mat = InputToMat(info[0], errorMsg, pin);
     if (mat.empty()) {
       Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
       return env.Null();
     }
 
-    bool tryHarder = info[1].As<Napi::Boolean>().Value();
-    std::string result = decode_zxing(mat, tryHarder);
+    std::string result = info[1].IsBoolean()
+      ? decode_zxing(mat, info[1].As<Napi::Boolean>().Value())
+      : decode_zxing(mat, ReadZXingOptions(info[1].As<Napi::Object>()));
     return Napi::String::New(env, result);
   } catch (const std::exception& e) {
     Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
@@ -362,6 +575,336 @@ Napi::Value decoder_zxing(const Napi::CallbackInfo& info) {
   }
 }
 
+// Block from a JS object { decoder, preprocessing, scale, options }
+BlockConfig ReadBlockConfig(const Napi::Object& obj) {
+  BlockConfig block;
+  if (obj.Has("decoder") && obj.Get("decoder").IsString()) {
+    block.decoder = obj.Get("decoder").As<Napi::String>().Utf8Value();
+  }
+  if (obj.Has("preprocessing") && obj.Get("preprocessing").IsString()) {
+    block.preprocessing = obj.Get("preprocessing").As<Napi::String>().Utf8Value();
+  }
+  if (obj.Has("scale") && obj.Get("scale").IsNumber()) {
+    block.scale = obj.Get("scale").As<Napi::Number>().DoubleValue();
+  }
+  if (obj.Has("options") && obj.Get("options").IsObject()) {
+    Napi::Object options = obj.Get("options").As<Napi::Object>();
+    block.zbar = ReadZBarOptions(options);
+    block.zxing = ReadZXingOptions(options);
+  }
+  return block;
+}
+
+// Native object handed to JS as an External. Every handle of the addon is
+// tagged with its kind, so a handle passed to a function of another feature
+// is rejected instead of being reinterpreted as the wrong type.
+struct NativeHandle {
+  enum Kind { COUNTER, HISTOGRAM, BLOCK, CAPTURE, PACK, MJPEG, STRIP } kind;
+  void* object;
+  void (*destroy)(void*);  // nullptr when the object outlives the handle
+};
+
+template <typename T>
+void DeleteObject(void* object) {
+  delete static_cast<T*>(object);
+}
+
+Napi::Value NewHandle(Napi::Env env, NativeHandle::Kind kind, void* object, void (*destroy)(void*) = nullptr) {
+  return Napi::External<NativeHandle>::New(
+    env, new NativeHandle{kind, object, destroy},
+    [](Napi::Env, NativeHandle* handle) {
+      if (handle->destroy != nullptr) {
+        handle->destroy(handle->object);
+      }
+      delete handle;
+    });
+}
+
+// Object behind a handle of the given kind, or nullptr
+template <typename T>
+T* GetHandle(const Napi::Value& value, NativeHandle::Kind kind) {
+  if (!value.IsExternal()) {
+    return nullptr;
+  }
+  NativeHandle* handle = value.As<Napi::External<NativeHandle>>().Data();
+  return handle != nullptr && handle->kind == kind ? static_cast<T*>(handle->object) : nullptr;
+}
+
+// Labels from a flat JS object { name: value }
+MetricLabels ReadMetricLabels(const Napi::Value& value) {
+  MetricLabels labels;
+  if (!value.IsObject()) {
+    return labels;
+  }
+  Napi::Object obj = value.As<Napi::Object>();
+  Napi::Array keys = obj.GetPropertyNames();
+  for (uint32_t i = 0; i < keys.Length(); i++) {
+    std::string key = keys.Get(i).ToString().Utf8Value();
+    labels.emplace_back(key, obj.Get(key).ToString().Utf8Value());
+  }
+  return labels;
+}
+
+// Whole block (input conversion, scale, preprocessing, decoder) in one call,
+// returns { results: decoder JSON, timings: { ...Ms } }. An optional
+// metricsBlock() handle records the run in the metrics registry, optional
+// { image, block } ids are attached to its trace spans.
+Napi::Value decodeBlock(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 2 || !info[1].IsObject()) {
+    Napi::TypeError::New(env, "Expected 2 arguments: image data and block { decoder, preprocessing, scale, options }").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  if (!info[0].IsObject() && !info[0].IsBuffer()) {
+    Napi::TypeError::New(env, "First argument must be a Buffer or image object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  BlockMetrics* metrics = info.Length() > 2 ? GetHandle<BlockMetrics>(info[2], NativeHandle::BLOCK) : nullptr;
+
+  int64_t traceImage = -1;
+  int traceBlock = -1;
+  if (info.Length() > 3 && info[3].IsObject()) {
+    Napi::Object trace = info[3].As<Napi::Object>();
+    if (trace.Get("image").IsNumber()) {
+      traceImage = trace.Get("image").As<Napi::Number>().Int64Value();
+    }
+    if (trace.Get("block").IsNumber()) {
+      traceBlock = trace.Get("block").As<Napi::Number>().Int32Value();
+    }
+  }
+
+  try {
+    StageTimings timings;
+    double totalMs = 0;
+    std::string results;
+    {
+      TraceScope traceScope(traceImage, traceBlock);
+      ScopedTimer timer(&totalMs, "block");
+      std::string errorMsg;
+      std::shared_ptr<const ShmSegment> pin;
+      cv::Mat mat = InputToMat(info[0], errorMsg, pin, &timings);
+      if (mat.empty()) {
+        Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
+        return env.Null();
+      }
+
+      results = run_block(mat, ReadBlockConfig(info[1].As<Napi::Object>()), timings);
+    }
+
+    if (metrics != nullptr) {
+      record_block_metrics(*metrics, timings, totalMs, results);
+    }
+
+    Napi::Object timingsObj = Napi::Object::New(env);
+    timingsObj.Set("inputDecodeMs", Napi::Number::New(env, timings.inputDecodeMs));
+    timingsObj.Set("colorConversionMs", Napi::Number::New(env, timings.colorConversionMs));
+    timingsObj.Set("scaleMs", Napi::Number::New(env, timings.scaleMs));
+    timingsObj.Set("preprocessMs", Napi::Number::New(env, timings.preprocessMs));
+    timingsObj.Set("decodeMs", Napi::Number::New(env, timings.decodeMs));
+
+    Napi::Object out = Napi::Object::New(env);
+    out.Set("results", Napi::String::New(env, results));
+    out.Set("timings", timingsObj);
+    return out;
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// Handle for the per-stage series of one block: metricsBlock({ node, block, decoder, preprocessing })
+Napi::Value metricsBlock(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "Expected 1 argument: labels object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  // Metric series live for the whole process, only the handle is freed
+  return NewHandle(env, NativeHandle::BLOCK, metrics_block(ReadMetricLabels(info[0])));
+}
+
+// Handle for a counter series: metricsCounter(name, labels)
+Napi::Value metricsCounter(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected arguments: metric name (string), optional labels object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string name = info[0].As<Napi::String>().Utf8Value();
+  MetricLabels labels = info.Length() > 1 ? ReadMetricLabels(info[1]) : MetricLabels();
+  return NewHandle(env, NativeHandle::COUNTER, metrics_counter(name, labels));
+}
+
+// Handle for a latency histogram series (milliseconds): metricsHistogram(name, labels)
+Napi::Value metricsHistogram(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected arguments: metric name (string), optional labels object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string name = info[0].As<Napi::String>().Utf8Value();
+  MetricLabels labels = info.Length() > 1 ? ReadMetricLabels(info[1]) : MetricLabels();
+  return NewHandle(env, NativeHandle::HISTOGRAM, metrics_histogram(name, labels));
+}
+
+// Add to a counter handle: metricsAdd(handle, n = 1)
+Napi::Value metricsAdd(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  MetricCounter* counter = info.Length() > 0 ? GetHandle<MetricCounter>(info[0], NativeHandle::COUNTER) : nullptr;
+  if (counter == nullptr) {
+    Napi::TypeError::New(env, "Expected arguments: counter handle, optional increment (number)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  int64_t n = (info.Length() > 1 && info[1].IsNumber()) ? info[1].As<Napi::Number>().Int64Value() : 1;
+  if (n > 0) {
+    counter->Add(static_cast<uint64_t>(n));
+  }
+  return env.Undefined();
+}
+
+// Record a duration in a histogram handle: metricsObserve(handle, ms)
+Napi::Value metricsObserve(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  MetricHistogram* histogram = info.Length() > 0 ? GetHandle<MetricHistogram>(info[0], NativeHandle::HISTOGRAM) : nullptr;
+  if (histogram == nullptr || info.Length() < 2 || !info[1].IsNumber()) {
+    Napi::TypeError::New(env, "Expected arguments: histogram handle, duration in ms (number)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  histogram->Observe(info[1].As<Napi::Number>().DoubleValue());
+  return env.Undefined();
+}
+
+// Every series of this process:
+// [{ name, type: 'counter', labels, value } | { name, type: 'histogram', labels, count, sumMs, buckets: [{ le, count }] }]
+Napi::Value metricsSnapshot(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  const std::vector<double>& bounds = metrics_bucket_bounds();
+  std::vector<MetricSample> samples = metrics_snapshot();
+
+  Napi::Array list = Napi::Array::New(env, samples.size());
+  for (size_t i = 0; i < samples.size(); i++) {
+    const MetricSample& sample = samples[i];
+
+    Napi::Object labels = Napi::Object::New(env);
+    for (const auto& label : sample.labels) {
+      labels.Set(label.first, label.second);
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("name", sample.name);
+    obj.Set("type", sample.type);
+    obj.Set("labels", labels);
+    if (sample.type == "counter") {
+      obj.Set("value", Napi::Number::New(env, static_cast<double>(sample.value)));
+    } else {
+      obj.Set("count", Napi::Number::New(env, static_cast<double>(sample.count)));
+      obj.Set("sumMs", Napi::Number::New(env, sample.sumMs));
+      Napi::Array buckets = Napi::Array::New(env, bounds.size());
+      for (size_t b = 0; b < bounds.size(); b++) {
+        Napi::Object bucket = Napi::Object::New(env);
+        bucket.Set("le", Napi::Number::New(env, bounds[b]));
+        bucket.Set("count", Napi::Number::New(env, static_cast<double>(sample.cumulative[b])));
+        buckets.Set(static_cast<uint32_t>(b), bucket);
+      }
+      obj.Set("buckets", buckets);
+    }
+    list.Set(static_cast<uint32_t>(i), obj);
+  }
+  return list;
+}
+
+// Enable span tracing: traceStart(capacity = 65536 spans)
+Napi::Value traceStart(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  int64_t capacity = (info.Length() > 0 && info[0].IsNumber()) ? info[0].As<Napi::Number>().Int64Value() : 65536;
+  if (capacity <= 0) {
+    Napi::Error::New(env, "Trace capacity must be positive").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  trace_start(static_cast<size_t>(capacity));
+  return env.Undefined();
+}
+
+Napi::Value traceStop(const Napi::CallbackInfo& info) {
+  trace_stop();
+  return info.Env().Undefined();
+}
+
+Napi::Value traceEnabled(const Napi::CallbackInfo& info) {
+  return Napi::Boolean::New(info.Env(), trace_enabled());
+}
+
+// Current time on the trace clock, in microseconds
+Napi::Value traceNow(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), static_cast<double>(trace_now_us()));
+}
+
+// Record a span measured in JavaScript: traceSpan(name, startUs, endUs, { image, block })
+Napi::Value traceSpan(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber()) {
+    Napi::TypeError::New(env, "Expected arguments: span name (string), start and end (traceNow() microseconds), optional { image, block }").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  if (!trace_enabled()) {
+    return env.Undefined();
+  }
+
+  int64_t image = -1;
+  int block = -1;
+  if (info.Length() > 3 && info[3].IsObject()) {
+    Napi::Object args = info[3].As<Napi::Object>();
+    if (args.Get("image").IsNumber()) {
+      image = args.Get("image").As<Napi::Number>().Int64Value();
+    }
+    if (args.Get("block").IsNumber()) {
+      block = args.Get("block").As<Napi::Number>().Int32Value();
+    }
+  }
+
+  trace_span(trace_intern(info[0].As<Napi::String>().Utf8Value()),
+             static_cast<uint64_t>(info[1].As<Napi::Number>().Int64Value()),
+             static_cast<uint64_t>(info[2].As<Napi::Number>().Int64Value()),
+             image, block);
+  return env.Undefined();
+}
+
+// Name the calling thread in traces
+Napi::Value traceThreadName(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected 1 argument: thread name (string)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  trace_thread_name(info[0].As<Napi::String>().Utf8Value());
+  return env.Undefined();
+}
+
+// Recorded spans of this process, JSON array of Chrome trace events
+Napi::Value traceEvents(const Napi::CallbackInfo& info) {
+  return Napi::String::New(info.Env(), trace_events_json());
+}
+
 // Forward declaration
 Napi::Object MatToRawJS(Napi::Env env, const cv::Mat& m, const std::string& order);
 
@@ -381,7 +924,8 @@ Napi::Value preprocessOriginal(const Napi::CallbackInfo& info) {
 
   try {
     std::string errorMsg;
-    cv::Mat mat = InputToMat(info[0], errorMsg);
+    std::shared_ptr<const ShmSegment> pin;
+    cv::Mat mat = InputToMat(info[0], errorMsg, pin);
     if (mat.empty()) {
       Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
       return env.Null();
@@ -416,7 +960,8 @@ Napi::Value preprocessHistogram(const Napi::CallbackInfo& info) {
 
   try {
     std::string errorMsg;
-    cv::Mat mat = InputToMat(info[0], errorMsg);
+    std::shared_ptr<const ShmSegment> pin;
+    cv::Mat mat = InputToMat(info[0], errorMsg, pin);
     if (mat.empty()) {
       Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
       return env.Null();
@@ -451,7 +996,8 @@ Napi::Value preprocessOtsu(const Napi::CallbackInfo& info) {
 
   try {
     std::string errorMsg;
-    cv::Mat mat = InputToMat(info[0], errorMsg);
+    std::shared_ptr<const ShmSegment> pin;
+    cv::Mat mat = InputToMat(info[0], errorMsg, pin);
     if (mat.empty()) {
       Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
       return env.Null();
@@ -486,9 +1032,12 @@ Napi::Object MatToRawJS(Napi::Env env, const cv::Mat& m, const std::string& orde
   o.Set("colorSpace", Napi::String::New(env, order));
   o.Set("dtype", Napi::String::New(env, "uint8"));
 
-  size_t bytes = m.total() * m.elemSize();
+  // Pack strided images (e.g. shared-memory frames) into contiguous rows
+  cv::Mat packed = m.isContinuous() ? m : m.clone();
+
+  size_t bytes = packed.total() * packed.elemSize();
   auto* raw = new uint8_t[bytes];
-  std::memcpy(raw, m.data, bytes);
+  std::memcpy(raw, packed.data, bytes);
 
   o.Set("data", Napi::Buffer<uint8_t>::New(
     env, raw, bytes,
@@ -498,6 +1047,11 @@ Napi::Object MatToRawJS(Napi::Env env, const cv::Mat& m, const std::string& orde
 
 // Helper function to get color space from input object
 std::string GetColorSpaceFromInput(const Napi::Object& obj, const cv::Mat& mat) {
+  // Encoded shared-memory images and image files are decoded by OpenCV, like Buffer inputs
+  if ((obj.Has("shm") && !obj.Has("width")) || obj.Has("path")) {
+    return mat.channels() == 1 ? "GRAY" : (mat.channels() == 4 ? "BGRA" : "BGR");
+  }
+
   // Priority 1: colorSpace field (new rosepetal format)
   if (obj.Has("colorSpace")) {
     return obj.Get("colorSpace").As<Napi::String>().Utf8Value();
@@ -534,14 +1088,15 @@ Napi::Value convertToMat(const Napi::CallbackInfo& info) {
     std::string channelOrder = "BGR"; // Default for buffers (OpenCV decoded images)
     std::string errorMsg;
     
-    cv::Mat mat = InputToMat(info[0], errorMsg);
+    std::shared_ptr<const ShmSegment> pin;
+    cv::Mat mat = InputToMat(info[0], errorMsg, pin);
     if (mat.empty()) {
       Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
       return env.Null();
     }
     
     // Detect channel order from input if it's a raw object
-    if (info[0].IsObject() && !info[0].IsBuffer()) {
+    if (info[0].IsObject() && !IsBinaryData(info[0])) {
       Napi::Object obj = info[0].As<Napi::Object>();
       channelOrder = GetColorSpaceFromInput(obj, mat);
     } else {
@@ -562,35 +1117,393 @@ Napi::Value convertToMat(const Napi::CallbackInfo& info) {
   }
 }
 
-Napi::Value resizeImage(const Napi::CallbackInfo& info) {
+// Rosepetal bitmap over a decoded image: { data, width, height, colorSpace,
+// dtype }. The Buffer takes over the pixels, no copy is made; mat is released.
+Napi::Object BitmapFromMat(Napi::Env env, cv::Mat& mat) {
+  Napi::Object image = Napi::Object::New(env);
+  image.Set("width", Napi::Number::New(env, mat.cols));
+  image.Set("height", Napi::Number::New(env, mat.rows));
+  image.Set("colorSpace", mat.channels() == 1 ? "GRAY" : (mat.channels() == 4 ? "BGRA" : "BGR"));
+  image.Set("dtype", "uint8");
+
+  auto* hold = new cv::Mat(mat);
+  image.Set("data", Napi::Buffer<uint8_t>::New(
+    env, hold->data, hold->total() * hold->elemSize(),
+    [](Napi::Env, uint8_t*, cv::Mat* m) { delete m; },
+    hold));
+  mat.release();
+  return image;
+}
+
+// Decodes an image file on the libuv thread pool for decodeFile()
+class DecodeFileWorker : public Napi::AsyncWorker {
+public:
+  DecodeFileWorker(Napi::Env env, const std::string& path, int64_t traceImage, int page)
+    : Napi::AsyncWorker(env), path_(path), traceImage_(traceImage), page_(page),
+      deferred_(Napi::Promise::Deferred::New(env)) {}
+
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+  void Execute() override {
+    TraceScope traceScope(traceImage_, -1);
+    std::string errorMsg;
+    mat_ = page_ < 0 ? decode_image_file(path_, errorMsg) : decode_image_file_page(path_, page_, errorMsg);
+    if (mat_.empty()) {
+      SetError(errorMsg.empty() ? "Failed to decode image file " + path_ : errorMsg);
+    }
+  }
+
+  void OnOK() override {
+    deferred_.Resolve(BitmapFromMat(Env(), mat_));
+  }
+
+  void OnError(const Napi::Error& error) override {
+    deferred_.Reject(error.Value());
+  }
+
+private:
+  std::string path_;
+  int64_t traceImage_;
+  int page_;
+  cv::Mat mat_;
+  Napi::Promise::Deferred deferred_;
+};
+
+// Decode an image file off the event loop: decodeFile(path[, traceImage[, page]])
+// resolves to { data, width, height, colorSpace: GRAY|BGR|BGRA, dtype }. The file
+// is mapped and decoded on a libuv worker thread; the pixels are never copied
+// afterwards. With page, only that page of a multi-page file (TIFF) is decoded.
+Napi::Value decodeFile(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
 
-  if (info.Length() < 2) {
-    Napi::TypeError::New(env, "Expected 2 arguments: image data (Buffer or raw image object) and resize percentage").ThrowAsJavaScriptException();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected 1 argument: image file path (string)").ThrowAsJavaScriptException();
     return env.Null();
   }
 
-  // Validate input types
-  if (!info[0].IsObject() && !info[0].IsBuffer()) {
-    Napi::TypeError::New(env, "First argument must be a Buffer or image object").ThrowAsJavaScriptException();
-    return env.Null();
+  int64_t traceImage = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int64Value() : -1;
+  int page = -1;
+  if (info.Length() > 2 && !info[2].IsUndefined()) {
+    if (!info[2].IsNumber() || info[2].As<Napi::Number>().Int32Value() < 0) {
+      Napi::TypeError::New(env, "Page must be a non-negative number").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    page = info[2].As<Napi::Number>().Int32Value();
   }
-  if (!info[1].IsNumber()) {
-    Napi::TypeError::New(env, "Second argument (resize percentage) must be a number").ThrowAsJavaScriptException();
-    return env.Null();
+
+  auto* worker = new DecodeFileWorker(env, info[0].As<Napi::String>().Utf8Value(), traceImage, page);
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+// Decodes an encoded frame to reduced grayscale on the libuv thread pool for decodeFrame()
+class DecodeFrameWorker : public Napi::AsyncWorker {
+public:
+  DecodeFrameWorker(Napi::Env env, Napi::Value dataValue, const uint8_t* data, size_t length, int reduce,
+                    int64_t traceImage)
+    : Napi::AsyncWorker(env), data_(data), length_(length), reduce_(reduce), traceImage_(traceImage),
+      deferred_(Napi::Promise::Deferred::New(env)) {
+    // The encoded bytes stay alive until the worker completes
+    dataRef_ = Napi::Reference<Napi::Value>::New(dataValue, 1);
   }
 
-  try {
-    // Convert input to cv::Mat
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+  void Execute() override {
+    TraceScope traceScope(traceImage_, -1);
     std::string errorMsg;
-    cv::Mat mat = InputToMat(info[0], errorMsg);
-    if (mat.empty()) {
-      Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
-      return env.Null();
+    mat_ = decode_image_reduced(data_, length_, reduce_, errorMsg);
+    if (mat_.empty()) {
+      SetError("Failed to decode frame: " + errorMsg);
     }
-    
-    // Get resize percentage
-    double resizePercentage = info[1].As<Napi::Number>().DoubleValue();
+  }
+
+  void OnOK() override {
+    deferred_.Resolve(BitmapFromMat(Env(), mat_));
+  }
+
+  void OnError(const Napi::Error& error) override {
+    deferred_.Reject(error.Value());
+  }
+
+private:
+  Napi::Reference<Napi::Value> dataRef_;
+  const uint8_t* data_;
+  size_t length_;
+  int reduce_;
+  int64_t traceImage_;
+  cv::Mat mat_;
+  Napi::Promise::Deferred deferred_;
+};
+
+// Decode an encoded image (a camera frame) off the event loop, in grayscale at
+// 1/reduce of its size: decodeFrame(data, reduce = 1[, traceImage]) resolves
+// to a GRAY Rosepetal bitmap. JPEG frames are scaled inside the decoder.
+Napi::Value decodeFrame(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !IsBinaryData(info[0])) {
+    Napi::TypeError::New(env, "Expected arguments: encoded image (binary data)[, reduce[, traceImage]]").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  if (!GetBinaryData(info[0], data, length) || length == 0) {
+    Napi::Error::New(env, "Failed to access encoded image data").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int reduce = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int32Value() : 1;
+  if (reduce != 1 && reduce != 2 && reduce != 4 && reduce != 8) {
+    Napi::RangeError::New(env, "reduce must be 1, 2, 4 or 8").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int64_t traceImage = info.Length() > 2 && info[2].IsNumber() ? info[2].As<Napi::Number>().Int64Value() : -1;
+
+  auto* worker = new DecodeFrameWorker(env, info[0], data, length, reduce, traceImage);
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+// Partial JPEG decode on the libuv thread pool for jpegPrescan() (regions
+// located on a preview) and jpegDecodeRegions() (regions given)
+class JpegRegionsWorker : public Napi::AsyncWorker {
+public:
+  // Above this share of the image, decoding regions costs more than a full decode
+  static constexpr double MAX_COVERAGE = 0.5;
+
+  // With prescan the worker locates the regions on a preview (regions must be
+  // empty), otherwise it decodes the given ones
+  JpegRegionsWorker(Napi::Env env, Napi::Value dataValue, const uint8_t* data, size_t length, bool prescan,
+                    std::vector<cv::Rect> regions, int64_t traceImage)
+    : Napi::AsyncWorker(env), data_(data), length_(length), regions_(std::move(regions)),
+      prescan_(prescan), traceImage_(traceImage), deferred_(Napi::Promise::Deferred::New(env)) {
+    // The encoded bytes stay alive until the worker completes
+    dataRef_ = Napi::Reference<Napi::Value>::New(dataValue, 1);
+  }
+
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+  void Execute() override {
+    TraceScope traceScope(traceImage_, -1);
+    std::string errorMsg;
+    if (prescan_) {
+      // Formats and JPEG variants libjpeg cannot preview in gray take the full path
+      if (!jpeg_prescan(data_, length_, width_, height_, regions_, errorMsg) || regions_.empty()) {
+        return;
+      }
+      // The regions are decoded across the union of their columns
+      if (jpeg_regions_area(regions_) > MAX_COVERAGE * width_ * height_) {
+        return;
+      }
+    }
+
+    if (!jpeg_decode_regions(data_, length_, regions_, width_, height_, crops_, errorMsg) && !prescan_) {
+      SetError(errorMsg);
+    }
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    Napi::Object out = Napi::Object::New(env);
+    out.Set("width", Napi::Number::New(env, width_));
+    out.Set("height", Napi::Number::New(env, height_));
+    if (crops_.empty()) {
+      out.Set("regions", env.Null());
+    } else {
+      Napi::Array regions = Napi::Array::New(env, crops_.size());
+      for (size_t i = 0; i < crops_.size(); i++) {
+        Napi::Object region = Napi::Object::New(env);
+        region.Set("x", Napi::Number::New(env, crops_[i].first.x));
+        region.Set("y", Napi::Number::New(env, crops_[i].first.y));
+        region.Set("width", Napi::Number::New(env, crops_[i].first.width));
+        region.Set("height", Napi::Number::New(env, crops_[i].first.height));
+        region.Set("image", BitmapFromMat(env, crops_[i].second));
+        regions.Set(static_cast<uint32_t>(i), region);
+      }
+      out.Set("regions", regions);
+    }
+    deferred_.Resolve(out);
+  }
+
+  void OnError(const Napi::Error& error) override {
+    deferred_.Reject(error.Value());
+  }
+
+private:
+  Napi::Reference<Napi::Value> dataRef_;
+  const uint8_t* data_;
+  size_t length_;
+  std::vector<cv::Rect> regions_;
+  bool prescan_;
+  int64_t traceImage_;
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<std::pair<cv::Rect, cv::Mat>> crops_;
+  Napi::Promise::Deferred deferred_;
+};
+
+// Pre-scan an encoded JPEG off the event loop: jpegPrescan(data[, traceImage])
+// decodes a 1/8 DC-only preview, locates textured areas and decodes only
+// those at full resolution. Resolves to { width, height, regions: [{ x, y,
+// width, height, image }] } with each image a GRAY bitmap of the region, or
+// regions: null when the image should be decoded whole (not a JPEG, nothing
+// located, or the areas cover more than half of the image).
+Napi::Value jpegPrescan(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !IsBinaryData(info[0])) {
+    Napi::TypeError::New(env, "Expected arguments: encoded image (binary data)[, traceImage]").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  if (!GetBinaryData(info[0], data, length)) {
+    Napi::Error::New(env, "Failed to access encoded image data").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int64_t traceImage = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int64Value() : -1;
+
+  auto* worker = new JpegRegionsWorker(env, info[0], data, length, true, std::vector<cv::Rect>(), traceImage);
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+// Decode given regions of an encoded JPEG off the event loop:
+// jpegDecodeRegions(data, [{ x, y, width, height }][, traceImage]), regions in
+// pixels of the full image. Only the MCU rows and columns covering them are
+// decoded, in grayscale. Resolves like jpegPrescan(), regions clipped to the
+// image and merged where they overlap; rejects
+// when the data is not a JPEG or no region lies inside the image.
+Napi::Value jpegDecodeRegions(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 2 || !IsBinaryData(info[0]) || !info[1].IsArray()) {
+    Napi::TypeError::New(env, "Expected arguments: encoded image (binary data), regions (array)[, traceImage]").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  if (!GetBinaryData(info[0], data, length)) {
+    Napi::Error::New(env, "Failed to access encoded image data").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Array list = info[1].As<Napi::Array>();
+  std::vector<cv::Rect> regions;
+  for (uint32_t i = 0; i < list.Length(); i++) {
+    Napi::Value item = list.Get(i);
+    if (!item.IsObject()) {
+      Napi::TypeError::New(env, "Region " + std::to_string(i) + " must be { x, y, width, height }").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    Napi::Object rect = item.As<Napi::Object>();
+    if (!rect.Get("x").IsNumber() || !rect.Get("y").IsNumber() ||
+        !rect.Get("width").IsNumber() || !rect.Get("height").IsNumber()) {
+      Napi::TypeError::New(env, "Region " + std::to_string(i) + " must be { x, y, width, height }").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    cv::Rect region(rect.Get("x").As<Napi::Number>().Int32Value(), rect.Get("y").As<Napi::Number>().Int32Value(),
+                    rect.Get("width").As<Napi::Number>().Int32Value(), rect.Get("height").As<Napi::Number>().Int32Value());
+    if (region.width <= 0 || region.height <= 0) {
+      Napi::RangeError::New(env, "Region " + std::to_string(i) + " is empty").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    regions.push_back(region);
+  }
+  if (regions.empty()) {
+    Napi::RangeError::New(env, "Expected at least one region").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int64_t traceImage = info.Length() > 2 && info[2].IsNumber() ? info[2].As<Napi::Number>().Int64Value() : -1;
+
+  auto* worker = new JpegRegionsWorker(env, info[0], data, length, false, std::move(regions), traceImage);
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+// Counts the pages of an image file on the libuv thread pool for imagePages()
+class ImagePagesWorker : public Napi::AsyncWorker {
+public:
+  ImagePagesWorker(Napi::Env env, const std::string& path)
+    : Napi::AsyncWorker(env), path_(path), deferred_(Napi::Promise::Deferred::New(env)) {}
+
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+  void Execute() override {
+    std::string errorMsg;
+    pages_ = image_file_pages(path_, errorMsg);
+    if (pages_ == 0) {
+      SetError(errorMsg);
+    }
+  }
+
+  void OnOK() override {
+    deferred_.Resolve(Napi::Number::New(Env(), pages_));
+  }
+
+  void OnError(const Napi::Error& error) override {
+    deferred_.Reject(error.Value());
+  }
+
+private:
+  std::string path_;
+  int pages_ = 0;
+  Napi::Promise::Deferred deferred_;
+};
+
+// Number of pages of an image file: imagePages(path) resolves to the page count
+// of a multi-page TIFF (1 for other formats). Only the page directory is read.
+Napi::Value imagePages(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected 1 argument: image file path (string)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto* worker = new ImagePagesWorker(env, info[0].As<Napi::String>().Utf8Value());
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Value resizeImage(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Expected 2 arguments: image data (Buffer or raw image object) and resize percentage").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  // Validate input types
+  if (!info[0].IsObject() && !info[0].IsBuffer()) {
+    Napi::TypeError::New(env, "First argument must be a Buffer or image object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (!info[1].IsNumber()) {
+    Napi::TypeError::New(env, "Second argument (resize percentage) must be a number").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  try {
+    // Convert input to cv::Mat
+    std::string errorMsg;
+    std::shared_ptr<const ShmSegment> pin;
+    cv::Mat mat = InputToMat(info[0], errorMsg, pin);
+    if (mat.empty()) {
+      Napi::Error::New(env, errorMsg.empty() ? "Failed to convert input to valid image matrix" : errorMsg).ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    
+    // Get resize percentage
+    double resizePercentage = info[1].As<Napi::Number>().DoubleValue();
     
     // Validate percentage range
     if (resizePercentage <= 0 || resizePercentage > 100) {
@@ -602,7 +1515,7 @@ Napi::Value resizeImage(const Napi::CallbackInfo& info) {
     if (resizePercentage >= 100.0) {
       // Detect channel order from input if it's a raw object
       std::string channelOrder = "BGR"; // Default for buffers
-      if (info[0].IsObject() && !info[0].IsBuffer()) {
+      if (info[0].IsObject() && !IsBinaryData(info[0])) {
         Napi::Object obj = info[0].As<Napi::Object>();
         channelOrder = GetColorSpaceFromInput(obj, mat);
       } else {
@@ -625,7 +1538,7 @@ Napi::Value resizeImage(const Napi::CallbackInfo& info) {
     
     // Detect channel order from input to maintain consistency
     std::string channelOrder = "BGR"; // Default for buffers
-    if (info[0].IsObject() && !info[0].IsBuffer()) {
+    if (info[0].IsObject() && !IsBinaryData(info[0])) {
       Napi::Object obj = info[0].As<Napi::Object>();
       channelOrder = GetColorSpaceFromInput(obj, mat);
     } else {
@@ -646,6 +1559,571 @@ Napi::Value resizeImage(const Napi::CallbackInfo& info) {
   }
 }
 
+// Drop the cached mapping of a shared-memory segment
+Napi::Value shmRelease(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected 1 argument: shared memory segment name (string)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  return Napi::Boolean::New(env, shm_release(info[0].As<Napi::String>().Utf8Value()));
+}
+
+// Create a writable shared-memory segment and return it as a Buffer over the mapping
+Napi::Value shmCreate(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+    Napi::TypeError::New(env, "Expected arguments: segment name (string), size in bytes (number), optional NUMA node (number)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string name = info[0].As<Napi::String>().Utf8Value();
+  int64_t size = info[1].As<Napi::Number>().Int64Value();
+  if (size <= 0) {
+    Napi::Error::New(env, "Segment size must be positive").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int numaNode = (info.Length() > 2 && info[2].IsNumber()) ? info[2].As<Napi::Number>().Int32Value() : -1;
+
+  std::string errorMsg;
+  unsigned char* data = shm_create(name, static_cast<size_t>(size), numaNode, errorMsg);
+  if (data == nullptr) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  // The mapping lives as long as the Buffer
+  return Napi::Buffer<uint8_t>::New(
+    env, data, static_cast<size_t>(size),
+    [size](Napi::Env, uint8_t* p) { shm_unmap(p, static_cast<size_t>(size)); });
+}
+
+// Remove a shared-memory segment name
+Napi::Value shmUnlink(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected 1 argument: shared memory segment name (string)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  return Napi::Boolean::New(env, shm_unlink_segment(info[0].As<Napi::String>().Utf8Value()));
+}
+
+// Open a traffic capture file for appending: recordOpen(path, maxBytes = 0)
+Napi::Value recordOpen(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected arguments: capture file path (string), optional size limit in bytes (number)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  int64_t maxBytes = (info.Length() > 1 && info[1].IsNumber()) ? info[1].As<Napi::Number>().Int64Value() : 0;
+  std::string errorMsg;
+  std::unique_ptr<RecordWriter> writer =
+    RecordWriter::Open(info[0].As<Napi::String>().Utf8Value(), static_cast<uint64_t>(std::max<int64_t>(0, maxBytes)), errorMsg);
+  if (!writer) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  // Closed by recordClose() or, at the latest, when the handle is collected
+  return NewHandle(env, NativeHandle::CAPTURE, writer.release(), DeleteObject<RecordWriter>);
+}
+
+// Append a record: recordAppend(handle, 'config' | 'frame', meta (string), data (binary, optional))
+Napi::Value recordAppend(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  RecordWriter* writer = info.Length() > 0 ? GetHandle<RecordWriter>(info[0], NativeHandle::CAPTURE) : nullptr;
+  if (info.Length() < 3 || writer == nullptr || !info[1].IsString() || !info[2].IsString()) {
+    Napi::TypeError::New(env, "Expected arguments: capture handle, record kind ('config' or 'frame'), metadata (string), optional data").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string kindName = info[1].As<Napi::String>().Utf8Value();
+  if (kindName != "config" && kindName != "frame") {
+    Napi::Error::New(env, "Unknown record kind: " + kindName).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  if (info.Length() > 3 && IsBinaryData(info[3]) && !GetBinaryData(info[3], data, length)) {
+    Napi::Error::New(env, "Failed to access record data").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string errorMsg;
+  if (!writer->Append(kindName == "config" ? RECORD_CONFIG : RECORD_FRAME,
+                      info[2].As<Napi::String>().Utf8Value(), data, length, errorMsg)) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Number::New(env, static_cast<double>(writer->committed()));
+}
+
+// Truncate a capture file to its records and close it
+Napi::Value recordClose(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  RecordWriter* writer = info.Length() > 0 ? GetHandle<RecordWriter>(info[0], NativeHandle::CAPTURE) : nullptr;
+  if (writer == nullptr) {
+    Napi::TypeError::New(env, "Expected 1 argument: capture handle").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  double records = static_cast<double>(writer->records());
+  writer->Close();
+  return Napi::Number::New(env, records);
+}
+
+// Records of a capture file: [{ kind, meta (string), data (Buffer over the mapping, or null) }].
+// The file stays mapped while any of the returned Buffers is alive.
+Napi::Value recordRead(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected 1 argument: capture file path (string)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string errorMsg;
+  std::shared_ptr<const RecordFile> file = record_read(info[0].As<Napi::String>().Utf8Value(), errorMsg);
+  if (!file) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Array list = Napi::Array::New(env, file->entries.size());
+  for (size_t i = 0; i < file->entries.size(); i++) {
+    const RecordFile::Entry& entry = file->entries[i];
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("kind", entry.kind == RECORD_CONFIG ? "config" : (entry.kind == RECORD_FRAME ? "frame" : "unknown"));
+    obj.Set("meta", Napi::String::New(env, entry.meta, entry.metaLength));
+    if (entry.dataLength > 0) {
+      obj.Set("data", Napi::Buffer<uint8_t>::New(
+        env, const_cast<uint8_t*>(entry.data), entry.dataLength,
+        [](Napi::Env, uint8_t*, std::shared_ptr<const RecordFile>* hold) { delete hold; },
+        new std::shared_ptr<const RecordFile>(file)));
+    } else {
+      obj.Set("data", env.Null());
+    }
+    list.Set(static_cast<uint32_t>(i), obj);
+  }
+  return list;
+}
+
+// Start a packed corpus file: packCreate(path)
+Napi::Value packCreate(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected 1 argument: pack file path (string)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string errorMsg;
+  std::unique_ptr<PackWriter> writer = PackWriter::Create(info[0].As<Napi::String>().Utf8Value(), errorMsg);
+  if (!writer) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  return NewHandle(env, NativeHandle::PACK, writer.release(), DeleteObject<PackWriter>);
+}
+
+// Append an image to a pack: packAdd(handle, encoded bytes | { data, width, height, colorSpace })
+Napi::Value packAdd(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  PackWriter* writer = info.Length() > 0 ? GetHandle<PackWriter>(info[0], NativeHandle::PACK) : nullptr;
+  if (info.Length() < 2 || writer == nullptr || !info[1].IsObject()) {
+    Napi::TypeError::New(env, "Expected arguments: pack handle, encoded image or raw image object { data, width, height, colorSpace }").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  uint32_t colorSpace = PACK_ENCODED;
+  uint32_t channels = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+
+  if (IsBinaryData(info[1])) {
+    if (!GetBinaryData(info[1], data, length) || length == 0) {
+      Napi::Error::New(env, "Failed to access encoded image data").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+  } else {
+    Napi::Object obj = info[1].As<Napi::Object>();
+    std::string errorMsg;
+    if (!IsValidImageObject(obj, env, errorMsg) || !IsValidString(obj.Get("colorSpace"))) {
+      Napi::Error::New(env, "Invalid raw image: " + (errorMsg.empty() ? std::string("colorSpace is required") : errorMsg)).ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    std::string name = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
+    if (!pack_color_space_from_name(name, colorSpace, channels)) {
+      Napi::Error::New(env, "Unsupported colorSpace: " + name).ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    if (!GetBinaryData(obj.Get("data"), data, length)) {
+      Napi::Error::New(env, "Failed to access image data").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    width = obj.Get("width").As<Napi::Number>().Uint32Value();
+    height = obj.Get("height").As<Napi::Number>().Uint32Value();
+  }
+
+  std::string errorMsg;
+  if (!writer->Add(data, length, colorSpace, width, height, errorMsg)) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Number::New(env, static_cast<double>(writer->count()));
+}
+
+// Write the index and manifest (JSON string) and close the pack: packFinish(handle, manifest)
+Napi::Value packFinish(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  PackWriter* writer = info.Length() > 0 ? GetHandle<PackWriter>(info[0], NativeHandle::PACK) : nullptr;
+  if (info.Length() < 2 || writer == nullptr || !info[1].IsString()) {
+    Napi::TypeError::New(env, "Expected arguments: pack handle, manifest (JSON string)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string errorMsg;
+  if (!writer->Finish(info[1].As<Napi::String>().Utf8Value(), errorMsg)) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Number::New(env, static_cast<double>(writer->count()));
+}
+
+// Images of a pack: { manifest (string), images: [Buffer | { data, width, height, colorSpace, dtype }] }.
+// Every data Buffer points into the mapping, which stays alive while any of them is referenced.
+Napi::Value packRead(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "Expected 1 argument: pack file path (string)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::string errorMsg;
+  std::shared_ptr<const PackFile> file = pack_read(info[0].As<Napi::String>().Utf8Value(), errorMsg);
+  if (!file) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Array images = Napi::Array::New(env, file->entries.size());
+  for (size_t i = 0; i < file->entries.size(); i++) {
+    const PackEntry& entry = file->entries[i];
+    Napi::Buffer<uint8_t> data = Napi::Buffer<uint8_t>::New(
+      env, const_cast<uint8_t*>(file->data(i)), entry.length,
+      [](Napi::Env, uint8_t*, std::shared_ptr<const PackFile>* hold) { delete hold; },
+      new std::shared_ptr<const PackFile>(file));
+
+    if (entry.colorSpace == PACK_ENCODED) {
+      images.Set(static_cast<uint32_t>(i), data);
+    } else {
+      Napi::Object image = Napi::Object::New(env);
+      image.Set("data", data);
+      image.Set("width", Napi::Number::New(env, entry.width));
+      image.Set("height", Napi::Number::New(env, entry.height));
+      image.Set("colorSpace", pack_color_space_name(entry.colorSpace));
+      image.Set("dtype", "uint8");
+      images.Set(static_cast<uint32_t>(i), image);
+    }
+  }
+
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("manifest", Napi::String::New(env, file->manifest));
+  out.Set("images", images);
+  return out;
+}
+
+// Open an MJPEG demuxer: mjpegOpen([maxFrameBytes = 32 MB]). Frames larger
+// than maxFrameBytes are discarded.
+Napi::Value mjpegOpen(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  double maxFrameBytes = 32.0 * 1024 * 1024;
+  if (info.Length() > 0 && !info[0].IsUndefined()) {
+    if (!IsValidNumber(info[0]) || info[0].As<Napi::Number>().DoubleValue() < 1) {
+      Napi::TypeError::New(env, "maxFrameBytes must be a positive number").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    maxFrameBytes = info[0].As<Napi::Number>().DoubleValue();
+  }
+
+  return NewHandle(env, NativeHandle::MJPEG, new MjpegDemuxer(static_cast<size_t>(maxFrameBytes)),
+                   DeleteObject<MjpegDemuxer>);
+}
+
+// Push a chunk of an MJPEG stream: mjpegPush(handle, chunk) returns the JPEG
+// frames the chunk completes, in order. A frame that lies inside a Buffer or
+// TypedArray chunk is a view of it (chunk.subarray(), no copy); a frame that
+// spans chunks is a new Buffer. Runs on the calling thread: the scan only
+// looks for markers, it decodes nothing.
+Napi::Value mjpegPush(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  MjpegDemuxer* demuxer = info.Length() > 0 ? GetHandle<MjpegDemuxer>(info[0], NativeHandle::MJPEG) : nullptr;
+  if (info.Length() < 2 || demuxer == nullptr || !IsBinaryData(info[1])) {
+    Napi::TypeError::New(env, "Expected arguments: demuxer handle, chunk (binary data)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  if (!GetBinaryData(info[1], data, length)) {
+    Napi::Error::New(env, "Failed to access chunk data").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  std::vector<MjpegDemuxer::Frame> frames;
+  demuxer->Push(data, length, frames);
+
+  Napi::Array out = Napi::Array::New(env, frames.size());
+  Napi::Function subarray = info[1].IsTypedArray()
+    ? info[1].As<Napi::Object>().Get("subarray").As<Napi::Function>()
+    : Napi::Function();
+  for (size_t i = 0; i < frames.size(); i++) {
+    MjpegDemuxer::Frame& frame = frames[i];
+    Napi::Value value;
+    if (!frame.data.empty()) {
+      auto* hold = new std::vector<uint8_t>(std::move(frame.data));
+      value = Napi::Buffer<uint8_t>::New(
+        env, hold->data(), hold->size(),
+        [](Napi::Env, uint8_t*, std::vector<uint8_t>* v) { delete v; },
+        hold);
+    } else if (!subarray.IsEmpty()) {
+      value = subarray.Call(info[1], {
+        Napi::Number::New(env, static_cast<double>(frame.offset)),
+        Napi::Number::New(env, static_cast<double>(frame.offset + frame.length))
+      });
+    } else {
+      value = Napi::Buffer<uint8_t>::Copy(env, data + frame.offset, frame.length);
+    }
+    out.Set(static_cast<uint32_t>(i), value);
+  }
+  return out;
+}
+
+// Frames discarded by a demuxer as malformed or too large: mjpegDiscarded(handle)
+Napi::Value mjpegDiscarded(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  MjpegDemuxer* demuxer = info.Length() > 0 ? GetHandle<MjpegDemuxer>(info[0], NativeHandle::MJPEG) : nullptr;
+  if (demuxer == nullptr) {
+    Napi::TypeError::New(env, "Expected 1 argument: demuxer handle").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Number::New(env, static_cast<double>(demuxer->discarded()));
+}
+
+// Strip scan behind a stripOpen() handle; appends run one at a time
+struct StripHandle {
+  std::mutex mutex;
+  std::unique_ptr<StripScanner> scanner;
+};
+
+// Open a streaming scan of a line-scan image:
+// stripOpen(config (JSON { blocks, executionMode }), { width, colorSpace = "GRAY", symbolRows })
+Napi::Value stripOpen(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject()) {
+    Napi::TypeError::New(env, "Expected arguments: configuration (JSON string), { width, colorSpace, symbolRows }").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Object options = info[1].As<Napi::Object>();
+  if (!IsValidNumber(options.Get("width")) || !IsValidNumber(options.Get("symbolRows"))) {
+    Napi::TypeError::New(env, "width and symbolRows must be numbers").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  std::string colorSpace = IsValidString(options.Get("colorSpace"))
+    ? options.Get("colorSpace").As<Napi::String>().Utf8Value()
+    : "GRAY";
+
+  PipelineConfig config;
+  std::string errorMsg;
+  if (!read_pipeline_config(info[0].As<Napi::String>().Utf8Value(), config, errorMsg)) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto handle = std::make_unique<StripHandle>();
+  handle->scanner = StripScanner::Create(config,
+                                         options.Get("width").As<Napi::Number>().Int32Value(),
+                                         colorSpace,
+                                         options.Get("symbolRows").As<Napi::Number>().Int32Value(),
+                                         errorMsg);
+  if (!handle->scanner) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  // The window is freed when the handle is collected
+  return NewHandle(env, NativeHandle::STRIP, handle.release(), DeleteObject<StripHandle>);
+}
+
+// Appends a strip (or finishes the scan) on the libuv thread pool
+class StripWorker : public Napi::AsyncWorker {
+public:
+  // data == nullptr finishes the scan
+  StripWorker(Napi::Env env, StripHandle* handle, Napi::Value handleValue, const uint8_t* data, int rows,
+              Napi::Value dataValue)
+    : Napi::AsyncWorker(env), handle_(handle), data_(data), rows_(rows),
+      deferred_(Napi::Promise::Deferred::New(env)) {
+    // The handle and the strip stay alive until the worker completes
+    handleRef_ = Napi::Reference<Napi::Value>::New(handleValue, 1);
+    if (data != nullptr) {
+      dataRef_ = Napi::Reference<Napi::Value>::New(dataValue, 1);
+    }
+  }
+
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+  void Execute() override {
+    std::lock_guard<std::mutex> lock(handle_->mutex);
+    std::string errorMsg;
+    if (data_ == nullptr) {
+      handle_->scanner->Finish(results_, warnings_);
+    } else if (!handle_->scanner->Append(data_, rows_, 0, results_, warnings_, errorMsg)) {
+      SetError(errorMsg);
+    }
+    rows_ = static_cast<int64_t>(handle_->scanner->rows());
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    Napi::Array warnings = Napi::Array::New(env, warnings_.size());
+    for (size_t i = 0; i < warnings_.size(); i++) {
+      warnings.Set(static_cast<uint32_t>(i), Napi::String::New(env, warnings_[i]));
+    }
+    Napi::Object out = Napi::Object::New(env);
+    out.Set("results", Napi::String::New(env, results_));
+    out.Set("warnings", warnings);
+    out.Set("rows", Napi::Number::New(env, static_cast<double>(rows_)));
+    deferred_.Resolve(out);
+  }
+
+  void OnError(const Napi::Error& error) override {
+    deferred_.Reject(error.Value());
+  }
+
+private:
+  StripHandle* handle_;
+  const uint8_t* data_;
+  int64_t rows_;
+  Napi::Reference<Napi::Value> handleRef_;
+  Napi::Reference<Napi::Value> dataRef_;
+  std::string results_;
+  std::vector<std::string> warnings_;
+  Napi::Promise::Deferred deferred_;
+};
+
+// Append packed rows to a strip scan: stripAppend(handle, data) resolves to
+// { results (JSON array of the symbols completed by these rows, in pixels,
+// y counted from the start of the scan), warnings, rows }. Appends of one scan
+// must not overlap: await each before sending the next.
+Napi::Value stripAppend(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  StripHandle* handle = info.Length() > 0 ? GetHandle<StripHandle>(info[0], NativeHandle::STRIP) : nullptr;
+  if (info.Length() < 2 || handle == nullptr || !IsBinaryData(info[1])) {
+    Napi::TypeError::New(env, "Expected arguments: strip handle, rows (binary data)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  if (!GetBinaryData(info[1], data, length)) {
+    Napi::Error::New(env, "Failed to access strip data").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  size_t rowBytes = handle->scanner->rowBytes();
+  if (length == 0 || length % rowBytes != 0 || length / rowBytes > INT32_MAX) {
+    Napi::Error::New(env, "Strip of " + std::to_string(length) + " bytes is not a whole number of " +
+                     std::to_string(rowBytes) + "-byte rows").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto* worker = new StripWorker(env, handle, info[0], data, static_cast<int>(length / rowBytes), info[1]);
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+// Decode the rows no complete window has covered and end the scan:
+// stripFinish(handle) resolves like stripAppend()
+Napi::Value stripFinish(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  StripHandle* handle = info.Length() > 0 ? GetHandle<StripHandle>(info[0], NativeHandle::STRIP) : nullptr;
+  if (handle == nullptr) {
+    Napi::TypeError::New(env, "Expected 1 argument: strip handle").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto* worker = new StripWorker(env, handle, info[0], nullptr, 0, env.Undefined());
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+// Pin the calling thread ("thread", default) or the whole process ("process") to a list of CPUs
+Napi::Value setAffinity(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    Napi::TypeError::New(env, "Expected arguments: CPU list (array of numbers), optional scope ('thread' or 'process')").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Array list = info[0].As<Napi::Array>();
+  std::vector<int> cpus;
+  for (uint32_t i = 0; i < list.Length(); i++) {
+    Napi::Value cpu = list.Get(i);
+    if (!cpu.IsNumber()) {
+      Napi::TypeError::New(env, "CPU list must contain only numbers").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    cpus.push_back(cpu.As<Napi::Number>().Int32Value());
+  }
+
+  std::string scope = (info.Length() > 1 && info[1].IsString()) ? info[1].As<Napi::String>().Utf8Value() : "thread";
+  std::string errorMsg;
+  bool ok = scope == "process" ? set_process_affinity(cpus, errorMsg) : set_thread_affinity(cpus, errorMsg);
+  if (!ok) {
+    Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Boolean::New(env, true);
+}
+
+// CPUs the calling thread may run on
+Napi::Value getAffinity(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::vector<int> cpus = get_thread_affinity();
+
+  Napi::Array list = Napi::Array::New(env, cpus.size());
+  for (size_t i = 0; i < cpus.size(); i++) {
+    list.Set(static_cast<uint32_t>(i), Napi::Number::New(env, cpus[i]));
+  }
+  return list;
+}
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
   // Decoder primitives
   exports.Set(
@@ -656,6 +2134,18 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     Napi::String::New(env, "decode_zxing"),
     Napi::Function::New(env, decoder_zxing)
   );
+  exports.Set(
+    Napi::String::New(env, "decode_block"),
+    Napi::Function::New(env, decodeBlock)
+  );
+  exports.Set(
+    Napi::String::New(env, "decodeFile"),
+    Napi::Function::New(env, decodeFile)
+  );
+  exports.Set(
+    Napi::String::New(env, "imagePages"),
+    Napi::Function::New(env, imagePages)
+  );
 
   // Preprocessing primitives
   exports.Set(
@@ -681,6 +2171,164 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     Napi::Function::New(env, convertToMat)
   );
 
+  // Shared-memory input
+  exports.Set(
+    Napi::String::New(env, "shmRelease"),
+    Napi::Function::New(env, shmRelease)
+  );
+  exports.Set(
+    Napi::String::New(env, "shmCreate"),
+    Napi::Function::New(env, shmCreate)
+  );
+  exports.Set(
+    Napi::String::New(env, "shmUnlink"),
+    Napi::Function::New(env, shmUnlink)
+  );
+
+  // Traffic capture
+  exports.Set(
+    Napi::String::New(env, "recordOpen"),
+    Napi::Function::New(env, recordOpen)
+  );
+  exports.Set(
+    Napi::String::New(env, "recordAppend"),
+    Napi::Function::New(env, recordAppend)
+  );
+  exports.Set(
+    Napi::String::New(env, "recordClose"),
+    Napi::Function::New(env, recordClose)
+  );
+  exports.Set(
+    Napi::String::New(env, "recordRead"),
+    Napi::Function::New(env, recordRead)
+  );
+
+  // Packed corpus
+  exports.Set(
+    Napi::String::New(env, "packCreate"),
+    Napi::Function::New(env, packCreate)
+  );
+  exports.Set(
+    Napi::String::New(env, "packAdd"),
+    Napi::Function::New(env, packAdd)
+  );
+  exports.Set(
+    Napi::String::New(env, "packFinish"),
+    Napi::Function::New(env, packFinish)
+  );
+  exports.Set(
+    Napi::String::New(env, "packRead"),
+    Napi::Function::New(env, packRead)
+  );
+
+  // Partial JPEG decoding
+  exports.Set(
+    Napi::String::New(env, "jpegPrescan"),
+    Napi::Function::New(env, jpegPrescan)
+  );
+  exports.Set(
+    Napi::String::New(env, "jpegDecodeRegions"),
+    Napi::Function::New(env, jpegDecodeRegions)
+  );
+
+  // MJPEG streams
+  exports.Set(
+    Napi::String::New(env, "mjpegOpen"),
+    Napi::Function::New(env, mjpegOpen)
+  );
+  exports.Set(
+    Napi::String::New(env, "mjpegPush"),
+    Napi::Function::New(env, mjpegPush)
+  );
+  exports.Set(
+    Napi::String::New(env, "mjpegDiscarded"),
+    Napi::Function::New(env, mjpegDiscarded)
+  );
+  exports.Set(
+    Napi::String::New(env, "decodeFrame"),
+    Napi::Function::New(env, decodeFrame)
+  );
+
+  // Streaming strip scan
+  exports.Set(
+    Napi::String::New(env, "stripOpen"),
+    Napi::Function::New(env, stripOpen)
+  );
+  exports.Set(
+    Napi::String::New(env, "stripAppend"),
+    Napi::Function::New(env, stripAppend)
+  );
+  exports.Set(
+    Napi::String::New(env, "stripFinish"),
+    Napi::Function::New(env, stripFinish)
+  );
+
+  // CPU affinity
+  exports.Set(
+    Napi::String::New(env, "setAffinity"),
+    Napi::Function::New(env, setAffinity)
+  );
+  exports.Set(
+    Napi::String::New(env, "getAffinity"),
+    Napi::Function::New(env, getAffinity)
+  );
+
+  // Metrics registry
+  exports.Set(
+    Napi::String::New(env, "metricsBlock"),
+    Napi::Function::New(env, metricsBlock)
+  );
+  exports.Set(
+    Napi::String::New(env, "metricsCounter"),
+    Napi::Function::New(env, metricsCounter)
+  );
+  exports.Set(
+    Napi::String::New(env, "metricsHistogram"),
+    Napi::Function::New(env, metricsHistogram)
+  );
+  exports.Set(
+    Napi::String::New(env, "metricsAdd"),
+    Napi::Function::New(env, metricsAdd)
+  );
+  exports.Set(
+    Napi::String::New(env, "metricsObserve"),
+    Napi::Function::New(env, metricsObserve)
+  );
+  exports.Set(
+    Napi::String::New(env, "metricsSnapshot"),
+    Napi::Function::New(env, metricsSnapshot)
+  );
+
+  // Span tracing
+  exports.Set(
+    Napi::String::New(env, "traceStart"),
+    Napi::Function::New(env, traceStart)
+  );
+  exports.Set(
+    Napi::String::New(env, "traceStop"),
+    Napi::Function::New(env, traceStop)
+  );
+  exports.Set(
+    Napi::String::New(env, "traceEnabled"),
+    Napi::Function::New(env, traceEnabled)
+  );
+  exports.Set(
+    Napi::String::New(env, "traceNow"),
+    Napi::Function::New(env, traceNow)
+  );
+  exports.Set(
+    Napi::String::New(env, "traceSpan"),
+    Napi::Function::New(env, traceSpan)
+  );
+  exports.Set(
+    Napi::String::New(env, "traceThreadName"),
+    Napi::Function::New(env, traceThreadName)
+  );
+  exports.Set(
+    Napi::String::New(env, "traceEvents"),
+    Napi::Function::New(env, traceEvents)
+  );
+
   return exports;
 }
 
@@ -0,0 +1,407 @@
+#include "jpeg.h"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <opencv2/imgproc.hpp>
+
+#include <jpeglib.h>
+
+using namespace std;
+
+// Preview scale: 1/8, the DC coefficients
+static const int PREVIEW_SCALE = 8;
+
+// Gradient level below which the preview is considered flat
+static const double MIN_TEXTURE = 24;
+
+// Smallest area kept, in preview pixels (a 16 x 16 pixel symbol)
+static const int MIN_REGION_AREA = 4;
+
+// Quiet zone added around a located area, in image pixels
+static const int REGION_MARGIN = 24;
+
+namespace {
+
+// libjpeg reports fatal errors through error_exit, which must not return:
+// it jumps back to the setjmp() of the running phase
+struct ErrorManager {
+  jpeg_error_mgr pub;
+  jmp_buf jump;
+  char message[JMSG_LENGTH_MAX];
+};
+
+void ErrorExit(j_common_ptr cinfo)
+{
+  ErrorManager* err = reinterpret_cast<ErrorManager*>(cinfo->err);
+  (*cinfo->err->format_message)(cinfo, err->message);
+  longjmp(err->jump, 1);
+}
+
+// Corrupt-data warnings are not printed to stderr
+void SilentMessage(j_common_ptr) {}
+
+// Decompressor over an in-memory JPEG, destroyed with the object. The setjmp
+// phases below only touch POD state, so a jump never skips a destructor.
+struct Decompressor {
+  jpeg_decompress_struct cinfo;
+  ErrorManager err;
+
+  Decompressor()
+  {
+    cinfo.err = jpeg_std_error(&err.pub);
+    err.pub.error_exit = ErrorExit;
+    err.pub.output_message = SilentMessage;
+    err.message[0] = '\0';
+    jpeg_create_decompress(&cinfo);
+  }
+  ~Decompressor() { jpeg_destroy_decompress(&cinfo); }
+
+  Decompressor(const Decompressor&) = delete;
+  Decompressor& operator=(const Decompressor&) = delete;
+};
+
+// Read the header only
+bool ReadHeader(Decompressor& d, const uint8_t* data, size_t length)
+{
+  if (setjmp(d.err.jump)) {
+    return false;
+  }
+  jpeg_mem_src(&d.cinfo, const_cast<unsigned char*>(data), static_cast<unsigned long>(length));
+  jpeg_read_header(&d.cinfo, TRUE);
+  return true;
+}
+
+// Read the header and start a grayscale decompression at 1/scale
+bool Start(Decompressor& d, const uint8_t* data, size_t length, int scale)
+{
+  if (setjmp(d.err.jump)) {
+    return false;
+  }
+  jpeg_mem_src(&d.cinfo, const_cast<unsigned char*>(data), static_cast<unsigned long>(length));
+  jpeg_read_header(&d.cinfo, TRUE);
+  d.cinfo.out_color_space = JCS_GRAYSCALE;
+  d.cinfo.scale_num = 1;
+  d.cinfo.scale_denom = scale;
+  d.cinfo.do_fancy_upsampling = FALSE;
+  d.cinfo.do_block_smoothing = FALSE;
+  jpeg_start_decompress(&d.cinfo);
+  return true;
+}
+
+// Restrict the output to columns [xoffset, xoffset + columns), widened in
+// place to iMCU boundaries
+bool Crop(Decompressor& d, JDIMENSION& xoffset, JDIMENSION& columns)
+{
+  if (setjmp(d.err.jump)) {
+    return false;
+  }
+  jpeg_crop_scanline(&d.cinfo, &xoffset, &columns);
+  return true;
+}
+
+// Skip `skip` rows, then read `rows` rows into out (one byte per pixel)
+bool ReadRows(Decompressor& d, JDIMENSION skip, JDIMENSION rows, uint8_t* out, size_t step)
+{
+  if (setjmp(d.err.jump)) {
+    return false;
+  }
+  if (skip > 0 && jpeg_skip_scanlines(&d.cinfo, skip) != skip) {
+    return false;
+  }
+  for (JDIMENSION row = 0; row < rows;) {
+    JSAMPROW line = out + row * step;
+    if (jpeg_read_scanlines(&d.cinfo, &line, 1) != 1) {
+      return false;
+    }
+    row++;
+  }
+  // The rows below are never decoded
+  jpeg_abort_decompress(&d.cinfo);
+  return true;
+}
+
+// Read the rows covered by `regions` (sorted by top) in one pass: rows between
+// them are skipped and decoding stops below the lowest, so the entropy-coded
+// data is walked once. Each row read holds the output columns from image
+// column xoffset and is copied into every region it crosses.
+bool ReadRegionRows(Decompressor& d, const vector<cv::Rect>& regions, vector<cv::Mat>& out, JDIMENSION xoffset,
+                    uint8_t* line)
+{
+  if (setjmp(d.err.jump)) {
+    return false;
+  }
+  JDIMENSION bottom = 0;
+  for (const cv::Rect& region : regions) {
+    bottom = max(bottom, static_cast<JDIMENSION>(region.y + region.height));
+  }
+  for (JDIMENSION row = 0; row < bottom;) {
+    bool covered = false;
+    JDIMENSION nextTop = bottom;
+    for (const cv::Rect& region : regions) {
+      JDIMENSION top = static_cast<JDIMENSION>(region.y);
+      if (top <= row && row < top + static_cast<JDIMENSION>(region.height)) {
+        covered = true;
+      } else if (top > row) {
+        nextTop = min(nextTop, top);
+      }
+    }
+    if (!covered) {
+      JDIMENSION skip = nextTop - row;
+      if (jpeg_skip_scanlines(&d.cinfo, skip) != skip) {
+        return false;
+      }
+      row = nextTop;
+      continue;
+    }
+
+    JSAMPROW samples = line;
+    if (jpeg_read_scanlines(&d.cinfo, &samples, 1) != 1) {
+      return false;
+    }
+    for (size_t i = 0; i < regions.size(); i++) {
+      const cv::Rect& region = regions[i];
+      if (static_cast<JDIMENSION>(region.y) <= row && row < static_cast<JDIMENSION>(region.y + region.height)) {
+        memcpy(out[i].ptr(static_cast<int>(row) - region.y), line + (region.x - static_cast<int>(xoffset)),
+               static_cast<size_t>(region.width));
+      }
+    }
+    row++;
+  }
+  // The rows below are never decoded
+  jpeg_abort_decompress(&d.cinfo);
+  return true;
+}
+
+string Failure(const Decompressor& d, const char* what)
+{
+  return string(what) + ": " + (d.err.message[0] != '\0' ? d.err.message : "truncated or corrupt JPEG data");
+}
+
+// Merge overlapping areas until none overlap, so no symbol is split, and
+// order them top to bottom
+void MergeRegions(vector<cv::Rect>& regions)
+{
+  for (bool merged = true; merged;) {
+    merged = false;
+    for (size_t i = 0; i < regions.size() && !merged; i++) {
+      for (size_t j = i + 1; j < regions.size(); j++) {
+        if ((regions[i] & regions[j]).area() > 0) {
+          regions[i] |= regions[j];
+          regions.erase(regions.begin() + static_cast<long>(j));
+          merged = true;
+          break;
+        }
+      }
+    }
+  }
+  sort(regions.begin(), regions.end(), [](const cv::Rect& a, const cv::Rect& b) { return a.y < b.y; });
+}
+
+}  // namespace
+
+bool is_jpeg(const uint8_t* data, size_t length)
+{
+  return length >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+cv::Mat jpeg_decode_preview(const uint8_t* data, size_t length, int& width, int& height, string& errorMsg)
+{
+  if (!is_jpeg(data, length)) {
+    errorMsg = "not a JPEG image";
+    return cv::Mat();
+  }
+
+  Decompressor d;
+  if (!Start(d, data, length, PREVIEW_SCALE)) {
+    errorMsg = Failure(d, "JPEG preview failed");
+    return cv::Mat();
+  }
+  width = static_cast<int>(d.cinfo.image_width);
+  height = static_cast<int>(d.cinfo.image_height);
+
+  cv::Mat preview(static_cast<int>(d.cinfo.output_height), static_cast<int>(d.cinfo.output_width), CV_8UC1);
+  if (!ReadRows(d, 0, d.cinfo.output_height, preview.data, preview.step)) {
+    errorMsg = Failure(d, "JPEG preview failed");
+    return cv::Mat();
+  }
+  return preview;
+}
+
+cv::Mat jpeg_decode_region(const uint8_t* data, size_t length, const cv::Rect& region, cv::Rect& decoded,
+                           string& errorMsg)
+{
+  if (!is_jpeg(data, length)) {
+    errorMsg = "not a JPEG image";
+    return cv::Mat();
+  }
+
+  Decompressor d;
+  if (!Start(d, data, length, 1)) {
+    errorMsg = Failure(d, "JPEG region decode failed");
+    return cv::Mat();
+  }
+  cv::Rect image(0, 0, static_cast<int>(d.cinfo.output_width), static_cast<int>(d.cinfo.output_height));
+  cv::Rect inside = region & image;
+  if (inside.empty()) {
+    errorMsg = "Region " + to_string(region.x) + "," + to_string(region.y) + " " + to_string(region.width) + "x" +
+               to_string(region.height) + " lies outside the " + to_string(image.width) + "x" +
+               to_string(image.height) + " image";
+    return cv::Mat();
+  }
+  JDIMENSION xoffset = static_cast<JDIMENSION>(inside.x);
+  JDIMENSION columns = static_cast<JDIMENSION>(inside.width);
+  if (!Crop(d, xoffset, columns)) {
+    errorMsg = Failure(d, "JPEG region decode failed");
+    return cv::Mat();
+  }
+
+  decoded = cv::Rect(static_cast<int>(xoffset), inside.y, static_cast<int>(columns), inside.height);
+  cv::Mat out(decoded.height, decoded.width, CV_8UC1);
+  if (!ReadRows(d, static_cast<JDIMENSION>(inside.y), static_cast<JDIMENSION>(inside.height), out.data, out.step)) {
+    errorMsg = Failure(d, "JPEG region decode failed");
+    return cv::Mat();
+  }
+  return out;
+}
+
+bool jpeg_decode_regions(const uint8_t* data, size_t length, vector<cv::Rect> regions, int& width, int& height,
+                         vector<pair<cv::Rect, cv::Mat>>& crops, string& errorMsg)
+{
+  if (!is_jpeg(data, length)) {
+    errorMsg = "not a JPEG image";
+    return false;
+  }
+
+  Decompressor d;
+  if (!Start(d, data, length, 1)) {
+    errorMsg = Failure(d, "JPEG region decode failed");
+    return false;
+  }
+  width = static_cast<int>(d.cinfo.output_width);
+  height = static_cast<int>(d.cinfo.output_height);
+
+  cv::Rect image(0, 0, width, height);
+  vector<cv::Rect> inside;
+  for (const cv::Rect& region : regions) {
+    cv::Rect clipped = region & image;
+    if (!clipped.empty()) {
+      inside.push_back(clipped);
+    }
+  }
+  if (inside.empty()) {
+    errorMsg = "No region lies inside the " + to_string(width) + "x" + to_string(height) + " image";
+    return false;
+  }
+  MergeRegions(inside);
+
+  // One decompression for all regions, cropped to the union of their columns
+  int left = width;
+  int right = 0;
+  for (const cv::Rect& region : inside) {
+    left = min(left, region.x);
+    right = max(right, region.x + region.width);
+  }
+  JDIMENSION xoffset = static_cast<JDIMENSION>(left);
+  JDIMENSION columns = static_cast<JDIMENSION>(right - left);
+  if (!Crop(d, xoffset, columns)) {
+    errorMsg = Failure(d, "JPEG region decode failed");
+    return false;
+  }
+
+  vector<cv::Mat> out;
+  for (const cv::Rect& region : inside) {
+    out.emplace_back(region.height, region.width, CV_8UC1);
+  }
+  vector<uint8_t> line(columns);
+  if (!ReadRegionRows(d, inside, out, xoffset, line.data())) {
+    errorMsg = Failure(d, "JPEG region decode failed");
+    return false;
+  }
+
+  crops.clear();
+  for (size_t i = 0; i < inside.size(); i++) {
+    crops.emplace_back(inside[i], out[i]);
+  }
+  return true;
+}
+
+int64_t jpeg_regions_area(const vector<cv::Rect>& regions)
+{
+  if (regions.empty()) {
+    return 0;
+  }
+  int left = regions[0].x;
+  int right = regions[0].x + regions[0].width;
+  for (const cv::Rect& region : regions) {
+    left = min(left, region.x);
+    right = max(right, region.x + region.width);
+  }
+
+  // Rows covered by at least one region, the regions sorted by top
+  vector<cv::Rect> sorted = regions;
+  sort(sorted.begin(), sorted.end(), [](const cv::Rect& a, const cv::Rect& b) { return a.y < b.y; });
+  int64_t rows = 0;
+  int end = 0;
+  for (const cv::Rect& region : sorted) {
+    int top = max(region.y, end);
+    int bottom = region.y + region.height;
+    if (bottom > top) {
+      rows += bottom - top;
+      end = bottom;
+    }
+  }
+  return rows * (right - left);
+}
+
+vector<cv::Rect> locate_code_regions(const cv::Mat& preview)
+{
+  cv::Mat gx;
+  cv::Mat gy;
+  cv::Sobel(preview, gx, CV_16S, 1, 0);
+  cv::Sobel(preview, gy, CV_16S, 0, 1);
+  cv::convertScaleAbs(gx, gx);
+  cv::convertScaleAbs(gy, gy);
+  cv::Mat energy;
+  cv::addWeighted(gx, 0.5, gy, 0.5, 0, energy);
+  cv::blur(energy, energy, cv::Size(3, 3));
+
+  cv::Mat mask;
+  double level = cv::threshold(energy, mask, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+  if (level < MIN_TEXTURE) {
+    cv::threshold(energy, mask, MIN_TEXTURE, 255, cv::THRESH_BINARY);
+  }
+  cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5)));
+
+  vector<vector<cv::Point>> contours;
+  cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+  vector<cv::Rect> regions;
+  for (const vector<cv::Point>& contour : contours) {
+    cv::Rect box = cv::boundingRect(contour);
+    if (box.area() >= MIN_REGION_AREA) {
+      regions.push_back(box);
+    }
+  }
+  return regions;
+}
+
+bool jpeg_prescan(const uint8_t* data, size_t length, int& width, int& height, vector<cv::Rect>& regions,
+                  string& errorMsg)
+{
+  cv::Mat preview = jpeg_decode_preview(data, length, width, height, errorMsg);
+  if (preview.empty()) {
+    return false;
+  }
+
+  cv::Rect image(0, 0, width, height);
+  regions.clear();
+  for (const cv::Rect& box : locate_code_regions(preview)) {
+    cv::Rect area(box.x * PREVIEW_SCALE - REGION_MARGIN, box.y * PREVIEW_SCALE - REGION_MARGIN,
+                  box.width * PREVIEW_SCALE + 2 * REGION_MARGIN, box.height * PREVIEW_SCALE + 2 * REGION_MARGIN);
+    regions.push_back(area & image);
+  }
+
+  MergeRegions(regions);
+  return true;
+}
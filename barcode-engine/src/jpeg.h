@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Partial JPEG decoding through libjpeg-turbo, for the decodes cv::imdecode
+// does not expose. Both produce grayscale: only the luma component is
+// transformed.
+
+// True when the data starts with a JPEG SOI marker
+bool is_jpeg(const uint8_t* data, size_t length);
+
+// Grayscale preview at 1/8 of the image size. At this scale every output
+// pixel is the DC coefficient of its 8x8 block, so the inverse DCT,
+// upsampling and colour conversion are skipped. width and height receive the
+// size of the full image. Returns an empty Mat and sets errorMsg on failure.
+cv::Mat jpeg_decode_preview(const uint8_t* data, size_t length, int& width, int& height, std::string& errorMsg);
+
+// Decode `region` of the image (full-resolution pixels) in grayscale. Rows
+// above the region are skipped without the inverse DCT, columns outside it
+// are not transformed and decoding stops below it, so the cost follows the
+// area of the region rather than the image. The region is widened to whole
+// iMCU columns; `decoded` receives the image area of the returned Mat.
+// Returns an empty Mat and sets errorMsg on failure.
+cv::Mat jpeg_decode_region(const uint8_t* data, size_t length, const cv::Rect& region, cv::Rect& decoded,
+                           std::string& errorMsg);
+
+// Decode several regions of the image in one top-to-bottom pass. Regions are
+// clipped to the image and overlapping ones merged; the output is cropped to
+// the union of their columns, rows between them are skipped and decoding
+// stops below the lowest, so the entropy-coded data is read once however many
+// regions there are. crops receives each region with its pixels, top to
+// bottom, and width and height the size of the full image. Returns false and
+// sets errorMsg on failure or when no region lies inside the image.
+bool jpeg_decode_regions(const uint8_t* data, size_t length, std::vector<cv::Rect> regions, int& width, int& height,
+                         std::vector<std::pair<cv::Rect, cv::Mat>>& crops, std::string& errorMsg);
+
+// Pixels jpeg_decode_regions() transforms for merged, clipped regions: the
+// rows they cover across the union of their columns
+int64_t jpeg_regions_area(const std::vector<cv::Rect>& regions);
+
+// Areas of a 1/8 preview dense in edges, where a barcode may be, in preview
+// pixels. Texture is measured as the smoothed gradient magnitude; blobs are
+// closed over a few pixels so the modules of one symbol form one area.
+std::vector<cv::Rect> locate_code_regions(const cv::Mat& preview);
+
+// Pre-scan of a JPEG: preview, localisation, and the found areas mapped back
+// to the full image with a quiet-zone margin, overlapping areas merged.
+// Returns false and sets errorMsg when the preview cannot be decoded.
+bool jpeg_prescan(const uint8_t* data, size_t length, int& width, int& height, std::vector<cv::Rect>& regions,
+                  std::string& errorMsg);
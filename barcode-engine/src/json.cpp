@@ -0,0 +1,376 @@
+#include "json.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+class Parser {
+public:
+  explicit Parser(const string& text) : text_(text) {}
+
+  bool Document(JsonValue& value, string& errorMsg)
+  {
+    SkipSpace();
+    if (!Value(value, 0)) {
+      errorMsg = error_;
+      return false;
+    }
+    SkipSpace();
+    if (pos_ != text_.size()) {
+      errorMsg = "Unexpected data after JSON value at offset " + to_string(pos_);
+      return false;
+    }
+    return true;
+  }
+
+private:
+  // Deeper documents are rejected instead of exhausting the stack
+  static const int MAX_DEPTH = 256;
+
+  bool Fail(const string& message)
+  {
+    if (error_.empty()) {
+      error_ = message + " at offset " + to_string(pos_);
+    }
+    return false;
+  }
+
+  void SkipSpace()
+  {
+    while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+      pos_++;
+    }
+  }
+
+  bool Literal(const char* word)
+  {
+    size_t length = strlen(word);
+    if (text_.compare(pos_, length, word) != 0) {
+      return Fail("Invalid literal");
+    }
+    pos_ += length;
+    return true;
+  }
+
+  bool Value(JsonValue& value, int depth)
+  {
+    if (depth > MAX_DEPTH) {
+      return Fail("JSON nested too deeply");
+    }
+    if (pos_ >= text_.size()) {
+      return Fail("Unexpected end of JSON");
+    }
+
+    switch (text_[pos_]) {
+      case '{': return Object(value, depth);
+      case '[': return Array(value, depth);
+      case '"':
+        value.type = JsonValue::STRING;
+        return String(value.text);
+      case 't':
+        value.type = JsonValue::BOOLEAN;
+        value.boolean = true;
+        return Literal("true");
+      case 'f':
+        value.type = JsonValue::BOOLEAN;
+        value.boolean = false;
+        return Literal("false");
+      case 'n':
+        value.type = JsonValue::NUL;
+        return Literal("null");
+      default:
+        return Number(value);
+    }
+  }
+
+  bool Object(JsonValue& value, int depth)
+  {
+    value.type = JsonValue::OBJECT;
+    pos_++;
+    SkipSpace();
+    if (pos_ < text_.size() && text_[pos_] == '}') {
+      pos_++;
+      return true;
+    }
+
+    while (true) {
+      SkipSpace();
+      if (pos_ >= text_.size() || text_[pos_] != '"') {
+        return Fail("Expected object key");
+      }
+      string key;
+      if (!String(key)) {
+        return false;
+      }
+      SkipSpace();
+      if (pos_ >= text_.size() || text_[pos_] != ':') {
+        return Fail("Expected ':'");
+      }
+      pos_++;
+      SkipSpace();
+      value.members.emplace_back(key, JsonValue());
+      if (!Value(value.members.back().second, depth + 1)) {
+        return false;
+      }
+      SkipSpace();
+      if (pos_ < text_.size() && text_[pos_] == ',') {
+        pos_++;
+      } else if (pos_ < text_.size() && text_[pos_] == '}') {
+        pos_++;
+        return true;
+      } else {
+        return Fail("Expected ',' or '}'");
+      }
+    }
+  }
+
+  bool Array(JsonValue& value, int depth)
+  {
+    value.type = JsonValue::ARRAY;
+    pos_++;
+    SkipSpace();
+    if (pos_ < text_.size() && text_[pos_] == ']') {
+      pos_++;
+      return true;
+    }
+
+    while (true) {
+      SkipSpace();
+      value.items.emplace_back();
+      if (!Value(value.items.back(), depth + 1)) {
+        return false;
+      }
+      SkipSpace();
+      if (pos_ < text_.size() && text_[pos_] == ',') {
+        pos_++;
+      } else if (pos_ < text_.size() && text_[pos_] == ']') {
+        pos_++;
+        return true;
+      } else {
+        return Fail("Expected ',' or ']'");
+      }
+    }
+  }
+
+  bool Hex4(uint32_t& code)
+  {
+    if (pos_ + 4 > text_.size()) {
+      return Fail("Truncated \\u escape");
+    }
+    code = 0;
+    for (int i = 0; i < 4; i++) {
+      char c = text_[pos_++];
+      code <<= 4;
+      if (c >= '0' && c <= '9') {
+        code |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        code |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        code |= c - 'A' + 10;
+      } else {
+        return Fail("Invalid \\u escape");
+      }
+    }
+    return true;
+  }
+
+  static void AppendUtf8(string& out, uint32_t code)
+  {
+    if (code < 0x80) {
+      out += static_cast<char>(code);
+    } else if (code < 0x800) {
+      out += static_cast<char>(0xc0 | (code >> 6));
+      out += static_cast<char>(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+      out += static_cast<char>(0xe0 | (code >> 12));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+      out += static_cast<char>(0x80 | (code & 0x3f));
+    } else {
+      out += static_cast<char>(0xf0 | (code >> 18));
+      out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+      out += static_cast<char>(0x80 | (code & 0x3f));
+    }
+  }
+
+  bool String(string& out)
+  {
+    pos_++;  // opening quote
+    out.clear();
+    while (pos_ < text_.size()) {
+      char c = text_[pos_++];
+      if (c == '"') {
+        return true;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return Fail("Control character in string");
+      }
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (pos_ >= text_.size()) {
+        break;
+      }
+      char escape = text_[pos_++];
+      switch (escape) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          uint32_t code;
+          if (!Hex4(code)) {
+            return false;
+          }
+          // Surrogate pair
+          if (code >= 0xd800 && code < 0xdc00 && text_.compare(pos_, 2, "\\u") == 0) {
+            size_t mark = pos_;
+            pos_ += 2;
+            uint32_t low;
+            if (!Hex4(low)) {
+              return false;
+            }
+            if (low >= 0xdc00 && low < 0xe000) {
+              code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+            } else {
+              pos_ = mark;
+            }
+          }
+          AppendUtf8(out, code);
+          break;
+        }
+        default:
+          return Fail("Invalid escape");
+      }
+    }
+    return Fail("Unterminated string");
+  }
+
+  bool Number(JsonValue& value)
+  {
+    size_t start = pos_;
+    if (pos_ < text_.size() && text_[pos_] == '-') {
+      pos_++;
+    }
+    while (pos_ < text_.size() && (isdigit(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '.' ||
+                                   text_[pos_] == 'e' || text_[pos_] == 'E' || text_[pos_] == '+' || text_[pos_] == '-')) {
+      pos_++;
+    }
+    if (pos_ == start) {
+      return Fail("Unexpected character");
+    }
+
+    string literal = text_.substr(start, pos_ - start);
+    char* end = nullptr;
+    value.type = JsonValue::NUMBER;
+    value.number = strtod(literal.c_str(), &end);
+    if (end != literal.c_str() + literal.size()) {
+      return Fail("Invalid number");
+    }
+    return true;
+  }
+
+  const string& text_;
+  size_t pos_ = 0;
+  string error_;
+};
+
+}  // namespace
+
+const JsonValue* JsonValue::get(const string& key) const
+{
+  for (auto it = members.rbegin(); it != members.rend(); ++it) {
+    if (it->first == key) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+bool json_parse(const string& text, JsonValue& value, string& errorMsg)
+{
+  value = JsonValue();
+  return Parser(text).Document(value, errorMsg);
+}
+
+string json_string(const string& text)
+{
+  string out = "\"";
+  for (char c : text) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", c);
+          out += buf;
+        } else {
+          out += c;
+        }
+    }
+  }
+  return out + "\"";
+}
+
+string json_number(double value)
+{
+  if (!isfinite(value)) {
+    return "null";
+  }
+  if (value == 0) {
+    return "0";  // also -0
+  }
+
+  // Shortest round-trip digits and decimal exponent, laid out like
+  // ECMAScript Number::toString: plain notation for 1e-7 < |value| < 1e21
+  char buf[64];
+  auto result = to_chars(buf, buf + sizeof(buf), value, chars_format::scientific);
+  string scientific(buf, result.ptr);
+
+  string out;
+  size_t mantissa = 0;
+  if (scientific[0] == '-') {
+    out = "-";
+    mantissa = 1;
+  }
+  size_t e = scientific.find('e');
+  string digits = scientific.substr(mantissa, e - mantissa);
+  digits.erase(remove(digits.begin(), digits.end(), '.'), digits.end());
+  int k = static_cast<int>(digits.size());
+  int n = atoi(scientific.c_str() + e + 1) + 1;  // value = 0.digits * 10^n
+
+  if (k <= n && n <= 21) {
+    out += digits + string(n - k, '0');
+  } else if (0 < n && n <= 21) {
+    out += digits.substr(0, n) + "." + digits.substr(n);
+  } else if (-6 < n && n <= 0) {
+    out += "0." + string(-n, '0') + digits;
+  } else {
+    out += digits.substr(0, 1);
+    if (k > 1) {
+      out += "." + digits.substr(1);
+    }
+    out += (n - 1 >= 0 ? "e+" : "e-") + to_string(abs(n - 1));
+  }
+  return out;
+}
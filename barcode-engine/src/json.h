@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON reader and writer helpers for the native tools, which read
+// the node's block configuration and the decoders' result strings without
+// a JavaScript engine. Output formatting follows JSON.stringify, so native
+// and JavaScript results serialize to the same bytes.
+
+struct JsonValue {
+  enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+  Type type = NUL;
+  bool boolean = false;
+  double number = 0;
+  std::string text;
+  std::vector<JsonValue> items;                               // ARRAY
+  std::vector<std::pair<std::string, JsonValue>> members;     // OBJECT, in document order
+
+  bool isString() const { return type == STRING; }
+  bool isNumber() const { return type == NUMBER; }
+  bool isBoolean() const { return type == BOOLEAN; }
+  bool isArray() const { return type == ARRAY; }
+  bool isObject() const { return type == OBJECT; }
+
+  // Member of an object (the last one when a key repeats), nullptr when missing
+  const JsonValue* get(const std::string& key) const;
+};
+
+// Parse a complete JSON document. Returns false and sets errorMsg on failure.
+bool json_parse(const std::string& text, JsonValue& value, std::string& errorMsg);
+
+// Quoted JSON string, escaped like JSON.stringify
+std::string json_string(const std::string& text);
+
+// Number formatted like JSON.stringify (shortest round trip, null for NaN/Infinity)
+std::string json_number(double value);
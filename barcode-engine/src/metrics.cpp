@@ -0,0 +1,154 @@
+#include "metrics.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+// ---- MetricHistogram ----
+
+int MetricHistogram::BucketOf(uint64_t us)
+{
+  if (us < LINEAR_BUCKETS) {
+    return static_cast<int>(us);
+  }
+  int exponent = 63 - __builtin_clzll(us);  // >= 4
+  int sub = static_cast<int>((us >> (exponent - 3)) & (SUB_BUCKETS - 1));
+  int bucket = LINEAR_BUCKETS + (exponent - 4) * SUB_BUCKETS + sub;
+  return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+uint64_t MetricHistogram::BucketUpperUs(int bucket)
+{
+  if (bucket < LINEAR_BUCKETS) {
+    return static_cast<uint64_t>(bucket);
+  }
+  int exponent = 4 + (bucket - LINEAR_BUCKETS) / SUB_BUCKETS;
+  int sub = (bucket - LINEAR_BUCKETS) % SUB_BUCKETS;
+  uint64_t width = 1ULL << (exponent - 3);
+  return (1ULL << exponent) + (sub + 1) * width - 1;
+}
+
+void MetricHistogram::Observe(double ms)
+{
+  uint64_t us = ms > 0 ? static_cast<uint64_t>(ms * 1000.0 + 0.5) : 0;
+  buckets_[BucketOf(us)].fetch_add(1, memory_order_relaxed);
+  count_.fetch_add(1, memory_order_relaxed);
+  sumUs_.fetch_add(us, memory_order_relaxed);
+}
+
+uint64_t MetricHistogram::CountAtMost(double upperMs) const
+{
+  const double limitUs = upperMs * 1000.0;
+  double total = 0;
+  for (int bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+    double lower = bucket == 0 ? 0.0 : static_cast<double>(BucketUpperUs(bucket - 1) + 1);
+    double upper = static_cast<double>(BucketUpperUs(bucket));
+    double count = static_cast<double>(buckets_[bucket].load(memory_order_relaxed));
+    if (upper <= limitUs) {
+      total += count;
+    } else {
+      // Bucket straddles the limit: assume uniform values inside it
+      if (lower <= limitUs) {
+        total += count * (limitUs - lower + 1) / (upper - lower + 1);
+      }
+      break;
+    }
+  }
+  return static_cast<uint64_t>(total + 0.5);
+}
+
+// ---- Registry ----
+
+namespace {
+
+struct Series {
+  string name;
+  MetricLabels labels;
+  unique_ptr<MetricCounter> counter;
+  unique_ptr<MetricHistogram> histogram;
+};
+
+mutex registryMutex;
+map<string, unique_ptr<Series>> registry;
+
+string SeriesKey(const string& name, const MetricLabels& labels)
+{
+  string key = name;
+  for (const auto& label : labels) {
+    key += '\x1f' + label.first + '=' + label.second;
+  }
+  return key;
+}
+
+Series& GetSeries(const string& name, const MetricLabels& labels)
+{
+  lock_guard<mutex> lock(registryMutex);
+  unique_ptr<Series>& series = registry[SeriesKey(name, labels)];
+  if (!series) {
+    series.reset(new Series{name, labels, nullptr, nullptr});
+  }
+  return *series;
+}
+
+}  // namespace
+
+MetricCounter* metrics_counter(const string& name, const MetricLabels& labels)
+{
+  Series& series = GetSeries(name, labels);
+  lock_guard<mutex> lock(registryMutex);
+  if (!series.counter) {
+    series.counter.reset(new MetricCounter());
+  }
+  return series.counter.get();
+}
+
+MetricHistogram* metrics_histogram(const string& name, const MetricLabels& labels)
+{
+  Series& series = GetSeries(name, labels);
+  lock_guard<mutex> lock(registryMutex);
+  if (!series.histogram) {
+    series.histogram.reset(new MetricHistogram());
+  }
+  return series.histogram.get();
+}
+
+const vector<double>& metrics_bucket_bounds()
+{
+  static const vector<double> bounds = {
+    0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000
+  };
+  return bounds;
+}
+
+vector<MetricSample> metrics_snapshot()
+{
+  vector<MetricSample> samples;
+  lock_guard<mutex> lock(registryMutex);
+
+  for (const auto& entry : registry) {
+    const Series& series = *entry.second;
+    if (series.counter) {
+      MetricSample sample;
+      sample.name = series.name;
+      sample.type = "counter";
+      sample.labels = series.labels;
+      sample.value = series.counter->Value();
+      samples.push_back(move(sample));
+    }
+    if (series.histogram) {
+      MetricSample sample;
+      sample.name = series.name;
+      sample.type = "histogram";
+      sample.labels = series.labels;
+      sample.count = series.histogram->Count();
+      sample.sumMs = series.histogram->SumMs();
+      for (double bound : metrics_bucket_bounds()) {
+        sample.cumulative.push_back(series.histogram->CountAtMost(bound));
+      }
+      samples.push_back(move(sample));
+    }
+  }
+  return samples;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Process-wide metrics registry. Series are created once (under a lock) and
+// never destroyed, so callers keep the returned pointers and record without
+// locking: counters and histograms are plain relaxed atomics.
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+class MetricCounter {
+public:
+  void Add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  uint64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> value_{0};
+};
+
+// Log-linear latency histogram (HDR style): exact below 16 us, then 8
+// sub-buckets per power of two, i.e. at most 12.5% relative error up to ~19 h
+class MetricHistogram {
+public:
+  static constexpr int SUB_BUCKETS = 8;
+  static constexpr int LINEAR_BUCKETS = 16;
+  static constexpr int BUCKET_COUNT = LINEAR_BUCKETS + (36 - 4) * SUB_BUCKETS;
+
+  void Observe(double ms);
+
+  uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+  double SumMs() const { return sumUs_.load(std::memory_order_relaxed) / 1000.0; }
+  // Observations <= upperMs (bucket resolution)
+  uint64_t CountAtMost(double upperMs) const;
+
+private:
+  static int BucketOf(uint64_t us);
+  static uint64_t BucketUpperUs(int bucket);
+
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sumUs_{0};
+};
+
+// Get or create a series; the pointer stays valid for the life of the process
+MetricCounter* metrics_counter(const std::string& name, const MetricLabels& labels);
+MetricHistogram* metrics_histogram(const std::string& name, const MetricLabels& labels);
+
+// Exported histogram boundaries in milliseconds (+Inf is implied)
+const std::vector<double>& metrics_bucket_bounds();
+
+struct MetricSample {
+  std::string name;
+  std::string type;  // "counter" or "histogram"
+  MetricLabels labels;
+  uint64_t value = 0;                 // counter
+  uint64_t count = 0;                 // histogram
+  double sumMs = 0;                   // histogram
+  std::vector<uint64_t> cumulative;   // histogram, one per metrics_bucket_bounds()
+};
+
+// Point-in-time copy of every series
+std::vector<MetricSample> metrics_snapshot();
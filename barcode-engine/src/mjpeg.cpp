@@ -0,0 +1,177 @@
+#include "mjpeg.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// No frame starts in the current chunk
+static const size_t NO_START = SIZE_MAX;
+
+MjpegDemuxer::MjpegDemuxer(size_t maxFrameBytes) : maxFrameBytes_(maxFrameBytes) {}
+
+void MjpegDemuxer::Push(const uint8_t* data, size_t length, vector<Frame>& frames)
+{
+  size_t start = NO_START;  // offset of the current frame when it started in this chunk
+  size_t i = 0;
+
+  auto abandon = [&]() {
+    discarded_++;
+    partial_.clear();
+    carried_ = false;
+    start = NO_START;
+    state_ = State::Seek;
+    sawFF_ = false;
+  };
+
+  // SOI just consumed: its FF is at i - 2, or ended the previous chunk
+  auto begin = [&]() {
+    partial_.clear();
+    if (i >= 2) {
+      carried_ = false;
+      start = i - 2;
+    } else {
+      carried_ = true;
+      start = NO_START;
+      partial_.push_back(0xFF);
+    }
+    state_ = State::Marker;
+    sawFF_ = false;
+  };
+
+  // EOI just consumed: the frame ends at i
+  auto complete = [&]() {
+    Frame frame;
+    if (carried_) {
+      partial_.insert(partial_.end(), data, data + i);
+      frame.length = partial_.size();
+      frame.data.swap(partial_);
+      carried_ = false;
+    } else {
+      frame.offset = start;
+      frame.length = i - start;
+    }
+    if (frame.length <= maxFrameBytes_) {
+      frames.push_back(move(frame));
+    } else {
+      discarded_++;
+    }
+    start = NO_START;
+    state_ = State::Seek;
+    sawFF_ = false;
+  };
+
+  // Marker code inside a frame
+  auto marker = [&](uint8_t code) {
+    if (code == 0xD9) {
+      complete();
+    } else if (code == 0xD8) {
+      // Truncated frame followed by a new one
+      discarded_++;
+      begin();
+    } else if ((code >= 0xD0 && code <= 0xD7) || code == 0x01) {
+      state_ = State::Marker;  // standalone markers carry no length
+    } else if (code == 0x00) {
+      abandon();
+    } else {
+      marker_ = code;
+      lengthBytes_ = 0;
+      remaining_ = 0;
+      state_ = State::Length;
+    }
+  };
+
+  while (i < length) {
+    switch (state_) {
+      case State::Seek: {
+        if (sawFF_) {
+          sawFF_ = false;
+          if (data[i] == 0xD8) {
+            i++;
+            begin();
+            break;
+          }
+        }
+        const void* ff = memchr(data + i, 0xFF, length - i);
+        if (ff == nullptr) {
+          i = length;
+        } else {
+          i = static_cast<const uint8_t*>(ff) - data + 1;
+          sawFF_ = true;
+        }
+        break;
+      }
+
+      case State::Marker: {
+        uint8_t b = data[i++];
+        if (b == 0xFF) {
+          sawFF_ = true;  // fill bytes may precede the code
+        } else if (!sawFF_) {
+          abandon();
+        } else {
+          sawFF_ = false;
+          marker(b);
+        }
+        break;
+      }
+
+      case State::Length:
+        remaining_ = (remaining_ << 8) | data[i++];
+        if (++lengthBytes_ == 2) {
+          if (remaining_ < 2) {
+            abandon();
+          } else {
+            remaining_ -= 2;
+            state_ = State::Segment;
+          }
+        }
+        break;
+
+      case State::Segment: {
+        size_t skip = min(remaining_, length - i);
+        i += skip;
+        remaining_ -= skip;
+        if (remaining_ == 0) {
+          state_ = marker_ == 0xDA ? State::Entropy : State::Marker;
+        }
+        break;
+      }
+
+      case State::Entropy: {
+        if (sawFF_) {
+          uint8_t b = data[i++];
+          if (b == 0xFF) {
+            break;
+          }
+          sawFF_ = false;
+          // FF 00 is a stuffed data byte, RSTn stays in the scan
+          if (b != 0x00 && (b < 0xD0 || b > 0xD7)) {
+            marker(b);
+          }
+          break;
+        }
+        const void* ff = memchr(data + i, 0xFF, length - i);
+        if (ff == nullptr) {
+          i = length;
+        } else {
+          i = static_cast<const uint8_t*>(ff) - data + 1;
+          sawFF_ = true;
+        }
+        break;
+      }
+    }
+  }
+
+  // Keep the unfinished frame for the next chunk
+  if (state_ != State::Seek) {
+    if (carried_) {
+      partial_.insert(partial_.end(), data, data + length);
+    } else {
+      partial_.assign(data + start, data + length);
+      carried_ = true;
+    }
+    if (partial_.size() > maxFrameBytes_) {
+      abandon();
+    }
+  }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Splits an MJPEG byte stream (multipart/x-mixed-replace over HTTP, or bare
+// concatenated JPEGs) into its JPEG frames.
+//
+// Frames are found from the JPEG structure rather than the multipart headers:
+// bytes outside a frame are skipped up to the next SOI (FF D8), marker
+// segments are skipped by their length, and the entropy-coded data is scanned
+// for the EOI marker (FF D9). Thumbnails embedded in APPn segments therefore
+// do not end a frame early. Chunks may split the stream anywhere.
+//
+// Not thread-safe: the chunks of one stream are pushed in order.
+class MjpegDemuxer {
+public:
+  // A complete frame: bytes [offset, offset + length) of the chunk just
+  // pushed, or `data` when the frame spans several chunks
+  struct Frame {
+    size_t offset = 0;
+    size_t length = 0;
+    std::vector<uint8_t> data;
+  };
+
+  // Frames larger than maxFrameBytes are discarded (corrupt or foreign stream)
+  explicit MjpegDemuxer(size_t maxFrameBytes);
+
+  // Scan a chunk and append the frames it completes. Only the part of a frame
+  // still incomplete at the end of the chunk is copied.
+  void Push(const uint8_t* data, size_t length, std::vector<Frame>& frames);
+
+  // Frames dropped because they were malformed or too large
+  uint64_t discarded() const { return discarded_; }
+
+private:
+  enum class State {
+    Seek,     // outside a frame, looking for SOI
+    Marker,   // inside a frame, expecting FF + marker code
+    Length,   // reading the 2-byte segment length
+    Segment,  // skipping segment payload
+    Entropy   // entropy-coded data after SOS
+  };
+
+  size_t maxFrameBytes_;
+  State state_ = State::Seek;
+  bool sawFF_ = false;         // the last byte examined was FF
+  uint8_t marker_ = 0;         // code of the segment being read
+  int lengthBytes_ = 0;
+  size_t remaining_ = 0;       // segment bytes left to skip
+  bool carried_ = false;       // the current frame started in an earlier chunk
+  std::vector<uint8_t> partial_;  // bytes of that frame so far
+  uint64_t discarded_ = 0;
+};
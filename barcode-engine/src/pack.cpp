@@ -0,0 +1,252 @@
+#include "pack.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char PACK_MAGIC[8] = {'R', 'P', 'B', 'P', 'A', 'C', 'K', '1'};
+
+struct PackHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t count;
+  uint64_t indexOffset;
+  uint64_t manifestOffset;
+  uint64_t manifestLength;
+};
+
+static uint64_t AlignUp(uint64_t value)
+{
+  return (value + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+}
+
+const char* pack_color_space_name(uint32_t colorSpace)
+{
+  switch (colorSpace) {
+    case PACK_GRAY: return "GRAY";
+    case PACK_BGR: return "BGR";
+    case PACK_RGB: return "RGB";
+    case PACK_BGRA: return "BGRA";
+    case PACK_RGBA: return "RGBA";
+    default: return nullptr;
+  }
+}
+
+bool pack_color_space_from_name(const string& name, uint32_t& colorSpace, uint32_t& channels)
+{
+  if (name == "GRAY") {
+    colorSpace = PACK_GRAY;
+    channels = 1;
+  } else if (name == "BGR" || name == "RGB") {
+    colorSpace = name == "BGR" ? PACK_BGR : PACK_RGB;
+    channels = 3;
+  } else if (name == "BGRA" || name == "RGBA") {
+    colorSpace = name == "BGRA" ? PACK_BGRA : PACK_RGBA;
+    channels = 4;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static uint32_t ChannelsOf(uint32_t colorSpace)
+{
+  switch (colorSpace) {
+    case PACK_GRAY: return 1;
+    case PACK_BGR:
+    case PACK_RGB: return 3;
+    case PACK_BGRA:
+    case PACK_RGBA: return 4;
+    default: return 0;
+  }
+}
+
+PackWriter::~PackWriter()
+{
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+unique_ptr<PackWriter> PackWriter::Create(const string& path, string& errorMsg)
+{
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    errorMsg = "open(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  unique_ptr<PackWriter> writer(new PackWriter());
+  writer->path_ = path;
+  writer->fd_ = fd;
+  // The first page is kept for the header
+  writer->end_ = PACK_ALIGNMENT;
+  return writer;
+}
+
+bool PackWriter::WriteAt(uint64_t offset, const void* data, size_t length, string& errorMsg)
+{
+  const char* bytes = static_cast<const char*>(data);
+  while (length > 0) {
+    ssize_t written = pwrite(fd_, bytes, length, static_cast<off_t>(offset));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      errorMsg = "write(" + path_ + ") failed: " + strerror(errno);
+      return false;
+    }
+    bytes += written;
+    offset += static_cast<uint64_t>(written);
+    length -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+bool PackWriter::Add(const uint8_t* data, size_t length, uint32_t colorSpace, uint32_t width, uint32_t height,
+                     string& errorMsg)
+{
+  if (fd_ < 0) {
+    errorMsg = "Pack file is closed";
+    return false;
+  }
+
+  PackEntry entry = {end_, length, colorSpace, 0, 0, 0};
+  if (colorSpace != PACK_ENCODED) {
+    uint32_t channels = ChannelsOf(colorSpace);
+    if (channels == 0) {
+      errorMsg = "Unknown colour space code: " + to_string(colorSpace);
+      return false;
+    }
+    if (static_cast<uint64_t>(width) * height * channels != length) {
+      errorMsg = "Raw frame of " + to_string(length) + " bytes does not match " + to_string(width) + "x" +
+                 to_string(height) + "x" + to_string(channels);
+      return false;
+    }
+    entry.width = width;
+    entry.height = height;
+    entry.channels = channels;
+  }
+
+  if (!WriteAt(end_, data, length, errorMsg)) {
+    return false;
+  }
+  entries_.push_back(entry);
+  end_ = AlignUp(end_ + length);
+  return true;
+}
+
+bool PackWriter::Finish(const string& manifest, string& errorMsg)
+{
+  if (fd_ < 0) {
+    errorMsg = "Pack file is closed";
+    return false;
+  }
+
+  PackHeader header = {};
+  memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+  header.version = PACK_VERSION;
+  header.count = static_cast<uint32_t>(entries_.size());
+  header.indexOffset = end_;
+  header.manifestOffset = end_ + entries_.size() * sizeof(PackEntry);
+  header.manifestLength = manifest.size();
+
+  bool ok = WriteAt(header.indexOffset, entries_.data(), entries_.size() * sizeof(PackEntry), errorMsg) &&
+            WriteAt(header.manifestOffset, manifest.data(), manifest.size(), errorMsg) &&
+            WriteAt(0, &header, sizeof(header), errorMsg);
+  if (ok && fsync(fd_) != 0) {
+    errorMsg = "fsync(" + path_ + ") failed: " + strerror(errno);
+    ok = false;
+  }
+
+  close(fd_);
+  fd_ = -1;
+  return ok;
+}
+
+PackFile::~PackFile()
+{
+  if (map != nullptr) {
+    munmap(const_cast<unsigned char*>(map), size);
+  }
+}
+
+shared_ptr<const PackFile> pack_read(const string& path, string& errorMsg)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    errorMsg = "open(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    errorMsg = "fstat(" + path + ") failed: " + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size < PACK_ALIGNMENT) {
+    errorMsg = path + " is not a barcode corpus pack";
+    close(fd);
+    return nullptr;
+  }
+
+  void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    errorMsg = "mmap(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  auto file = make_shared<PackFile>();
+  file->path = path;
+  file->map = static_cast<const unsigned char*>(address);
+  file->size = size;
+
+  const PackHeader* header = reinterpret_cast<const PackHeader*>(file->map);
+  uint64_t indexBytes = static_cast<uint64_t>(header->count) * sizeof(PackEntry);
+  if (memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header->version != PACK_VERSION ||
+      header->indexOffset > size || indexBytes > size - header->indexOffset ||
+      header->manifestOffset > size || header->manifestLength > size - header->manifestOffset) {
+    errorMsg = path + " is not a barcode corpus pack (version " + to_string(PACK_VERSION) + ")";
+    return nullptr;
+  }
+
+  const PackEntry* index = reinterpret_cast<const PackEntry*>(file->map + header->indexOffset);
+  file->entries.assign(index, index + header->count);
+  for (size_t i = 0; i < file->entries.size(); i++) {
+    const PackEntry& entry = file->entries[i];
+    if (entry.offset > header->indexOffset || entry.length > header->indexOffset - entry.offset) {
+      errorMsg = path + " is corrupt: frame " + to_string(i) + " lies outside the frame area";
+      return nullptr;
+    }
+    if (entry.colorSpace == PACK_ENCODED) {
+      continue;
+    }
+    // Raw frames are wrapped as a cv::Mat over the mapping, so the geometry
+    // must describe exactly the bytes of the frame, as PackWriter::Add checks
+    uint32_t channels = ChannelsOf(entry.colorSpace);
+    uint64_t pixels = static_cast<uint64_t>(entry.width) * entry.height;
+    if (channels == 0 || entry.channels != channels || pixels > entry.length / channels ||
+        pixels * channels != entry.length) {
+      errorMsg = path + " is corrupt: raw frame " + to_string(i) + " has colour space " +
+                 to_string(entry.colorSpace) + " and size " + to_string(entry.width) + "x" +
+                 to_string(entry.height) + "x" + to_string(entry.channels) + " for " +
+                 to_string(entry.length) + " bytes";
+      return nullptr;
+    }
+  }
+  file->manifest.assign(reinterpret_cast<const char*>(file->map + header->manifestOffset), header->manifestLength);
+
+  // Benchmarks walk the frames in order
+  madvise(address, size, MADV_SEQUENTIAL);
+  return file;
+}
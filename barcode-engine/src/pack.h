@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Packed benchmark corpus: every image of a corpus in one file, mapped and
+// iterated without copies, so benchmarks measure decoding rather than the
+// filesystem.
+//
+// Layout (little endian):
+//   header    "RPBPACK1", u32 version, u32 image count, u64 index offset,
+//             u64 manifest offset, u64 manifest length (one page)
+//   frames    encoded file bytes or raw pixels, each starting on a page boundary
+//   index     one PackEntry per image
+//   manifest  JSON { images: [{ file, codes }], ... }, images in index order
+//
+// The index follows the frames so they can be streamed while the corpus is
+// converted; the header is written last, so a file left by an interrupted
+// conversion is rejected.
+//
+// Raw frames are tightly packed rows (stride = width * channels), so they can
+// be wrapped as a cv::Mat directly in the mapping.
+
+const uint32_t PACK_VERSION = 1;
+const uint64_t PACK_ALIGNMENT = 4096;
+
+enum PackColorSpace : uint32_t {
+  PACK_ENCODED = 0,  // JPEG, PNG, ... as read from the file
+  PACK_GRAY = 1,
+  PACK_BGR = 2,
+  PACK_RGB = 3,
+  PACK_BGRA = 4,
+  PACK_RGBA = 5
+};
+
+struct PackEntry {
+  uint64_t offset;
+  uint64_t length;
+  uint32_t colorSpace;  // PackColorSpace
+  uint32_t width;       // raw frames only
+  uint32_t height;
+  uint32_t channels;
+};
+
+// Name of a raw colour space ("GRAY", "BGR", ...), nullptr for encoded frames
+const char* pack_color_space_name(uint32_t colorSpace);
+
+// Colour space from its name; returns false for unknown names
+bool pack_color_space_from_name(const std::string& name, uint32_t& colorSpace, uint32_t& channels);
+
+// Builds a pack file. Frames are streamed to disk as they are added; the
+// index and manifest are written by Finish().
+class PackWriter {
+public:
+  ~PackWriter();
+
+  // Returns nullptr and sets errorMsg on failure
+  static std::unique_ptr<PackWriter> Create(const std::string& path, std::string& errorMsg);
+
+  // Append an encoded image (colorSpace PACK_ENCODED) or raw pixels
+  bool Add(const uint8_t* data, size_t length, uint32_t colorSpace, uint32_t width, uint32_t height,
+           std::string& errorMsg);
+
+  // Write index, manifest and header, then close the file
+  bool Finish(const std::string& manifest, std::string& errorMsg);
+
+  size_t count() const { return entries_.size(); }
+
+  PackWriter(const PackWriter&) = delete;
+  PackWriter& operator=(const PackWriter&) = delete;
+
+private:
+  PackWriter() = default;
+  bool WriteAt(uint64_t offset, const void* data, size_t length, std::string& errorMsg);
+
+  std::string path_;
+  int fd_ = -1;
+  uint64_t end_ = 0;
+  std::vector<PackEntry> entries_;
+};
+
+// Read-only mapping of a pack file; frame pointers point into it
+struct PackFile {
+  std::string path;
+  const unsigned char* map = nullptr;
+  size_t size = 0;
+  std::string manifest;
+  std::vector<PackEntry> entries;
+
+  const uint8_t* data(size_t index) const { return map + entries[index].offset; }
+  ~PackFile();
+};
+
+// Map a pack file and validate its index. Returns nullptr and sets errorMsg on failure.
+std::shared_ptr<const PackFile> pack_read(const std::string& path, std::string& errorMsg);
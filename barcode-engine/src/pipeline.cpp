@@ -0,0 +1,502 @@
+#include "pipeline.h"
+#include "filemap.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+using namespace std;
+
+string run_block(const cv::Mat& input, const BlockConfig& block, StageTimings& timings)
+{
+  cv::Mat source = input;
+  if (block.scale > 0 && block.scale < 1) {
+    ScopedTimer timer(&timings.scaleMs, "scale");
+    cv::resize(input, source, cv::Size(), block.scale, block.scale, cv::INTER_LINEAR);
+  }
+
+  cv::Mat gray;
+  {
+    ScopedTimer timer(&timings.preprocessMs, "preprocess");
+    if (block.preprocessing == "original") {
+      gray = preprocess_original(source);
+    } else if (block.preprocessing == "histogram") {
+      gray = preprocess_histogram(source);
+    } else if (block.preprocessing == "otsu") {
+      gray = preprocess_otsu(source);
+    } else {
+      return "{\"error\": " + json_string("Unknown preprocessing method: " + block.preprocessing) + "}";
+    }
+  }
+
+  if (gray.empty()) {
+    return "{\"error\": \"Preprocessing failed\"}";
+  }
+
+  ScopedTimer timer(&timings.decodeMs, block.decoder == "zbar" ? "decode_zbar" : "decode_zxing");
+  if (block.decoder == "zbar") {
+    return decode_zbar(gray, block.zbar);
+  } else if (block.decoder == "zxing") {
+    return decode_zxing(gray, block.zxing);
+  }
+  return "{\"error\": " + json_string("Unknown decoder: " + block.decoder) + "}";
+}
+
+bool color_space_type(const string& colorSpace, int& channels, int& cvType)
+{
+  if (colorSpace == "GRAY") {
+    channels = 1;
+    cvType = CV_8UC1;
+  } else if (colorSpace == "RGB" || colorSpace == "BGR") {
+    channels = 3;
+    cvType = CV_8UC3;
+  } else if (colorSpace == "RGBA" || colorSpace == "BGRA") {
+    channels = 4;
+    cvType = CV_8UC4;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+cv::Mat wrap_pixels(const uint8_t* data, int width, int height, size_t stride, const string& colorSpace,
+                    string& errorMsg, StageTimings* timings)
+{
+  int channels = 0;
+  int cvType = CV_8UC1;
+  if (!color_space_type(colorSpace, channels, cvType)) {
+    errorMsg = "Unsupported colorSpace: " + colorSpace + ". Supported values: GRAY, RGB, BGR, RGBA, BGRA";
+    return cv::Mat();
+  }
+
+  cv::Mat mat(height, width, cvType, const_cast<uint8_t*>(data), stride);
+  if (colorSpace != "RGB" && colorSpace != "RGBA") {
+    return mat;
+  }
+
+  ScopedTimer timer(timings ? &timings->colorConversionMs : nullptr, "color_conversion");
+  cv::Mat bgrMat;
+  cv::cvtColor(mat, bgrMat, colorSpace == "RGB" ? cv::COLOR_RGB2BGR : cv::COLOR_RGBA2BGRA);
+  return bgrMat;
+}
+
+// Decoded image with 8-bit samples: 16-bit images are scaled down, other
+// sample types are rejected
+static cv::Mat EightBitSamples(cv::Mat mat, string& errorMsg)
+{
+  if (mat.depth() == CV_16U) {
+    mat.convertTo(mat, CV_8U, 1.0 / 257.0);
+  } else if (mat.depth() != CV_8U) {
+    errorMsg = "unsupported sample type (only 8 and 16 bit images are supported)";
+    return cv::Mat();
+  }
+  return mat;
+}
+
+cv::Mat decode_image_buffer(const uint8_t* data, size_t length, string& errorMsg, StageTimings* timings)
+{
+  if (length == 0 || length > INT32_MAX) {
+    errorMsg = "Encoded image of " + to_string(length) + " bytes cannot be decoded";
+    return cv::Mat();
+  }
+
+  ScopedTimer timer(timings ? &timings->inputDecodeMs : nullptr, "input_decode");
+  cv::Mat tmp(1, static_cast<int>(length), CV_8UC1, const_cast<uint8_t*>(data));
+  cv::Mat mat = cv::imdecode(tmp, cv::IMREAD_UNCHANGED);
+  if (mat.empty()) {
+    errorMsg = "unknown or corrupt image format";
+    return mat;
+  }
+  return EightBitSamples(mat, errorMsg);
+}
+
+cv::Mat decode_image_reduced(const uint8_t* data, size_t length, int reduce, string& errorMsg, StageTimings* timings)
+{
+  int flags = 0;
+  switch (reduce) {
+    case 1: flags = cv::IMREAD_GRAYSCALE; break;
+    case 2: flags = cv::IMREAD_REDUCED_GRAYSCALE_2; break;
+    case 4: flags = cv::IMREAD_REDUCED_GRAYSCALE_4; break;
+    case 8: flags = cv::IMREAD_REDUCED_GRAYSCALE_8; break;
+    default:
+      errorMsg = "Invalid reduction " + to_string(reduce) + " (1, 2, 4 or 8)";
+      return cv::Mat();
+  }
+  if (length == 0 || length > INT32_MAX) {
+    errorMsg = "Encoded image of " + to_string(length) + " bytes cannot be decoded";
+    return cv::Mat();
+  }
+
+  ScopedTimer timer(timings ? &timings->inputDecodeMs : nullptr, "input_decode");
+  cv::Mat tmp(1, static_cast<int>(length), CV_8UC1, const_cast<uint8_t*>(data));
+  cv::Mat mat = cv::imdecode(tmp, flags);
+  if (mat.empty()) {
+    errorMsg = "unknown or corrupt image format";
+  }
+  return mat;
+}
+
+cv::Mat decode_image_file(const string& path, string& errorMsg, StageTimings* timings)
+{
+  vector<unsigned char> bytes;
+  if (!file_read(path, bytes, errorMsg)) {
+    return cv::Mat();
+  }
+
+  cv::Mat mat = decode_image_buffer(bytes.data(), bytes.size(), errorMsg, timings);
+  if (mat.empty()) {
+    errorMsg = "Failed to decode image file " + path + ": " + errorMsg;
+  }
+  return mat;
+}
+
+cv::Mat decode_image_page(const uint8_t* data, size_t length, int page, string& errorMsg, StageTimings* timings)
+{
+  if (length == 0 || length > INT32_MAX) {
+    errorMsg = "Encoded image of " + to_string(length) + " bytes cannot be decoded";
+    return cv::Mat();
+  }
+  if (page < 0) {
+    errorMsg = "Invalid page " + to_string(page);
+    return cv::Mat();
+  }
+
+  ScopedTimer timer(timings ? &timings->inputDecodeMs : nullptr, "input_decode");
+  cv::Mat tmp(1, static_cast<int>(length), CV_8UC1, const_cast<uint8_t*>(data));
+  vector<cv::Mat> pages;
+  // The decoder walks the page directory up to `page` and decodes that page only
+  if (!cv::imdecodemulti(tmp, cv::IMREAD_UNCHANGED, pages, cv::Range(page, page + 1)) || pages.empty()) {
+    errorMsg = page == 0 ? "unknown or corrupt image format" : "page " + to_string(page) + " is missing or corrupt";
+    return cv::Mat();
+  }
+  return EightBitSamples(pages[0], errorMsg);
+}
+
+cv::Mat decode_image_file_page(const string& path, int page, string& errorMsg, StageTimings* timings)
+{
+  vector<unsigned char> bytes;
+  if (!file_read(path, bytes, errorMsg)) {
+    return cv::Mat();
+  }
+
+  cv::Mat mat = decode_image_page(bytes.data(), bytes.size(), page, errorMsg, timings);
+  if (mat.empty()) {
+    errorMsg = "Failed to decode image file " + path + ": " + errorMsg;
+  }
+  return mat;
+}
+
+int image_file_pages(const string& path, string& errorMsg)
+{
+  try {
+    size_t pages = cv::imcount(path, cv::IMREAD_UNCHANGED);
+    if (pages == 0) {
+      errorMsg = "Failed to read image file " + path + ": unknown or corrupt image format";
+    }
+    return static_cast<int>(min<size_t>(pages, INT32_MAX));
+  } catch (const cv::Exception& e) {
+    errorMsg = "Failed to read image file " + path + ": " + e.what();
+    return 0;
+  }
+}
+
+// ---- Pipeline configuration ----
+
+static string StringOption(const JsonValue& obj, const char* key, const string& fallback)
+{
+  const JsonValue* value = obj.get(key);
+  return value != nullptr && value->isString() ? value->text : fallback;
+}
+
+// parseFloat()/parseInt() of a number or numeric string, NaN otherwise
+static double NumberOption(const JsonValue& obj, const char* key, bool integer)
+{
+  const JsonValue* value = obj.get(key);
+  double number = NAN;
+  if (value != nullptr && value->isNumber()) {
+    number = value->number;
+  } else if (value != nullptr && value->isString()) {
+    char* end = nullptr;
+    number = strtod(value->text.c_str(), &end);
+    if (end == value->text.c_str()) {
+      number = NAN;
+    }
+  }
+  return integer ? trunc(number) : number;
+}
+
+static bool BooleanOption(const JsonValue& obj, const char* key, bool& out)
+{
+  const JsonValue* value = obj.get(key);
+  if (value == nullptr || !value->isBoolean()) {
+    return false;
+  }
+  out = value->boolean;
+  return true;
+}
+
+// Same defaults as nativeOptions() in lib/pipeline.js
+static BlockConfig ReadBlock(const JsonValue& obj)
+{
+  BlockConfig block;
+  block.decoder = StringOption(obj, "decoder", "");
+  block.preprocessing = StringOption(obj, "preprocessing", "");
+
+  double scale = NumberOption(obj, "scale", false);
+  block.scale = isnan(scale) || scale == 0 ? 1 : scale;
+
+  static const JsonValue NO_OPTIONS;
+  const JsonValue* options = obj.get("options");
+  if (options == nullptr || !options->isObject()) {
+    options = &NO_OPTIONS;
+  }
+
+  block.zbar.symbologies = StringOption(*options, "symbologies", "");
+  double density = NumberOption(*options, "density", true);
+  block.zbar.density = isnan(density) || density == 0 ? 1 : static_cast<int>(density);
+
+  BooleanOption(*options, "tryHarder", block.zxing.tryHarder);
+  block.zxing.tryRotate = block.zxing.tryHarder;
+  BooleanOption(*options, "tryRotate", block.zxing.tryRotate);
+  block.zxing.formats = StringOption(*options, "formats", "");
+  block.zxing.binarizer = StringOption(*options, "binarizer", "LocalAverage");
+  return block;
+}
+
+bool read_pipeline_config(const string& json, PipelineConfig& config, string& errorMsg)
+{
+  JsonValue root;
+  if (!json_parse(json, root, errorMsg)) {
+    errorMsg = "Invalid configuration: " + errorMsg;
+    return false;
+  }
+  if (!root.isObject()) {
+    errorMsg = "Invalid configuration: expected an object { blocks, executionMode }";
+    return false;
+  }
+
+  const JsonValue* blocks = root.get("blocks");
+  if (blocks == nullptr || !blocks->isArray() || blocks->items.empty()) {
+    errorMsg = "No decoder blocks configured";
+    return false;
+  }
+
+  config = PipelineConfig();
+  for (size_t i = 0; i < blocks->items.size(); i++) {
+    if (!blocks->items[i].isObject()) {
+      errorMsg = "Block " + to_string(i) + " is not an object";
+      return false;
+    }
+    BlockConfig block = ReadBlock(blocks->items[i]);
+    if (block.decoder == "quagga2") {
+      errorMsg = "Block " + to_string(i) + " (quagga2) runs in JavaScript only";
+      return false;
+    }
+    config.blocks.push_back(block);
+  }
+  config.sequential = StringOption(root, "executionMode", "parallel") == "sequential";
+  return true;
+}
+
+// ---- Pipeline ----
+
+// One block with its results mapped back to input coordinates;
+// false (and a warning) when the block failed
+static bool RunPipelineBlock(const cv::Mat& image, const BlockConfig& block, size_t index,
+                             vector<Detection>& detections, vector<string>& warnings)
+{
+  StageTimings timings;
+  string json = run_block(image, block, timings);
+
+  string errorMsg;
+  JsonValue parsed;
+  if (!json_parse(json, parsed, errorMsg)) {
+    warnings.push_back("Block " + to_string(index) + " (" + block.decoder + ") failed: " + errorMsg);
+    return false;
+  }
+  const JsonValue* error = parsed.get("error");
+  if (error != nullptr && error->isString() && !error->text.empty()) {
+    warnings.push_back("Block " + to_string(index) + " (" + block.decoder + ") failed: " + error->text);
+    return false;
+  }
+
+  const JsonValue* results = parsed.get("results");
+  if (results == nullptr || !results->isArray()) {
+    return true;
+  }
+
+  static const char* const POINT_KEYS[8] = {"x1", "y1", "x2", "y2", "x3", "y3", "x4", "y4"};
+  bool scaled = block.scale > 0 && block.scale < 1;
+  double factor = scaled ? 1 / block.scale : 1;
+
+  for (const JsonValue& result : results->items) {
+    Detection detection;
+    detection.type = StringOption(result, "type", "");
+    detection.data = StringOption(result, "data", "");
+    const JsonValue* points = result.get("points");
+    for (int i = 0; i < 8; i++) {
+      const JsonValue* point = points != nullptr ? points->get(POINT_KEYS[i]) : nullptr;
+      double value = point != nullptr && point->isNumber() ? point->number : 0;
+      detection.points[i] = scaled ? value * factor : value;
+    }
+    detection.blockIndex = index;
+    detection.decoder = block.decoder;
+    detection.preprocessing = block.preprocessing;
+    detections.push_back(detection);
+  }
+  return true;
+}
+
+// Keep one detection per value, from the lowest block, listing every
+// decoder_preprocessing pair that found it
+static vector<Detection> DeduplicateDetections(const vector<Detection>& detections)
+{
+  vector<Detection> unique;
+  unordered_map<string, size_t> byValue;
+
+  for (const Detection& detection : detections) {
+    string detectedBy = detection.decoder + "_" + detection.preprocessing;
+    auto found = byValue.find(detection.data);
+    if (found == byValue.end()) {
+      byValue.emplace(detection.data, unique.size());
+      unique.push_back(detection);
+      unique.back().detectedBy = {detectedBy};
+      continue;
+    }
+
+    Detection& existing = unique[found->second];
+    if (find(existing.detectedBy.begin(), existing.detectedBy.end(), detectedBy) == existing.detectedBy.end()) {
+      existing.detectedBy.push_back(detectedBy);
+    }
+    if (detection.blockIndex < existing.blockIndex) {
+      vector<string> list = move(existing.detectedBy);
+      existing = detection;
+      existing.detectedBy = move(list);
+    }
+  }
+  return unique;
+}
+
+static string PointJson(double x, double y)
+{
+  return "{\"x\":" + json_number(x) + ",\"y\":" + json_number(y) + "}";
+}
+
+// convertToFinalFormat() of lib/pipeline.js: relative corners, centre, size and angle
+string detection_json(const Detection& detection, double width, double height)
+{
+  const double* p = detection.points;
+  // Corners in output order: x2,y2  x3,y3  x4,y4  x1,y1
+  const double l[8] = {p[2], p[3], p[4], p[5], p[6], p[7], p[0], p[1]};
+
+  double centerX = (l[0] + l[4]) / 2;
+  double centerY = (l[1] + l[5]) / 2;
+  double angle = -atan((l[0] - l[6]) / (l[1] - l[7])) * 180 / M_PI;
+  double sizeY = sqrt((l[6] - l[0]) * (l[6] - l[0]) + (l[7] - l[1]) * (l[7] - l[1]));
+  double sizeX = sqrt((l[2] - l[0]) * (l[2] - l[0]) + (l[3] - l[1]) * (l[3] - l[1]));
+
+  string json = "{\"format\":" + json_string(detection.type) +
+                ",\"value\":" + json_string(detection.data) +
+                ",\"box\":{\"angle\":" + json_number(angle) +
+                ",\"center\":" + PointJson(centerX / width, centerY / height) +
+                ",\"size\":{\"width\":" + json_number(sizeX / width) + ",\"height\":" + json_number(sizeY / height) + "}}" +
+                ",\"corners\":[";
+  for (int i = 0; i < 4; i++) {
+    json += (i > 0 ? "," : "") + PointJson(l[2 * i] / width, l[2 * i + 1] / height);
+  }
+  json += "],\"detectedBy\":[";
+  for (size_t i = 0; i < detection.detectedBy.size(); i++) {
+    json += (i > 0 ? "," : "") + json_string(detection.detectedBy[i]);
+  }
+  return json + "]}";
+}
+
+vector<Detection> run_pipeline_detections(const cv::Mat& image, const PipelineConfig& config, vector<string>& warnings)
+{
+  vector<Detection> detections;
+  for (size_t i = 0; i < config.blocks.size(); i++) {
+    size_t before = detections.size();
+    bool ok = RunPipelineBlock(image, config.blocks[i], i, detections, warnings);
+    if (config.sequential && ok && detections.size() > before) {
+      break;
+    }
+  }
+  return DeduplicateDetections(detections);
+}
+
+string run_pipeline(const cv::Mat& image, const PipelineConfig& config, vector<string>& warnings)
+{
+  string json = "[";
+  vector<Detection> unique = run_pipeline_detections(image, config, warnings);
+  for (size_t i = 0; i < unique.size(); i++) {
+    json += (i > 0 ? "," : "") + detection_json(unique[i], image.cols, image.rows);
+  }
+  return json + "]";
+}
+
+// ---- Metrics ----
+
+BlockMetrics* metrics_block(const MetricLabels& labels)
+{
+  static mutex blocksMutex;
+  static map<MetricLabels, unique_ptr<BlockMetrics>> blocks;
+
+  lock_guard<mutex> lock(blocksMutex);
+  unique_ptr<BlockMetrics>& metrics = blocks[labels];
+  if (!metrics) {
+    auto stage = [&labels](const char* name) {
+      MetricLabels stageLabels = labels;
+      stageLabels.emplace_back("stage", name);
+      return metrics_histogram("barcode_block_stage_seconds", stageLabels);
+    };
+    metrics.reset(new BlockMetrics{
+      metrics_counter("barcode_block_runs", labels),
+      metrics_counter("barcode_block_errors", labels),
+      metrics_counter("barcode_block_symbols", labels),
+      stage("input_decode"),
+      stage("color_conversion"),
+      stage("scale"),
+      stage("preprocess"),
+      stage("decode"),
+      stage("total")
+    });
+  }
+  return metrics.get();
+}
+
+void record_block_metrics(BlockMetrics& metrics, const StageTimings& timings, double totalMs, const string& results)
+{
+  metrics.runs->Add();
+
+  if (results.compare(0, 9, "{\"error\":") == 0) {
+    metrics.errors->Add();
+  } else {
+    // One "type" key per decoded symbol
+    uint64_t symbols = 0;
+    for (size_t pos = results.find("{\"type\":"); pos != string::npos; pos = results.find("{\"type\":", pos + 1)) {
+      symbols++;
+    }
+    metrics.symbols->Add(symbols);
+  }
+
+  // Optional stages only when they ran
+  if (timings.inputDecodeMs > 0) {
+    metrics.inputDecode->Observe(timings.inputDecodeMs);
+  }
+  if (timings.colorConversionMs > 0) {
+    metrics.colorConversion->Observe(timings.colorConversionMs);
+  }
+  if (timings.scaleMs > 0) {
+    metrics.scale->Observe(timings.scaleMs);
+  }
+  metrics.preprocess->Observe(timings.preprocessMs);
+  metrics.decode->Observe(timings.decodeMs);
+  metrics.total->Observe(totalMs);
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "decoder.h"
+#include "metrics.h"
+#include "trace.h"
+
+// Per-block stage durations in milliseconds (steady_clock)
+struct StageTimings {
+  double inputDecodeMs = 0;      // imdecode of an encoded input
+  double colorConversionMs = 0;  // raw RGB/RGBA input to BGR/BGRA
+  double scaleMs = 0;            // block downscale
+  double preprocessMs = 0;       // preprocessing stage
+  double decodeMs = 0;           // decoder call
+};
+
+// One block of the node: preprocessing + decoder, optional downscale
+struct BlockConfig {
+  std::string decoder;        // "zbar" or "zxing"
+  std::string preprocessing;  // "original", "histogram" or "otsu"
+  double scale = 1.0;
+  ZBarOptions zbar;
+  ZXingOptions zxing;
+};
+
+// Adds the time spent in its scope to *target (no-op when target is null)
+// and, while tracing, records it as a span named `span`
+class ScopedTimer {
+public:
+  explicit ScopedTimer(double* target, const char* span = nullptr)
+    : target_(target), span_(span), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    auto end = std::chrono::steady_clock::now();
+    if (target_ != nullptr) {
+      *target_ += std::chrono::duration<double, std::milli>(end - start_).count();
+    }
+    if (span_ != nullptr && trace_enabled()) {
+      trace_span(span_, ToUs(start_), ToUs(end));
+    }
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+  static uint64_t ToUs(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+  }
+
+  double* target_;
+  const char* span_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Run one block on a BGR/BGRA/GRAY image. Returns the decoder JSON; result
+// points are in the coordinates of the (scaled) image the decoder saw.
+std::string run_block(const cv::Mat& input, const BlockConfig& block, StageTimings& timings);
+
+// Channel count and OpenCV type of a colour space name (GRAY, RGB, BGR,
+// RGBA, BGRA); false for unknown names
+bool color_space_type(const std::string& colorSpace, int& channels, int& cvType);
+
+// Raw 8-bit pixels as a BGR/BGRA/GRAY Mat. GRAY, BGR and BGRA rows are
+// wrapped in place (the caller keeps them alive), RGB and RGBA are converted
+// into a new Mat. Returns an empty Mat and sets errorMsg on failure.
+cv::Mat wrap_pixels(const uint8_t* data, int width, int height, size_t stride, const std::string& colorSpace,
+                    std::string& errorMsg, StageTimings* timings = nullptr);
+
+// Decode an encoded image (JPEG, PNG, TIFF, ...) with OpenCV, keeping its
+// channels; images with 16 bits per sample are scaled to 8 bits. Returns an
+// empty Mat and sets errorMsg on failure.
+cv::Mat decode_image_buffer(const uint8_t* data, size_t length, std::string& errorMsg, StageTimings* timings = nullptr);
+
+// Decode an encoded image to grayscale at 1/reduce of its size (reduce: 1, 2,
+// 4 or 8). JPEG is scaled inside the IDCT, so a reduced decode skips most of
+// the decoding work; other formats are decoded and then resized. Returns an
+// empty Mat and sets errorMsg on failure.
+cv::Mat decode_image_reduced(const uint8_t* data, size_t length, int reduce, std::string& errorMsg,
+                             StageTimings* timings = nullptr);
+
+// decode_image_buffer() of a file read with pread(); files are not mapped, so
+// one overwritten or truncated while it is decoded fails instead of raising
+// SIGBUS
+cv::Mat decode_image_file(const std::string& path, std::string& errorMsg, StageTimings* timings = nullptr);
+
+// Decode one page of an encoded multi-page image (TIFF) in memory; page 0 of
+// any other format is its only image. Only that page is decoded, so the pages
+// of a large document can be streamed one at a time.
+cv::Mat decode_image_page(const uint8_t* data, size_t length, int page, std::string& errorMsg,
+                          StageTimings* timings = nullptr);
+
+// decode_image_page() of a file read with pread(), as decode_image_file()
+cv::Mat decode_image_file_page(const std::string& path, int page, std::string& errorMsg,
+                               StageTimings* timings = nullptr);
+
+// Number of pages of an image file (1 for single-image formats), read from
+// the page directory without decoding pixels. Returns 0 and sets errorMsg on
+// failure.
+int image_file_pages(const std::string& path, std::string& errorMsg);
+
+// Block configuration of a node: { blocks: [{ decoder, preprocessing, scale,
+// options }], executionMode: "parallel" | "sequential" }
+struct PipelineConfig {
+  std::vector<BlockConfig> blocks;
+  bool sequential = false;  // stop at the first block that decodes something
+};
+
+// Read a configuration from its JSON text, with the defaults of the node.
+// Returns false and sets errorMsg for invalid JSON or blocks that cannot
+// run natively (Quagga2).
+bool read_pipeline_config(const std::string& json, PipelineConfig& config, std::string& errorMsg);
+
+// Run every block over a BGR/BGRA/GRAY image, deduplicate the detections and
+// convert them to the node's output format. This mirrors, by hand,
+// processSingleImage() of lib/pipeline.js for ZBar and ZXing blocks: change
+// both together and check them with tools/parity.js. Returns the results as a
+// JSON array formatted like JSON.stringify; failed blocks are skipped and
+// reported in warnings.
+std::string run_pipeline(const cv::Mat& image, const PipelineConfig& config, std::vector<std::string>& warnings);
+
+// A symbol found by the pipeline, corners in input pixels
+struct Detection {
+  std::string type;
+  std::string data;
+  double points[8];  // x1, y1, x2, y2, x3, y3, x4, y4
+  size_t blockIndex;
+  std::string decoder;
+  std::string preprocessing;
+  std::vector<std::string> detectedBy;
+};
+
+// The deduplicated detections of run_pipeline(), before the output format
+std::vector<Detection> run_pipeline_detections(const cv::Mat& image, const PipelineConfig& config,
+                                               std::vector<std::string>& warnings);
+
+// One detection in the node's output format, coordinates divided by width
+// and height (1 and 1 for pixels)
+std::string detection_json(const Detection& detection, double width, double height);
+
+// Metric series of one block of one node (labels: node, block, decoder,
+// preprocessing); the same labels always return the same instance
+struct BlockMetrics {
+  MetricCounter* runs;
+  MetricCounter* errors;
+  MetricCounter* symbols;
+  MetricHistogram* inputDecode;
+  MetricHistogram* colorConversion;
+  MetricHistogram* scale;
+  MetricHistogram* preprocess;
+  MetricHistogram* decode;
+  MetricHistogram* total;
+};
+
+BlockMetrics* metrics_block(const MetricLabels& labels);
+
+// Count a run_block call and its decoded symbols or error, observe its stages
+void record_block_metrics(BlockMetrics& metrics, const StageTimings& timings, double totalMs, const std::string& results);
@@ -0,0 +1,289 @@
+#include "record.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char RECORD_MAGIC[8] = {'R', 'P', 'B', 'R', 'E', 'C', '0', '1'};
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t committed;
+  uint64_t records;
+};
+
+struct RecordHeader {
+  uint32_t kind;
+  uint32_t metaLength;
+  uint64_t dataLength;
+};
+
+// Grow the file at least this much at a time, so small frames do not remap on every append
+static const uint64_t MIN_GROWTH = 16 * 1024 * 1024;
+
+static uint64_t Align8(uint64_t value)
+{
+  return (value + 7) & ~static_cast<uint64_t>(7);
+}
+
+static bool ValidHeader(const FileHeader* header, size_t fileSize)
+{
+  return memcmp(header->magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) == 0 &&
+         header->version == RECORD_VERSION &&
+         header->headerSize == sizeof(FileHeader) &&
+         header->committed >= sizeof(FileHeader) &&
+         header->committed <= fileSize;
+}
+
+RecordWriter::~RecordWriter()
+{
+  Close();
+}
+
+unique_ptr<RecordWriter> RecordWriter::Open(const string& path, uint64_t maxBytes, string& errorMsg)
+{
+  int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    errorMsg = "open(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    errorMsg = "fstat(" + path + ") failed: " + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+
+  unique_ptr<RecordWriter> writer(new RecordWriter());
+  writer->path_ = path;
+  writer->fd_ = fd;
+  writer->maxBytes_ = maxBytes;
+
+  uint64_t existing = static_cast<uint64_t>(st.st_size);
+  if (existing == 0) {
+    if (!writer->Reserve(sizeof(FileHeader), errorMsg)) {
+      return nullptr;
+    }
+    FileHeader* header = reinterpret_cast<FileHeader*>(writer->map_);
+    memcpy(header->magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+    header->version = RECORD_VERSION;
+    header->headerSize = sizeof(FileHeader);
+    header->records = 0;
+    header->committed = sizeof(FileHeader);
+    return writer;
+  }
+
+  if (existing < sizeof(FileHeader)) {
+    errorMsg = path + " is not a barcode capture file";
+    return nullptr;
+  }
+
+  void* address = mmap(nullptr, existing, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    errorMsg = "mmap(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+  writer->map_ = static_cast<unsigned char*>(address);
+  writer->mapped_ = existing;
+
+  if (!ValidHeader(reinterpret_cast<const FileHeader*>(writer->map_), existing)) {
+    // Unmap before Close() could truncate a file that is not ours
+    munmap(writer->map_, existing);
+    writer->map_ = nullptr;
+    errorMsg = path + " is not a barcode capture file (version " + to_string(RECORD_VERSION) + ")";
+    return nullptr;
+  }
+  return writer;
+}
+
+bool RecordWriter::Reserve(uint64_t bytes, string& errorMsg)
+{
+  if (bytes <= mapped_) {
+    return true;
+  }
+
+  uint64_t size = max({bytes, mapped_ * 2, MIN_GROWTH});
+  if (maxBytes_ > 0) {
+    size = max(bytes, min(size, maxBytes_));
+  }
+  long page = sysconf(_SC_PAGESIZE);
+  size = (size + page - 1) / page * page;
+
+  if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    errorMsg = "ftruncate(" + path_ + ") failed: " + strerror(errno);
+    return false;
+  }
+
+#ifdef __linux__
+  // Reserve the blocks now, so a full disk fails here instead of raising SIGBUS on a write
+  int err = posix_fallocate(fd_, static_cast<off_t>(mapped_), static_cast<off_t>(size - mapped_));
+  if (err != 0) {
+    errorMsg = "posix_fallocate(" + path_ + ") failed: " + strerror(err);
+    return false;
+  }
+#endif
+
+  void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (address == MAP_FAILED) {
+    errorMsg = "mmap(" + path_ + ") failed: " + strerror(errno);
+    return false;
+  }
+  if (map_ != nullptr) {
+    munmap(map_, mapped_);
+  }
+  map_ = static_cast<unsigned char*>(address);
+  mapped_ = size;
+  return true;
+}
+
+bool RecordWriter::Append(RecordKind kind, const string& meta, const uint8_t* data, size_t length, string& errorMsg)
+{
+  lock_guard<mutex> lock(mutex_);
+
+  if (map_ == nullptr) {
+    errorMsg = "Capture file is closed";
+    return false;
+  }
+
+  uint64_t start = reinterpret_cast<FileHeader*>(map_)->committed;
+  uint64_t end = start + Align8(sizeof(RecordHeader) + meta.size() + length);
+  if (maxBytes_ > 0 && end > maxBytes_) {
+    errorMsg = "Capture file limit reached (" + to_string(maxBytes_) + " bytes)";
+    return false;
+  }
+  if (!Reserve(end, errorMsg)) {
+    return false;
+  }
+
+  RecordHeader* record = reinterpret_cast<RecordHeader*>(map_ + start);
+  record->kind = kind;
+  record->metaLength = static_cast<uint32_t>(meta.size());
+  record->dataLength = length;
+  memcpy(map_ + start + sizeof(RecordHeader), meta.data(), meta.size());
+  if (length > 0) {
+    memcpy(map_ + start + sizeof(RecordHeader) + meta.size(), data, length);
+  }
+
+  // Publish the record only after its bytes are in place
+  FileHeader* header = reinterpret_cast<FileHeader*>(map_);
+  atomic_thread_fence(memory_order_release);
+  header->records++;
+  header->committed = end;
+  return true;
+}
+
+void RecordWriter::Close()
+{
+  lock_guard<mutex> lock(mutex_);
+
+  if (map_ != nullptr) {
+    uint64_t committed = reinterpret_cast<FileHeader*>(map_)->committed;
+    munmap(map_, mapped_);
+    map_ = nullptr;
+    mapped_ = 0;
+    if (ftruncate(fd_, static_cast<off_t>(committed)) != 0) {
+      // The trailing reserved space is ignored by readers anyway
+    }
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+uint64_t RecordWriter::committed() const
+{
+  lock_guard<mutex> lock(mutex_);
+  return map_ != nullptr ? reinterpret_cast<const FileHeader*>(map_)->committed : 0;
+}
+
+uint64_t RecordWriter::records() const
+{
+  lock_guard<mutex> lock(mutex_);
+  return map_ != nullptr ? reinterpret_cast<const FileHeader*>(map_)->records : 0;
+}
+
+RecordFile::~RecordFile()
+{
+  if (map != nullptr) {
+    munmap(const_cast<unsigned char*>(map), size);
+  }
+}
+
+shared_ptr<const RecordFile> record_read(const string& path, string& errorMsg)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    errorMsg = "open(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    errorMsg = "fstat(" + path + ") failed: " + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size < sizeof(FileHeader)) {
+    errorMsg = path + " is not a barcode capture file";
+    close(fd);
+    return nullptr;
+  }
+
+  void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    errorMsg = "mmap(" + path + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  auto file = make_shared<RecordFile>();
+  file->path = path;
+  file->map = static_cast<const unsigned char*>(address);
+  file->size = size;
+
+  const FileHeader* header = reinterpret_cast<const FileHeader*>(file->map);
+  if (!ValidHeader(header, size)) {
+    errorMsg = path + " is not a barcode capture file (version " + to_string(RECORD_VERSION) + ")";
+    return nullptr;
+  }
+
+  // Frames are replayed sequentially
+  madvise(address, size, MADV_SEQUENTIAL);
+
+  uint64_t offset = sizeof(FileHeader);
+  while (offset + sizeof(RecordHeader) <= header->committed) {
+    const RecordHeader* record = reinterpret_cast<const RecordHeader*>(file->map + offset);
+    // Checked step by step: a corrupt length must not wrap the sum
+    uint64_t available = header->committed - offset - sizeof(RecordHeader);
+    if (record->metaLength > available || record->dataLength > available - record->metaLength) {
+      errorMsg = path + " is corrupt at offset " + to_string(offset);
+      return nullptr;
+    }
+    uint64_t payload = sizeof(RecordHeader) + static_cast<uint64_t>(record->metaLength) + record->dataLength;
+
+    const unsigned char* meta = file->map + offset + sizeof(RecordHeader);
+    file->entries.push_back({
+      static_cast<RecordKind>(record->kind),
+      reinterpret_cast<const char*>(meta),
+      record->metaLength,
+      meta + record->metaLength,
+      static_cast<size_t>(record->dataLength)
+    });
+    offset += Align8(payload);
+  }
+  return file;
+}
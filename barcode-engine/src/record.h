@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Append-only traffic capture file, written and read through mmap.
+//
+// Layout (little endian, every record 8-byte aligned):
+//   file header   "RPBREC01", u32 version, u32 header size, u64 committed bytes, u64 record count
+//   record        u32 kind, u32 meta length, u64 data length, meta (JSON), data, padding
+//
+// The header's committed length only moves past a record once the record is
+// fully written, so a file left by a crashed writer is read up to its last
+// complete record. Writers and readers of this format must agree on
+// RECORD_VERSION.
+
+const uint32_t RECORD_VERSION = 1;
+
+enum RecordKind : uint32_t {
+  RECORD_CONFIG = 1,  // node configuration, meta only
+  RECORD_FRAME = 2    // message metadata + image bytes (encoded or raw pixels)
+};
+
+class RecordWriter {
+public:
+  ~RecordWriter();
+
+  // Open a capture for appending: a new file is created, an existing capture
+  // is continued after its last complete record. Returns nullptr and sets
+  // errorMsg on failure. maxBytes (0 = unlimited) bounds the file size.
+  static std::unique_ptr<RecordWriter> Open(const std::string& path, uint64_t maxBytes, std::string& errorMsg);
+
+  // Copy one record into the mapping. Returns false and sets errorMsg when
+  // the file would exceed maxBytes or cannot grow.
+  bool Append(RecordKind kind, const std::string& meta, const uint8_t* data, size_t length, std::string& errorMsg);
+
+  // Truncate the file to its committed length and unmap it
+  void Close();
+
+  uint64_t committed() const;
+  uint64_t records() const;
+
+  RecordWriter(const RecordWriter&) = delete;
+  RecordWriter& operator=(const RecordWriter&) = delete;
+
+private:
+  RecordWriter() = default;
+  bool Reserve(uint64_t bytes, std::string& errorMsg);
+
+  mutable std::mutex mutex_;
+  std::string path_;
+  int fd_ = -1;
+  unsigned char* map_ = nullptr;
+  uint64_t mapped_ = 0;
+  uint64_t maxBytes_ = 0;
+};
+
+// Read-only mapping of a capture file; records point into it
+struct RecordFile {
+  struct Entry {
+    RecordKind kind;
+    const char* meta;
+    size_t metaLength;
+    const uint8_t* data;
+    size_t dataLength;
+  };
+
+  std::string path;
+  const unsigned char* map = nullptr;
+  size_t size = 0;
+  std::vector<Entry> entries;
+  ~RecordFile();
+};
+
+// Map a capture file and index its complete records.
+// Returns nullptr and sets errorMsg on failure.
+std::shared_ptr<const RecordFile> record_read(const std::string& path, std::string& errorMsg);
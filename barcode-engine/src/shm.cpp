@@ -0,0 +1,166 @@
+#include "shm.h"
+#include "affinity.h"
+#include "metrics.h"
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Mapping cache shared by every addon instance (and worker thread) in the process
+static mutex cacheMutex;
+static unordered_map<string, shared_ptr<const ShmSegment>> cache;
+
+ShmSegment::~ShmSegment()
+{
+  if (data != nullptr) {
+    munmap(const_cast<unsigned char*>(data), size);
+  }
+}
+
+static string NormalizeName(const string& name)
+{
+  return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+// Map an open segment; the caller closes fd
+static shared_ptr<const ShmSegment> MapSegment(const string& name, int fd, const struct stat& st, size_t requiredBytes,
+                                               string& errorMsg)
+{
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0 || size < requiredBytes) {
+    errorMsg = "Shared memory segment " + name + " is too small: " + to_string(size) +
+               " bytes, frame needs " + to_string(requiredBytes);
+    return nullptr;
+  }
+
+  void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    errorMsg = "mmap(" + name + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  auto segment = make_shared<ShmSegment>();
+  segment->name = name;
+  segment->data = static_cast<const unsigned char*>(address);
+  segment->size = size;
+  segment->device = static_cast<uint64_t>(st.st_dev);
+  segment->inode = static_cast<uint64_t>(st.st_ino);
+  return segment;
+}
+
+shared_ptr<const ShmSegment> shm_map(const string& rawName, size_t requiredBytes, string& errorMsg)
+{
+  static MetricCounter* hits = metrics_counter("barcode_shm_cache_lookups", {{"result", "hit"}});
+  static MetricCounter* misses = metrics_counter("barcode_shm_cache_lookups", {{"result", "miss"}});
+
+  const string name = NormalizeName(rawName);
+
+  lock_guard<mutex> lock(cacheMutex);
+
+  // The name is looked up on every frame: a producer may have recreated the
+  // segment (new object, old mapping stale) or resized it (SIGBUS past its end)
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    errorMsg = "shm_open(" + name + ") failed: " + strerror(errno);
+    cache.erase(name);
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    errorMsg = "fstat(" + name + ") failed: " + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+
+  auto it = cache.find(name);
+  if (it != cache.end() && it->second->device == static_cast<uint64_t>(st.st_dev) &&
+      it->second->inode == static_cast<uint64_t>(st.st_ino) && it->second->size == static_cast<size_t>(st.st_size) &&
+      it->second->size >= requiredBytes) {
+    close(fd);
+    hits->Add();
+    return it->second;
+  }
+  misses->Add();
+
+  // Not mapped yet, or the producer replaced or resized the segment: map it again
+  auto segment = MapSegment(name, fd, st, requiredBytes, errorMsg);
+  close(fd);
+  if (segment) {
+    cache[name] = segment;
+  } else {
+    cache.erase(name);
+  }
+  return segment;
+}
+
+bool shm_release(const string& rawName)
+{
+  lock_guard<mutex> lock(cacheMutex);
+  return cache.erase(NormalizeName(rawName)) > 0;
+}
+
+unsigned char* shm_create(const string& rawName, size_t size, int numaNode, string& errorMsg)
+{
+  const string name = NormalizeName(rawName);
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+  if (fd < 0) {
+    errorMsg = "shm_open(" + name + ") failed: " + strerror(errno);
+    return nullptr;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    errorMsg = "ftruncate(" + name + ") failed: " + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+
+  void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    errorMsg = "mmap(" + name + ") failed: " + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+
+  // The policy set through the mapping applies to the shared object itself,
+  // so the reservation below already places the pages on the requested node
+  if (numaNode >= 0 && !numa_bind_memory(address, size, numaNode, errorMsg)) {
+    munmap(address, size);
+    close(fd);
+    return nullptr;
+  }
+
+#ifdef __linux__
+  int err = posix_fallocate(fd, 0, static_cast<off_t>(size));
+  if (err != 0) {
+    errorMsg = "posix_fallocate(" + name + ") failed: " + strerror(err);
+    munmap(address, size);
+    close(fd);
+    return nullptr;
+  }
+#endif
+
+  close(fd);
+  return static_cast<unsigned char*>(address);
+}
+
+void shm_unmap(unsigned char* data, size_t size)
+{
+  if (data != nullptr) {
+    munmap(data, size);
+  }
+}
+
+bool shm_unlink_segment(const string& rawName)
+{
+  return shm_unlink(NormalizeName(rawName).c_str()) == 0;
+}
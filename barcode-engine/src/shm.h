@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Read-only mapping of a POSIX shared-memory segment.
+// The segment stays mapped while any shared_ptr to it is alive.
+struct ShmSegment {
+  std::string name;
+  const unsigned char* data = nullptr;
+  size_t size = 0;
+  // Identity of the shared object, to notice a segment recreated under the same name
+  uint64_t device = 0;
+  uint64_t inode = 0;
+  ~ShmSegment();
+};
+
+// Map a segment by name (leading '/' optional), reusing the cached mapping
+// while the name still refers to the same object of the same size and it covers
+// requiredBytes. A segment recreated, grown or shrunk by its producer is mapped
+// again. Returns nullptr and sets errorMsg on failure.
+std::shared_ptr<const ShmSegment> shm_map(const std::string& name, size_t requiredBytes, std::string& errorMsg);
+
+// Drop the cached mapping of a segment; in-flight users keep it mapped until they finish
+bool shm_release(const std::string& name);
+
+// Create (or resize) a writable segment for a producer and map it. On Linux the
+// memory is reserved up front so a full /dev/shm fails here instead of raising
+// SIGBUS on first write; with numaNode >= 0 it is reserved on that NUMA node.
+// Returns nullptr and sets errorMsg on failure.
+unsigned char* shm_create(const std::string& name, size_t size, int numaNode, std::string& errorMsg);
+
+// Unmap a segment returned by shm_create
+void shm_unmap(unsigned char* data, size_t size);
+
+// Remove a segment name; existing mappings stay valid
+bool shm_unlink_segment(const std::string& name);
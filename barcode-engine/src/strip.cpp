@@ -0,0 +1,161 @@
+#include "strip.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Same bounds as whole images: window side and window bytes
+static const int MAX_IMAGE_DIMENSION = 32768;
+static const size_t MAX_WINDOW_BYTES = 500 * 1024 * 1024;
+
+static string JoinResults(const vector<string>& found)
+{
+  string json = "[";
+  for (size_t i = 0; i < found.size(); i++) {
+    json += (i > 0 ? "," : "") + found[i];
+  }
+  return json + "]";
+}
+
+unique_ptr<StripScanner> StripScanner::Create(const PipelineConfig& config, int width, const string& colorSpace,
+                                              int symbolRows, string& errorMsg)
+{
+  int channels = 0;
+  int cvType = 0;
+  if (!color_space_type(colorSpace, channels, cvType)) {
+    errorMsg = "Unsupported colorSpace: " + colorSpace + ". Supported values: GRAY, RGB, BGR, RGBA, BGRA";
+    return nullptr;
+  }
+  if (width <= 0 || width > MAX_IMAGE_DIMENSION) {
+    errorMsg = "Invalid strip width " + to_string(width) + " (max: " + to_string(MAX_IMAGE_DIMENSION) + ")";
+    return nullptr;
+  }
+  if (symbolRows < 8 || symbolRows > MAX_IMAGE_DIMENSION / 2) {
+    errorMsg = "Invalid symbol height " + to_string(symbolRows) + " rows (8 to " +
+               to_string(MAX_IMAGE_DIMENSION / 2) + ")";
+    return nullptr;
+  }
+  size_t windowBytes = static_cast<size_t>(2 * symbolRows) * width * channels;
+  if (windowBytes > MAX_WINDOW_BYTES) {
+    errorMsg = "Window of " + to_string(2 * symbolRows) + " rows of " + to_string(width) + " pixels exceeds " +
+               to_string(MAX_WINDOW_BYTES) + " bytes";
+    return nullptr;
+  }
+
+  unique_ptr<StripScanner> scanner(new StripScanner());
+  scanner->config_ = config;
+  scanner->width_ = width;
+  scanner->colorSpace_ = colorSpace;
+  scanner->channels_ = channels;
+  scanner->symbolRows_ = symbolRows;
+  // Colour strips are stored converted, like whole images
+  int windowType = channels == 1 ? CV_8UC1 : (channels == 3 ? CV_8UC3 : CV_8UC4);
+  scanner->window_.create(2 * symbolRows, width, windowType);
+  return scanner;
+}
+
+bool StripScanner::Append(const uint8_t* data, int rows, size_t stride, string& results,
+                          vector<string>& warnings, string& errorMsg)
+{
+  if (finished_) {
+    errorMsg = "Strip scan already finished";
+    return false;
+  }
+  size_t rowBytes = static_cast<size_t>(width_) * channels_;
+  if (stride == 0) {
+    stride = rowBytes;
+  }
+  if (data == nullptr || rows <= 0 || stride < rowBytes) {
+    errorMsg = "Invalid strip (rows: " + to_string(rows) + ", stride: " + to_string(stride) + ")";
+    return false;
+  }
+
+  vector<string> found;
+  while (rows > 0) {
+    // Slide: the newest symbolRows rows move to the top of the window
+    if (filled_ == window_.rows) {
+      window_.rowRange(symbolRows_, window_.rows).copyTo(window_.rowRange(0, symbolRows_));
+      top_ += symbolRows_;
+      filled_ = symbolRows_;
+    }
+
+    int count = min(rows, window_.rows - filled_);
+    cv::Mat strip = wrap_pixels(data, width_, count, stride, colorSpace_, errorMsg);
+    if (strip.empty()) {
+      return false;
+    }
+    strip.copyTo(window_.rowRange(filled_, filled_ + count));
+    filled_ += count;
+    pending_ += count;
+    data += count * stride;
+    rows -= count;
+
+    if (filled_ == window_.rows) {
+      Decode(filled_, found, warnings);
+    }
+  }
+
+  results = JoinResults(found);
+  return true;
+}
+
+void StripScanner::Finish(string& results, vector<string>& warnings)
+{
+  vector<string> found;
+  if (!finished_ && pending_ > 0) {
+    Decode(filled_, found, warnings);
+  }
+  finished_ = true;
+  results = JoinResults(found);
+}
+
+void StripScanner::Decode(int rows, vector<string>& found, vector<string>& warnings)
+{
+  pending_ = 0;
+  vector<Detection> detections = run_pipeline_detections(window_.rowRange(0, rows), config_, warnings);
+
+  // Slack for corner jitter between two views of the same symbol
+  const double margin = symbolRows_ / 8.0;
+
+  // Detections of this window end at row top_ or below: symbols that ended
+  // above it cannot overlap them
+  while (!seen_.empty() && seen_.front().bottom + margin < static_cast<double>(top_)) {
+    seen_.pop_front();
+  }
+
+  for (Detection& detection : detections) {
+    Seen box = {detection.type, detection.data, HUGE_VAL, -HUGE_VAL, HUGE_VAL, -HUGE_VAL};
+    for (int i = 0; i < 4; i++) {
+      double& x = detection.points[2 * i];
+      double& y = detection.points[2 * i + 1];
+      y += static_cast<double>(top_);
+      box.left = min(box.left, x);
+      box.right = max(box.right, x);
+      box.top = min(box.top, y);
+      box.bottom = max(box.bottom, y);
+    }
+
+    // A symbol cut by a window boundary is found again by the next window,
+    // whole or (1D codes decode from a slice) in part: same value, overlapping
+    // box. The box grows with every view, so later slices still match.
+    auto repeated = find_if(seen_.begin(), seen_.end(), [&](const Seen& seen) {
+      return seen.type == box.type && seen.data == box.data &&
+             seen.left - margin <= box.right && box.left - margin <= seen.right &&
+             seen.top - margin <= box.bottom && box.top - margin <= seen.bottom;
+    });
+    if (repeated != seen_.end()) {
+      repeated->left = min(repeated->left, box.left);
+      repeated->right = max(repeated->right, box.right);
+      repeated->top = min(repeated->top, box.top);
+      repeated->bottom = max(repeated->bottom, box.bottom);
+      continue;
+    }
+
+    seen_.push_back(box);
+    found.push_back(detection_json(detection, 1, 1));
+  }
+
+  // Ordered by last row for pruning
+  sort(seen_.begin(), seen_.end(), [](const Seen& a, const Seen& b) { return a.bottom < b.bottom; });
+}
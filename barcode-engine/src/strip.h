@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "pipeline.h"
+
+// Streaming decode of a line-scan image that never forms a complete frame.
+//
+// Rows arrive in strips of any height. The scanner keeps a window of the
+// last 2 x symbolRows rows and runs the pipeline each time symbolRows new
+// rows have arrived, so every symbol up to symbolRows tall lies whole in at
+// least one window. A symbol that straddles a window boundary is found by
+// two consecutive windows and reported once. Memory is the window, however
+// long the scan runs.
+//
+// Not thread-safe: the strips of one scan are appended in order.
+class StripScanner {
+public:
+  // Scanner for strips `width` pixels wide in colorSpace (GRAY, BGR, RGB,
+  // BGRA or RGBA). Returns nullptr and sets errorMsg for invalid settings.
+  static std::unique_ptr<StripScanner> Create(const PipelineConfig& config, int width, const std::string& colorSpace,
+                                              int symbolRows, std::string& errorMsg);
+
+  // Append `rows` rows, `stride` bytes apart (0 = packed). Sets results to a
+  // JSON array of the symbols found in the windows these rows completed, in
+  // the node's output format but in pixels, y counted from the first row of
+  // the scan. Returns false and sets errorMsg for invalid input or after
+  // Finish().
+  bool Append(const uint8_t* data, int rows, size_t stride, std::string& results,
+              std::vector<std::string>& warnings, std::string& errorMsg);
+
+  // Decode the rows that no complete window has covered yet and end the scan
+  void Finish(std::string& results, std::vector<std::string>& warnings);
+
+  // Rows appended since the start of the scan
+  uint64_t rows() const { return top_ + filled_; }
+
+  // Bytes of one packed row of a strip
+  size_t rowBytes() const { return static_cast<size_t>(width_) * channels_; }
+
+private:
+  // Bounding box of a reported symbol, in scan pixels
+  struct Seen {
+    std::string type;
+    std::string data;
+    double left;
+    double right;
+    double top;
+    double bottom;
+  };
+
+  StripScanner() = default;
+
+  // Run the pipeline over the first `rows` rows of the window
+  void Decode(int rows, std::vector<std::string>& found, std::vector<std::string>& warnings);
+
+  PipelineConfig config_;
+  int width_ = 0;
+  std::string colorSpace_;
+  int channels_ = 0;
+  int symbolRows_ = 0;
+  cv::Mat window_;        // 2 x symbolRows rows, BGR/BGRA/GRAY
+  uint64_t top_ = 0;      // scan row of the first window row
+  int filled_ = 0;        // window rows holding data
+  int pending_ = 0;       // rows not yet covered by a decoded window
+  bool finished_ = false;
+  std::deque<Seen> seen_; // reported symbols that a later window may find again
+};
@@ -0,0 +1,182 @@
+#include "trace.h"
+#include "json.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct TraceEvent {
+  const char* name;
+  uint64_t startUs;
+  uint64_t durUs;
+  uint32_t tid;
+  int32_t block;
+  int64_t image;
+};
+
+static atomic<bool> enabled{false};
+
+// Ring buffer; the lock is only taken while tracing is enabled
+static mutex ringMutex;
+static vector<TraceEvent> ring;
+static uint64_t written = 0;
+
+static mutex namesMutex;
+static set<string> internedNames;
+static map<uint32_t, string> threadNames;
+
+static thread_local int64_t currentImage = -1;
+static thread_local int currentBlock = -1;
+
+static uint32_t CurrentTid()
+{
+#ifdef __linux__
+  static thread_local uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+  static thread_local uint32_t tid = static_cast<uint32_t>(hash<thread::id>()(this_thread::get_id()));
+#endif
+  return tid;
+}
+
+static int CurrentPid()
+{
+#ifdef _WIN32
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+
+void trace_start(size_t capacity)
+{
+  lock_guard<mutex> lock(ringMutex);
+  ring.assign(capacity > 0 ? capacity : 1, TraceEvent{});
+  written = 0;
+  enabled.store(true, memory_order_release);
+}
+
+void trace_stop()
+{
+  enabled.store(false, memory_order_release);
+}
+
+bool trace_enabled()
+{
+  return enabled.load(memory_order_relaxed);
+}
+
+uint64_t trace_now_us()
+{
+  return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TraceScope::TraceScope(int64_t image, int block) : previousImage_(currentImage), previousBlock_(currentBlock)
+{
+  currentImage = image;
+  currentBlock = block;
+}
+
+TraceScope::~TraceScope()
+{
+  currentImage = previousImage_;
+  currentBlock = previousBlock_;
+}
+
+void trace_span(const char* name, uint64_t startUs, uint64_t endUs, int64_t image, int block)
+{
+  if (!trace_enabled()) {
+    return;
+  }
+
+  TraceEvent event{
+    name,
+    startUs,
+    endUs > startUs ? endUs - startUs : 0,
+    CurrentTid(),
+    block >= 0 ? block : currentBlock,
+    image >= 0 ? image : currentImage
+  };
+
+  lock_guard<mutex> lock(ringMutex);
+  if (!ring.empty()) {
+    ring[written % ring.size()] = event;
+    written++;
+  }
+}
+
+const char* trace_intern(const string& name)
+{
+  lock_guard<mutex> lock(namesMutex);
+  return internedNames.insert(name).first->c_str();
+}
+
+void trace_thread_name(const string& name)
+{
+  lock_guard<mutex> lock(namesMutex);
+  threadNames[CurrentTid()] = name;
+}
+
+string trace_events_json()
+{
+  vector<TraceEvent> events;
+  {
+    lock_guard<mutex> lock(ringMutex);
+    size_t count = written < ring.size() ? static_cast<size_t>(written) : ring.size();
+    size_t first = static_cast<size_t>((written - count) % (ring.empty() ? 1 : ring.size()));
+    events.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      events.push_back(ring[(first + i) % ring.size()]);
+    }
+  }
+
+  const string pid = to_string(CurrentPid());
+  string json = "[";
+  bool first = true;
+  auto separator = [&json, &first]() {
+    if (!first) {
+      json += ",\n";
+    }
+    first = false;
+  };
+
+  {
+    lock_guard<mutex> lock(namesMutex);
+    for (const auto& thread : threadNames) {
+      separator();
+      json += "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " + pid +
+              ", \"tid\": " + to_string(thread.first) +
+              ", \"args\": {\"name\": " + json_string(thread.second) + "}}";
+    }
+  }
+
+  for (const TraceEvent& event : events) {
+    separator();
+    json += "{\"name\": " + json_string(event.name) + ", \"cat\": \"barcode\", \"ph\": \"X\"" +
+            ", \"ts\": " + to_string(event.startUs) +
+            ", \"dur\": " + to_string(event.durUs) +
+            ", \"pid\": " + pid +
+            ", \"tid\": " + to_string(event.tid) +
+            ", \"args\": {\"image\": " + to_string(event.image) +
+            ", \"block\": " + to_string(event.block) + "}}";
+  }
+
+  json += "]";
+  return json;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Opt-in span tracing in the Chrome trace-event format. Completed spans go
+// to a fixed-size ring buffer shared by every thread of the process (oldest
+// spans are overwritten) and are serialized on demand; nothing is recorded
+// until trace_start() is called.
+
+// Enable tracing with room for `capacity` spans, dropping earlier spans
+void trace_start(size_t capacity);
+void trace_stop();
+bool trace_enabled();
+
+// Microseconds on the trace clock (steady_clock, CLOCK_MONOTONIC on Linux)
+uint64_t trace_now_us();
+
+// Frame and block the calling thread is working on; spans recorded while a
+// TraceScope is alive carry them as args
+class TraceScope {
+public:
+  TraceScope(int64_t image, int block);
+  ~TraceScope();
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  int64_t previousImage_;
+  int previousBlock_;
+};
+
+// Record a completed span of the calling thread. `name` must outlive the
+// trace (a literal or trace_intern()); image/block -1 take the TraceScope's.
+void trace_span(const char* name, uint64_t startUs, uint64_t endUs, int64_t image = -1, int block = -1);
+
+// Stable copy of a dynamic span name
+const char* trace_intern(const std::string& name);
+
+// Name shown for the calling thread
+void trace_thread_name(const std::string& name);
+
+// Recorded spans and thread names as a JSON array of trace events
+std::string trace_events_json();
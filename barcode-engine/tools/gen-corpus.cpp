@@ -0,0 +1,448 @@
+/*
+Synthetic barcode corpus generator.
+
+Renders barcodes with ZXing's writer and degrades them the way inspection
+cameras do (module size, rotation, blur, noise, contrast, inversion, several
+codes per frame, frame resolution). Every image is written as a PNG and
+described, together with its ground truth, in manifest.json.
+
+The corpus only depends on the seed: randomness comes from std::mt19937 (whose
+output sequence is fixed by the standard) without std:: distributions (which
+are implementation defined), and pixel noise from cv::RNG.
+
+Usage: barcode_gen_corpus --out DIR [--count N] [--seed S] [--formats LIST] [--sizes LIST]
+  --out      Output directory (must exist)
+  --count    Number of images (default: 200)
+  --seed     Random seed (default: 1)
+  --formats  Comma separated ZXing format names (default: every writable format)
+  --sizes    Comma separated frame sizes (default: 640x480,1280x960,1920x1080)
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <ZXing/BarcodeFormat.h>
+#include <ZXing/BitMatrix.h>
+#include <ZXing/MultiFormatWriter.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+using namespace std;
+
+static const vector<ZXing::BarcodeFormat> WRITABLE_FORMATS = {
+  ZXing::BarcodeFormat::QRCode,
+  ZXing::BarcodeFormat::DataMatrix,
+  ZXing::BarcodeFormat::Aztec,
+  ZXing::BarcodeFormat::PDF417,
+  ZXing::BarcodeFormat::Code128,
+  ZXing::BarcodeFormat::Code39,
+  ZXing::BarcodeFormat::Code93,
+  ZXing::BarcodeFormat::Codabar,
+  ZXing::BarcodeFormat::ITF,
+  ZXing::BarcodeFormat::EAN13,
+  ZXing::BarcodeFormat::EAN8,
+  ZXing::BarcodeFormat::UPCA,
+  ZXing::BarcodeFormat::UPCE
+};
+
+struct Random {
+  mt19937 engine;
+
+  explicit Random(uint32_t seed) : engine(seed) {}
+
+  // Integer in [lo, hi]
+  int Int(int lo, int hi) { return lo + static_cast<int>(engine() % static_cast<uint32_t>(hi - lo + 1)); }
+  // Real in [lo, hi)
+  double Real(double lo, double hi) { return lo + (hi - lo) * (engine() / 4294967296.0); }
+  bool Chance(double probability) { return Real(0, 1) < probability; }
+};
+
+struct PlacedCode {
+  string format;
+  string text;
+  int moduleSize;
+  double angle;
+  cv::Point2f corners[4];  // topLeft, topRight, bottomRight, bottomLeft of the symbol, in frame pixels
+};
+
+struct FrameSpec {
+  string file;
+  int width;
+  int height;
+  double contrast;
+  double blurSigma;
+  double noiseSigma;
+  bool inverted;
+  vector<PlacedCode> codes;
+};
+
+static bool IsLinear(ZXing::BarcodeFormat format)
+{
+  return ZXing::BarcodeFormats(ZXing::BarcodeFormat::LinearCodes).testFlag(format);
+}
+
+static string Digits(Random& rng, int count)
+{
+  string text;
+  for (int i = 0; i < count; i++) {
+    text += static_cast<char>('0' + rng.Int(0, 9));
+  }
+  return text;
+}
+
+static string Characters(Random& rng, const string& alphabet, int count)
+{
+  string text;
+  for (int i = 0; i < count; i++) {
+    text += alphabet[rng.Int(0, static_cast<int>(alphabet.size()) - 1)];
+  }
+  return text;
+}
+
+// EAN/UPC check digit: weights 3,1,3,... from the rightmost data digit
+static char CheckDigit(const string& digits)
+{
+  int sum = 0;
+  for (size_t i = 0; i < digits.size(); i++) {
+    int weight = ((digits.size() - i) % 2 == 1) ? 3 : 1;
+    sum += (digits[i] - '0') * weight;
+  }
+  return static_cast<char>('0' + (10 - sum % 10) % 10);
+}
+
+// Number system + 6 UPC-E digits to the 11 data digits of the equivalent UPC-A
+static string ExpandUpcE(const string& upce)
+{
+  const string d = upce.substr(1, 6);
+  const char last = d[5];
+  string body;
+  if (last <= '2') {
+    body = d.substr(0, 2) + last + "0000" + d.substr(2, 3);
+  } else if (last == '3') {
+    body = d.substr(0, 3) + "00000" + d.substr(3, 2);
+  } else if (last == '4') {
+    body = d.substr(0, 4) + "00000" + d[4];
+  } else {
+    body = d.substr(0, 5) + "0000" + last;
+  }
+  return upce[0] + body;
+}
+
+// Content that is valid for the symbology; the returned text is also what a
+// decoder reports (check digits included)
+static string MakeText(Random& rng, ZXing::BarcodeFormat format)
+{
+  static const string UPPER = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+  static const string MIXED = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-";
+
+  switch (format) {
+    case ZXing::BarcodeFormat::EAN13: { string d = Digits(rng, 12); return d + CheckDigit(d); }
+    case ZXing::BarcodeFormat::EAN8: { string d = Digits(rng, 7); return d + CheckDigit(d); }
+    case ZXing::BarcodeFormat::UPCA: { string d = Digits(rng, 11); return d + CheckDigit(d); }
+    case ZXing::BarcodeFormat::UPCE: { string d = "0" + Digits(rng, 6); return d + CheckDigit(ExpandUpcE(d)); }
+    case ZXing::BarcodeFormat::ITF: return Digits(rng, 2 * rng.Int(3, 7));
+    case ZXing::BarcodeFormat::Codabar: return "A" + Digits(rng, rng.Int(6, 12)) + "B";
+    case ZXing::BarcodeFormat::Code39:
+    case ZXing::BarcodeFormat::Code93: return Characters(rng, UPPER, rng.Int(6, 16));
+    case ZXing::BarcodeFormat::Code128: return Characters(rng, MIXED, rng.Int(6, 20));
+    default: return "RP-" + Characters(rng, MIXED, rng.Int(8, 60));
+  }
+}
+
+/**
+ * Render a symbol with one pixel per module, black on white, without quiet zone
+ */
+static cv::Mat RenderModules(ZXing::BarcodeFormat format, const string& text)
+{
+  ZXing::MultiFormatWriter writer(format);
+  writer.setMargin(0);
+  ZXing::BitMatrix matrix = writer.encode(text, 0, IsLinear(format) ? 1 : 0);
+
+  cv::Mat modules(matrix.height(), matrix.width(), CV_8UC1);
+  for (int y = 0; y < matrix.height(); y++) {
+    uchar* row = modules.ptr<uchar>(y);
+    for (int x = 0; x < matrix.width(); x++) {
+      row[x] = matrix.get(x, y) ? 0 : 255;
+    }
+  }
+  return modules;
+}
+
+/**
+ * Scale the symbol to moduleSize pixels per module and add a quiet zone.
+ * Returns the symbol rectangle (without quiet zone) inside the patch.
+ */
+static cv::Mat ScaleSymbol(const cv::Mat& modules, bool linear, int moduleSize, cv::Rect& symbol)
+{
+  int width = modules.cols * moduleSize;
+  int height = linear ? max(moduleSize * 40, width / 4) : modules.rows * moduleSize;
+
+  cv::Mat scaled;
+  cv::resize(modules, scaled, cv::Size(width, height), 0, 0, cv::INTER_NEAREST);
+
+  int quiet = (linear ? 10 : 4) * moduleSize;
+  int quietY = linear ? 2 * moduleSize : quiet;
+  cv::Mat patch;
+  cv::copyMakeBorder(scaled, patch, quietY, quietY, quiet, quiet, cv::BORDER_CONSTANT, cv::Scalar(255));
+
+  symbol = cv::Rect(quiet, quietY, width, height);
+  return patch;
+}
+
+/**
+ * Rotate the patch around its centre on an enlarged white canvas, mapping the
+ * symbol corners along
+ */
+static cv::Mat RotatePatch(const cv::Mat& patch, double angle, const cv::Rect& symbol, cv::Point2f corners[4])
+{
+  cv::Point2f center(patch.cols / 2.0f, patch.rows / 2.0f);
+  cv::Mat transform = cv::getRotationMatrix2D(center, angle, 1.0);
+  cv::Rect bounds = cv::RotatedRect(center, patch.size(), static_cast<float>(angle)).boundingRect();
+  transform.at<double>(0, 2) += bounds.width / 2.0 - center.x;
+  transform.at<double>(1, 2) += bounds.height / 2.0 - center.y;
+
+  cv::Mat rotated;
+  cv::warpAffine(patch, rotated, transform, bounds.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(255));
+
+  vector<cv::Point2f> source = {
+    cv::Point2f(static_cast<float>(symbol.x), static_cast<float>(symbol.y)),
+    cv::Point2f(static_cast<float>(symbol.x + symbol.width), static_cast<float>(symbol.y)),
+    cv::Point2f(static_cast<float>(symbol.x + symbol.width), static_cast<float>(symbol.y + symbol.height)),
+    cv::Point2f(static_cast<float>(symbol.x), static_cast<float>(symbol.y + symbol.height))
+  };
+  vector<cv::Point2f> mapped;
+  cv::transform(source, mapped, transform);
+  copy(mapped.begin(), mapped.end(), corners);
+  return rotated;
+}
+
+static double PickAngle(Random& rng)
+{
+  static const double RIGHT_ANGLES[] = {0, 90, 180, 270};
+  double base = RIGHT_ANGLES[rng.Int(0, 3)];
+  return rng.Chance(0.5) ? base : base + rng.Real(-30, 30);
+}
+
+/**
+ * Render one frame and fill in its ground truth
+ */
+static cv::Mat RenderFrame(Random& rng, const vector<ZXing::BarcodeFormat>& formats, FrameSpec& spec)
+{
+  cv::Mat frame(spec.height, spec.width, CV_8UC1, cv::Scalar(255));
+
+  // Split the frame into a grid, one code per cell so codes never overlap
+  int codeCount = rng.Chance(0.7) ? 1 : rng.Int(2, 4);
+  int columns = codeCount == 1 ? 1 : 2;
+  int rows = (codeCount + columns - 1) / columns;
+  int cellWidth = spec.width / columns;
+  int cellHeight = spec.height / rows;
+
+  for (int i = 0; i < codeCount; i++) {
+    ZXing::BarcodeFormat format = formats[rng.Int(0, static_cast<int>(formats.size()) - 1)];
+    bool linear = IsLinear(format);
+    string text = MakeText(rng, format);
+    double angle = PickAngle(rng);
+    int moduleSize = linear ? rng.Int(1, 4) : rng.Int(2, 8);
+
+    cv::Mat modules;
+    try {
+      modules = RenderModules(format, text);
+    } catch (const exception& e) {
+      cerr << "Skipping " << ZXing::ToString(format) << " \"" << text << "\": " << e.what() << endl;
+      continue;
+    }
+
+    // Shrink the modules until the rotated symbol fits its cell
+    cv::Mat placed;
+    cv::Rect symbol;
+    PlacedCode code;
+    for (; moduleSize >= 1; moduleSize--) {
+      cv::Mat patch = ScaleSymbol(modules, linear, moduleSize, symbol);
+      placed = RotatePatch(patch, angle, symbol, code.corners);
+      if (placed.cols <= cellWidth && placed.rows <= cellHeight) {
+        break;
+      }
+    }
+    if (moduleSize < 1) {
+      continue;
+    }
+
+    int cellX = (i % columns) * cellWidth;
+    int cellY = (i / columns) * cellHeight;
+    int offsetX = cellX + rng.Int(0, cellWidth - placed.cols);
+    int offsetY = cellY + rng.Int(0, cellHeight - placed.rows);
+    placed.copyTo(frame(cv::Rect(offsetX, offsetY, placed.cols, placed.rows)));
+
+    code.format = ZXing::ToString(format);
+    code.text = text;
+    code.moduleSize = moduleSize;
+    code.angle = angle;
+    for (cv::Point2f& corner : code.corners) {
+      corner += cv::Point2f(static_cast<float>(offsetX), static_cast<float>(offsetY));
+    }
+    spec.codes.push_back(code);
+  }
+
+  // Degradations, in the order a camera applies them
+  spec.contrast = rng.Chance(0.5) ? 1.0 : rng.Real(0.25, 1.0);
+  spec.blurSigma = rng.Chance(0.5) ? 0.0 : rng.Real(0.5, 2.5);
+  spec.noiseSigma = rng.Chance(0.4) ? 0.0 : rng.Real(2.0, 20.0);
+  spec.inverted = rng.Chance(0.1);
+  double brightness = rng.Real(-40, 40);
+  uint64_t noiseSeed = rng.engine();
+
+  if (spec.blurSigma > 0) {
+    cv::GaussianBlur(frame, frame, cv::Size(0, 0), spec.blurSigma);
+  }
+
+  cv::Mat degraded;
+  frame.convertTo(degraded, CV_32F, spec.contrast, 127.5 * (1.0 - spec.contrast) + brightness);
+  if (spec.noiseSigma > 0) {
+    cv::Mat noise(degraded.size(), CV_32F);
+    cv::RNG noiseRng(noiseSeed);
+    noiseRng.fill(noise, cv::RNG::NORMAL, 0, spec.noiseSigma);
+    degraded += noise;
+  }
+  degraded.convertTo(frame, CV_8U);
+
+  if (spec.inverted) {
+    cv::bitwise_not(frame, frame);
+  }
+  return frame;
+}
+
+static string EscapeJson(const string& text)
+{
+  string out;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  return out;
+}
+
+static void WriteManifest(const string& path, uint32_t seed, const vector<FrameSpec>& frames)
+{
+  ofstream out(path);
+  out << "{\n  \"generator\": \"barcode_gen_corpus\",\n  \"seed\": " << seed << ",\n  \"images\": [";
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    const FrameSpec& f = frames[i];
+    out << (i ? ",\n" : "\n")
+        << "    {\"file\": \"" << f.file << "\", \"width\": " << f.width << ", \"height\": " << f.height
+        << ", \"transforms\": {\"contrast\": " << f.contrast << ", \"blurSigma\": " << f.blurSigma
+        << ", \"noiseSigma\": " << f.noiseSigma << ", \"inverted\": " << (f.inverted ? "true" : "false")
+        << "}, \"codes\": [";
+
+    for (size_t j = 0; j < f.codes.size(); j++) {
+      const PlacedCode& c = f.codes[j];
+      out << (j ? ", " : "")
+          << "{\"format\": \"" << c.format << "\", \"text\": \"" << EscapeJson(c.text)
+          << "\", \"moduleSize\": " << c.moduleSize << ", \"angle\": " << c.angle << ", \"corners\": [";
+      for (int k = 0; k < 4; k++) {
+        out << (k ? ", " : "") << "[" << c.corners[k].x << ", " << c.corners[k].y << "]";
+      }
+      out << "]}";
+    }
+    out << "]}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+static vector<string> Split(const string& text, char separator)
+{
+  vector<string> parts;
+  stringstream stream(text);
+  string part;
+  while (getline(stream, part, separator)) {
+    if (!part.empty()) {
+      parts.push_back(part);
+    }
+  }
+  return parts;
+}
+
+int main(int argc, char** argv)
+{
+  string outDir;
+  int count = 200;
+  uint32_t seed = 1;
+  vector<ZXing::BarcodeFormat> formats = WRITABLE_FORMATS;
+  vector<cv::Size> sizes = {cv::Size(640, 480), cv::Size(1280, 960), cv::Size(1920, 1080)};
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc) {
+      outDir = argv[++i];
+    } else if (arg == "--count" && i + 1 < argc) {
+      count = atoi(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "--formats" && i + 1 < argc) {
+      formats.clear();
+      for (const string& name : Split(argv[++i], ',')) {
+        ZXing::BarcodeFormat format = ZXing::BarcodeFormatFromString(name);
+        if (format == ZXing::BarcodeFormat::None) {
+          cerr << "Unknown format: " << name << endl;
+          return 1;
+        }
+        formats.push_back(format);
+      }
+    } else if (arg == "--sizes" && i + 1 < argc) {
+      sizes.clear();
+      for (const string& size : Split(argv[++i], ',')) {
+        int width = 0, height = 0;
+        if (sscanf(size.c_str(), "%dx%d", &width, &height) != 2 || width < 64 || height < 64) {
+          cerr << "Invalid size: " << size << endl;
+          return 1;
+        }
+        sizes.push_back(cv::Size(width, height));
+      }
+    } else {
+      outDir.clear();
+      break;
+    }
+  }
+
+  if (outDir.empty() || count < 1 || formats.empty() || sizes.empty()) {
+    cerr << "Usage: " << argv[0] << " --out DIR [--count N] [--seed S] [--formats LIST] [--sizes LIST]" << endl;
+    return 1;
+  }
+
+  Random rng(seed);
+  vector<FrameSpec> frames;
+
+  for (int i = 0; i < count; i++) {
+    FrameSpec spec;
+    cv::Size size = sizes[rng.Int(0, static_cast<int>(sizes.size()) - 1)];
+    char name[32];
+    snprintf(name, sizeof(name), "frame-%05d.png", i);
+    spec.file = name;
+    spec.width = size.width;
+    spec.height = size.height;
+
+    cv::Mat frame = RenderFrame(rng, formats, spec);
+    if (!cv::imwrite(outDir + "/" + spec.file, frame)) {
+      cerr << "Cannot write " << outDir << "/" << spec.file << endl;
+      return 1;
+    }
+    frames.push_back(spec);
+  }
+
+  WriteManifest(outDir + "/manifest.json", seed, frames);
+  cerr << "Wrote " << frames.size() << " images to " << outDir << endl;
+  return 0;
+}
@@ -0,0 +1,453 @@
+/*
+Batch barcode scanner for archives of stored images, without Node-RED.
+
+Runs the engine's block pipeline (src/pipeline.cpp: the node's decoders,
+block configuration, deduplication and output format, kept in step with
+lib/pipeline.js and checked with tools/parity.js) over a directory tree or a
+list of files. Files are streamed through two bounded queues: reader threads
+read each file and decode the image format, scan
+threads run the blocks. Memory stays bounded by the prefetch depth no matter
+how many files are scanned.
+
+Multi-page TIFF documents are streamed page by page: a reader decodes one
+page at a time and queues it like a file of its own, so the pages of a long
+document are scanned in parallel and only the queued pages are in memory.
+
+Recorded MJPEG camera streams (.mjpeg, .mjpg: multipart or concatenated
+JPEGs) are split into their frames the same way, each scanned as an image
+with its "frame" number.
+
+Results are written as NDJSON, one line per file (per page of a multi-page
+file, with its "page", per frame of a stream, with its "frame") in
+completion order:
+  {"index":0,"file":"a.png","results":[...],"readMs":4.1,"scanMs":22.7}
+  {"index":1,"file":"b.png","error":"Failed to decode image file b.png: unknown or corrupt image format"}
+  {"index":2,"file":"c.tif","page":0,"results":[...],"readMs":9.5,"scanMs":31.0}
+`results` is what the node outputs for the image; blocks that failed add a
+"warnings" list.
+
+Usage: barcode_scan --config FILE [--dir DIR | --list FILE] [options] [FILE...]
+  --config    Block configuration JSON { blocks, executionMode }, as used by
+              the node (Quagga2 blocks are not supported)
+  --dir       Scan every image file below DIR (sorted, recursive)
+  --list      Scan the files listed in FILE, one per line ('-': stdin)
+  --threads   Scan threads (default: number of CPUs)
+  --readers   Reader threads mapping and decoding files (default: 2)
+  --prefetch  Decoded images waiting for a scan thread (default: 2 x threads)
+  --out       Write the results to FILE instead of stdout
+
+Exits with status 2 when some files (pages or frames) could not be read or decoded.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <opencv2/core.hpp>
+
+#include "../src/filemap.h"
+#include "../src/json.h"
+#include "../src/mjpeg.h"
+#include "../src/pipeline.h"
+#include "../src/queue.h"
+
+using namespace std;
+
+// File extensions scanned in --dir mode (lower case)
+static const vector<string> IMAGE_EXTENSIONS = {
+  ".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".webp", ".pbm", ".pgm", ".ppm", ".pnm", ".mjpeg", ".mjpg"
+};
+
+// Largest frame accepted from a recorded MJPEG stream
+static const size_t MAX_MJPEG_FRAME = 64 * 1024 * 1024;
+
+struct FileJob {
+  size_t index;
+  string path;
+};
+
+struct ImageJob {
+  size_t index;
+  string path;
+  int page = -1;  // page of a multi-page file
+  int64_t frame = -1;  // frame of an MJPEG stream
+  cv::Mat image;
+  string error;
+  double readMs = 0;
+};
+
+static double ElapsedMs(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Lower-case extension of a file name, including the dot
+static string Extension(const string& name)
+{
+  size_t dot = name.rfind('.');
+  if (dot == string::npos || name.find('/', dot) != string::npos) {
+    return "";
+  }
+  string ext = name.substr(dot);
+  transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return tolower(c); });
+  return ext;
+}
+
+static bool HasImageExtension(const string& name)
+{
+  string ext = Extension(name);
+  return find(IMAGE_EXTENSIONS.begin(), IMAGE_EXTENSIONS.end(), ext) != IMAGE_EXTENSIONS.end();
+}
+
+// Formats that can hold several pages
+static bool IsMultiPageFormat(const string& name)
+{
+  string ext = Extension(name);
+  return ext == ".tif" || ext == ".tiff";
+}
+
+static bool IsMjpegStream(const string& name)
+{
+  string ext = Extension(name);
+  return ext == ".mjpeg" || ext == ".mjpg";
+}
+
+// Queue every frame of a recorded MJPEG stream, decoding each just before it
+// is queued; frames are decoded in place from the mapping. Returns false once
+// the queue is closed.
+static bool ReadFrames(const FileJob& file, BoundedQueue<ImageJob>& queue)
+{
+  string errorMsg;
+  shared_ptr<const MappedFile> mapping = file_map(file.path, errorMsg);
+  vector<MjpegDemuxer::Frame> frames;
+  if (mapping) {
+    MjpegDemuxer demuxer(MAX_MJPEG_FRAME);
+    demuxer.Push(mapping->data, mapping->size, frames);
+    if (frames.empty()) {
+      errorMsg = "Failed to read MJPEG stream " + file.path + ": no JPEG frames found";
+    }
+  }
+  if (frames.empty()) {
+    ImageJob job;
+    job.index = file.index;
+    job.path = file.path;
+    job.error = errorMsg;
+    return queue.Push(move(job));
+  }
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    ImageJob job;
+    job.index = file.index;
+    job.path = file.path;
+    job.frame = static_cast<int64_t>(i);
+    auto readStart = chrono::steady_clock::now();
+    job.image = decode_image_buffer(mapping->data + frames[i].offset, frames[i].length, job.error);
+    job.readMs = ElapsedMs(readStart);
+    if (job.image.empty()) {
+      job.error = "Failed to decode frame " + to_string(i) + " of " + file.path + ": " + job.error;
+    }
+    if (!queue.Push(move(job))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Queue every page of a multi-page file, decoding each just before it is
+// queued. Returns false once the queue is closed.
+static bool ReadPages(const FileJob& file, BoundedQueue<ImageJob>& queue)
+{
+  string errorMsg;
+  int pages = image_file_pages(file.path, errorMsg);
+  shared_ptr<const MappedFile> mapping = pages > 0 ? file_map(file.path, errorMsg) : nullptr;
+  if (!mapping) {
+    ImageJob job;
+    job.index = file.index;
+    job.path = file.path;
+    job.error = errorMsg;
+    return queue.Push(move(job));
+  }
+
+  for (int page = 0; page < pages; page++) {
+    ImageJob job;
+    job.index = file.index;
+    job.path = file.path;
+    job.page = pages > 1 ? page : -1;
+    auto readStart = chrono::steady_clock::now();
+    job.image = decode_image_page(mapping->data, mapping->size, page, job.error);
+    job.readMs = ElapsedMs(readStart);
+    if (job.image.empty()) {
+      job.error = "Failed to decode image file " + file.path + ": " + job.error;
+    }
+    if (!queue.Push(move(job))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Image files below dir, sorted by name within each directory; stops when emit returns false
+static bool WalkDirectory(const string& dir, const function<bool(const string&)>& emit)
+{
+  DIR* handle = opendir(dir.c_str());
+  if (handle == nullptr) {
+    cerr << "Cannot open directory: " << dir << endl;
+    return true;
+  }
+
+  vector<string> names;
+  while (struct dirent* entry = readdir(handle)) {
+    if (entry->d_name[0] != '.') {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(handle);
+  sort(names.begin(), names.end());
+
+  for (const string& name : names) {
+    string path = dir + "/" + name;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+      continue;
+    }
+    if (S_ISDIR(st.st_mode)) {
+      if (!WalkDirectory(path, emit)) {
+        return false;
+      }
+    } else if (S_ISREG(st.st_mode) && HasImageExtension(name) && !emit(path)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool ReadListFile(const string& listPath, const function<bool(const string&)>& emit)
+{
+  ifstream file;
+  if (listPath != "-") {
+    file.open(listPath);
+    if (!file) {
+      cerr << "Cannot open file list: " << listPath << endl;
+      return true;
+    }
+  }
+  istream& in = listPath == "-" ? cin : file;
+
+  string line;
+  while (getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty() && !emit(line)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  string configPath, dir, listPath, outPath;
+  vector<string> files;
+  unsigned cpus = max(1u, thread::hardware_concurrency());
+  int threads = static_cast<int>(cpus);
+  int readers = 2;
+  int prefetch = 0;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--config" && i + 1 < argc) {
+      configPath = argv[++i];
+    } else if (arg == "--dir" && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (arg == "--list" && i + 1 < argc) {
+      listPath = argv[++i];
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = max(1, atoi(argv[++i]));
+    } else if (arg == "--readers" && i + 1 < argc) {
+      readers = max(1, atoi(argv[++i]));
+    } else if (arg == "--prefetch" && i + 1 < argc) {
+      prefetch = max(1, atoi(argv[++i]));
+    } else if (arg == "--out" && i + 1 < argc) {
+      outPath = argv[++i];
+    } else if (arg.compare(0, 2, "--") != 0) {
+      files.push_back(arg);
+    } else {
+      cerr << "Usage: " << argv[0] << " --config FILE [--dir DIR | --list FILE] [--threads N] [--readers N] "
+           << "[--prefetch N] [--out FILE] [FILE...]" << endl;
+      return 1;
+    }
+  }
+
+  if (configPath.empty() || (dir.empty() && listPath.empty() && files.empty())) {
+    cerr << "--config and at least one of --dir, --list or FILE are required" << endl;
+    return 1;
+  }
+
+  ifstream configFile(configPath);
+  if (!configFile) {
+    cerr << "Cannot open configuration: " << configPath << endl;
+    return 1;
+  }
+  stringstream configText;
+  configText << configFile.rdbuf();
+
+  PipelineConfig config;
+  string errorMsg;
+  if (!read_pipeline_config(configText.str(), config, errorMsg)) {
+    cerr << configPath << ": " << errorMsg << endl;
+    return 1;
+  }
+
+  FILE* out = stdout;
+  if (!outPath.empty()) {
+    out = fopen(outPath.c_str(), "w");
+    if (out == nullptr) {
+      cerr << "Cannot write " << outPath << endl;
+      return 1;
+    }
+  }
+  // Whole lines reach the consumer as soon as they are complete
+  setvbuf(out, nullptr, _IOLBF, 1 << 16);
+
+  BoundedQueue<FileJob> fileQueue(1024);
+  BoundedQueue<ImageJob> imageQueue(prefetch > 0 ? prefetch : 2 * threads);
+  mutex outMutex;
+  atomic<size_t> scanned(0), failed(0), symbols(0);
+  auto start = chrono::steady_clock::now();
+
+  // Producer: file names, in listing order
+  thread producer([&] {
+    size_t index = 0;
+    auto emit = [&](const string& path) { return fileQueue.Push({index++, path}); };
+    bool more = true;
+    for (const string& file : files) {
+      if (!(more = emit(file))) {
+        break;
+      }
+    }
+    if (more && !listPath.empty()) {
+      more = ReadListFile(listPath, emit);
+    }
+    if (more && !dir.empty()) {
+      WalkDirectory(dir, emit);
+    }
+    fileQueue.Close();
+  });
+
+  // Readers: map and decode the image format
+  atomic<int> readersLeft(readers);
+  vector<thread> readerThreads;
+  for (int i = 0; i < readers; i++) {
+    readerThreads.emplace_back([&] {
+      trace_thread_name("reader");
+      FileJob file;
+      while (fileQueue.Pop(file)) {
+        if (IsMultiPageFormat(file.path)) {
+          if (!ReadPages(file, imageQueue)) {
+            break;
+          }
+          continue;
+        }
+        if (IsMjpegStream(file.path)) {
+          if (!ReadFrames(file, imageQueue)) {
+            break;
+          }
+          continue;
+        }
+        ImageJob job;
+        job.index = file.index;
+        job.path = file.path;
+        auto readStart = chrono::steady_clock::now();
+        job.image = decode_image_file(file.path, job.error);
+        job.readMs = ElapsedMs(readStart);
+        if (!imageQueue.Push(move(job))) {
+          break;
+        }
+      }
+      if (--readersLeft == 0) {
+        imageQueue.Close();
+      }
+    });
+  }
+
+  // Scan threads: run the blocks and write one line per file
+  vector<thread> scanThreads;
+  for (int i = 0; i < threads; i++) {
+    scanThreads.emplace_back([&] {
+      trace_thread_name("scan");
+      ImageJob job;
+      while (imageQueue.Pop(job)) {
+        string line = "{\"index\":" + to_string(job.index) + ",\"file\":" + json_string(job.path);
+        if (job.page >= 0) {
+          line += ",\"page\":" + to_string(job.page);
+        }
+        if (job.frame >= 0) {
+          line += ",\"frame\":" + to_string(job.frame);
+        }
+        if (job.image.empty()) {
+          line += ",\"error\":" + json_string(job.error) + "}\n";
+          failed++;
+        } else {
+          vector<string> warnings;
+          auto scanStart = chrono::steady_clock::now();
+          string results = run_pipeline(job.image, config, warnings);
+          double scanMs = ElapsedMs(scanStart);
+          job.image.release();
+
+          line += ",\"results\":" + results;
+          if (!warnings.empty()) {
+            line += ",\"warnings\":[";
+            for (size_t w = 0; w < warnings.size(); w++) {
+              line += (w > 0 ? "," : "") + json_string(warnings[w]);
+            }
+            line += "]";
+          }
+          line += ",\"readMs\":" + json_number(job.readMs) + ",\"scanMs\":" + json_number(scanMs) + "}\n";
+          // One "format" key per result
+          for (size_t pos = results.find("{\"format\":"); pos != string::npos; pos = results.find("{\"format\":", pos + 1)) {
+            symbols++;
+          }
+        }
+        scanned++;
+
+        lock_guard<mutex> lock(outMutex);
+        fputs(line.c_str(), out);
+      }
+    });
+  }
+
+  producer.join();
+  for (thread& t : readerThreads) {
+    t.join();
+  }
+  for (thread& t : scanThreads) {
+    t.join();
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  } else {
+    fflush(out);
+  }
+
+  double seconds = ElapsedMs(start) / 1000;
+  cerr << "Scanned " << scanned << " images (" << failed << " unreadable, " << symbols << " symbols) in "
+       << seconds << " s: " << (seconds > 0 ? scanned / seconds : 0) << " img/s" << endl;
+  return failed > 0 ? 2 : 0;
+}
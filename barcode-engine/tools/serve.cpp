@@ -0,0 +1,488 @@
+/*
+Local decode service: the engine as a daemon on a Unix-domain socket, for
+producers on the same host (Python, Go, ...) that would otherwise post
+images to Node-RED over HTTP.
+
+Requests use the binary protocol of include/barcode_service.h: a 48-byte
+header followed by raw pixels, an encoded image, a file path or the name of
+a shared-memory segment holding the frame. Each connection has a reader
+thread that queues complete requests; a fixed pool of decode threads runs
+the configured block pipeline (through the C API of the engine library) and
+writes each reply as soon as it is ready, in binary or as an NDJSON line.
+The queue is bounded, so a client sending faster than the pool decodes is
+held back by the socket instead of growing the daemon's memory.
+
+Usage: barcode_serve --config FILE --socket PATH [options]
+  --config       Block configuration JSON { blocks, executionMode }, as used
+                 by the node (Quagga2 blocks are not supported)
+  --socket       Path of the listening socket (a stale socket is replaced)
+  --mode         Permissions of the socket, octal (default: 660)
+  --threads      Decode threads (default: number of CPUs)
+  --queue        Requests waiting for a decode thread (default: 2 x threads)
+  --max-payload  Largest accepted request payload in MB (default: 64)
+
+Runs until SIGINT or SIGTERM, then removes the socket.
+*/
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../include/barcode_engine.h"
+#include "../include/barcode_service.h"
+#include "../src/json.h"
+#include "../src/queue.h"
+#include "../src/shm.h"
+#include "../src/trace.h"
+
+using namespace std;
+
+static_assert(sizeof(barcode_service_request) == 48, "request header layout");
+static_assert(sizeof(barcode_service_reply) == 24, "reply header layout");
+
+struct Connection {
+  int fd = -1;
+  mutex writeMutex;
+  // Closed once the reader and every queued request are done with it
+  ~Connection() { close(fd); }
+};
+
+struct Request {
+  shared_ptr<Connection> connection;
+  barcode_service_request header;
+  vector<uint8_t> payload;
+};
+
+struct Reply {
+  barcode_status status = BARCODE_OK;
+  string results;   // results array, or the error message
+  string warnings;
+  double decodeMs = 0;
+};
+
+static atomic<uint64_t> served(0), failed(0), connections(0);
+
+static double ElapsedMs(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+static bool ReadFull(int fd, void* buffer, size_t size)
+{
+  char* out = static_cast<char*>(buffer);
+  while (size > 0) {
+    ssize_t n = recv(fd, out, size, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    out += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+static bool WriteFull(int fd, const char* data, size_t size)
+{
+  while (size > 0) {
+    ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Move a string returned by the C API into a std::string
+static string Take(char* text)
+{
+  string copy = text != nullptr ? text : "";
+  barcode_free(text);
+  return copy;
+}
+
+static int FormatChannels(uint32_t format)
+{
+  switch (format) {
+    case BARCODE_GRAY: return 1;
+    case BARCODE_BGR:
+    case BARCODE_RGB: return 3;
+    case BARCODE_BGRA:
+    case BARCODE_RGBA: return 4;
+    default: return 0;
+  }
+}
+
+static Reply Invalid(const string& message)
+{
+  Reply reply;
+  reply.status = BARCODE_INVALID_ARGUMENT;
+  reply.results = message;
+  return reply;
+}
+
+// Bytes of a raw frame: full rows except the last, which ends after its pixels
+static bool FrameBytes(const barcode_service_request& header, size_t& bytes, string& errorMsg)
+{
+  int channels = FormatChannels(header.format);
+  if (channels == 0) {
+    errorMsg = "Unknown pixel format " + to_string(header.format);
+    return false;
+  }
+  const uint32_t MAX_IMAGE_DIMENSION = 32768;
+  if (header.width == 0 || header.height == 0 || header.width > MAX_IMAGE_DIMENSION || header.height > MAX_IMAGE_DIMENSION) {
+    errorMsg = "Invalid image dimensions (width: " + to_string(header.width) +
+               ", height: " + to_string(header.height) + ")";
+    return false;
+  }
+  size_t rowBytes = static_cast<size_t>(header.width) * channels;
+  size_t stride = header.stride == 0 ? rowBytes : header.stride;
+  bytes = stride * (header.height - 1) + rowBytes;
+  return true;
+}
+
+static Reply Decode(const barcode_pipeline* pipeline, const Request& request)
+{
+  const barcode_service_request& header = request.header;
+  const uint8_t* payload = request.payload.data();
+  string errorMsg;
+
+  // File path or segment name
+  string name;
+  if (header.kind == BARCODE_SERVICE_FILE || header.kind == BARCODE_SERVICE_SHM_PIXELS ||
+      header.kind == BARCODE_SERVICE_SHM_ENCODED) {
+    name.assign(request.payload.begin(), request.payload.end());
+  }
+
+  char* results = nullptr;
+  char* warnings = nullptr;
+  char* error = nullptr;
+  barcode_status status;
+  auto start = chrono::steady_clock::now();
+
+  // Keeps a shared-memory frame mapped while it is decoded
+  shared_ptr<const ShmSegment> segment;
+
+  switch (header.kind) {
+    case BARCODE_SERVICE_PIXELS:
+    case BARCODE_SERVICE_SHM_PIXELS: {
+      size_t bytes = 0;
+      if (!FrameBytes(header, bytes, errorMsg)) {
+        return Invalid(errorMsg);
+      }
+      const uint8_t* data = payload;
+      if (header.kind == BARCODE_SERVICE_PIXELS) {
+        if (request.payload.size() < bytes) {
+          return Invalid("Payload of " + to_string(request.payload.size()) + " bytes is smaller than the frame (" +
+                         to_string(bytes) + " bytes)");
+        }
+      } else {
+        if (header.offset > SIZE_MAX - bytes) {
+          return Invalid("Frame offset " + to_string(header.offset) + " is out of range");
+        }
+        if (!(segment = shm_map(name, header.offset + bytes, errorMsg))) {
+          return Invalid(errorMsg);
+        }
+        data = segment->data + header.offset;
+      }
+      barcode_image image = { data, static_cast<int>(header.width), static_cast<int>(header.height),
+                              header.stride, static_cast<barcode_pixel_format>(header.format) };
+      status = barcode_decode_pixels(pipeline, &image, &results, &warnings, &error);
+      break;
+    }
+    case BARCODE_SERVICE_ENCODED:
+      status = barcode_decode_encoded(pipeline, payload, request.payload.size(), &results, &warnings, &error);
+      break;
+    case BARCODE_SERVICE_SHM_ENCODED:
+      if (header.length == 0 || header.offset > SIZE_MAX - header.length) {
+        return Invalid("Invalid encoded frame (offset: " + to_string(header.offset) +
+                       ", length: " + to_string(header.length) + ")");
+      }
+      if (!(segment = shm_map(name, header.offset + header.length, errorMsg))) {
+        return Invalid(errorMsg);
+      }
+      status = barcode_decode_encoded(pipeline, segment->data + header.offset, header.length,
+                                      &results, &warnings, &error);
+      break;
+    case BARCODE_SERVICE_FILE:
+      status = barcode_decode_file(pipeline, name.c_str(), &results, &warnings, &error);
+      break;
+    default:
+      return Invalid("Unknown request kind " + to_string(header.kind));
+  }
+
+  Reply reply;
+  reply.status = status;
+  reply.decodeMs = ElapsedMs(start);
+  reply.results = status == BARCODE_OK ? Take(results) : Take(error);
+  reply.warnings = Take(warnings);
+  return reply;
+}
+
+static void SendReply(Connection& connection, const barcode_service_request& header, const Reply& reply)
+{
+  string message;
+  if (header.flags & BARCODE_SERVICE_NDJSON) {
+    message = "{\"id\":" + to_string(header.id);
+    if (reply.status == BARCODE_OK) {
+      message += ",\"results\":" + reply.results;
+      if (!reply.warnings.empty() && reply.warnings != "[]") {
+        message += ",\"warnings\":" + reply.warnings;
+      }
+      message += ",\"decodeMs\":" + json_number(reply.decodeMs) + "}\n";
+    } else {
+      message += ",\"error\":" + json_string(reply.results) + "}\n";
+    }
+  } else {
+    string warnings = reply.status == BARCODE_OK ? reply.warnings : "";
+    barcode_service_reply out = {};
+    out.magic = BARCODE_SERVICE_REPLY_MAGIC;
+    out.id = header.id;
+    out.status = reply.status;
+    out.results = static_cast<uint32_t>(reply.results.size());
+    out.warnings = static_cast<uint32_t>(warnings.size());
+    message.assign(reinterpret_cast<const char*>(&out), sizeof(out));
+    message += reply.results + warnings;
+  }
+
+  if (reply.status == BARCODE_OK) {
+    served++;
+  } else {
+    failed++;
+  }
+
+  // A client that went away only loses its own replies
+  lock_guard<mutex> lock(connection.writeMutex);
+  WriteFull(connection.fd, message.data(), message.size());
+}
+
+// Discard what the client still sends after a protocol error, for up to a
+// second of silence: closing with unread input would reset the connection
+// and lose the error reply
+static void Drain(int fd)
+{
+  struct timeval timeout = { 1, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  char scratch[4096];
+  while (recv(fd, scratch, sizeof(scratch), 0) > 0) {
+  }
+}
+
+// Reader of one connection: queues complete requests until the client
+// closes its end or sends something that is not a request
+static void ReadRequests(shared_ptr<Connection> connection, BoundedQueue<Request>& queue, size_t maxPayload)
+{
+  while (true) {
+    Request request;
+    if (!ReadFull(connection->fd, &request.header, sizeof(request.header))) {
+      break;
+    }
+    const barcode_service_request& header = request.header;
+    if (header.magic != BARCODE_SERVICE_REQUEST_MAGIC) {
+      SendReply(*connection, header, Invalid("Bad request magic, expected BCR1"));
+      Drain(connection->fd);
+      break;
+    }
+    if (header.payload > maxPayload) {
+      SendReply(*connection, header, Invalid("Payload of " + to_string(header.payload) +
+                                             " bytes exceeds --max-payload"));
+      Drain(connection->fd);
+      break;
+    }
+    request.payload.resize(header.payload);
+    if (!ReadFull(connection->fd, request.payload.data(), request.payload.size())) {
+      break;
+    }
+    request.connection = connection;
+    if (!queue.Push(move(request))) {
+      break;
+    }
+  }
+  // Replies still pending go out on the half-closed socket
+  shutdown(connection->fd, SHUT_RD);
+}
+
+static int Listen(const string& path, mode_t mode, string& errorMsg)
+{
+  struct sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    errorMsg = "Socket path is too long: " + path;
+    return -1;
+  }
+  memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  // Replace a socket left behind by a previous run, never another file
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      errorMsg = path + " exists and is not a socket";
+      return -1;
+    }
+    unlink(path.c_str());
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    errorMsg = string("socket() failed: ") + strerror(errno);
+    return -1;
+  }
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+      chmod(path.c_str(), mode) != 0 || listen(fd, SOMAXCONN) != 0) {
+    errorMsg = "Cannot listen on " + path + ": " + strerror(errno);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int main(int argc, char** argv)
+{
+  string configPath, socketPath;
+  unsigned cpus = max(1u, thread::hardware_concurrency());
+  int threads = static_cast<int>(cpus);
+  int queueDepth = 0;
+  size_t maxPayload = 64;
+  mode_t mode = 0660;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--config" && i + 1 < argc) {
+      configPath = argv[++i];
+    } else if (arg == "--socket" && i + 1 < argc) {
+      socketPath = argv[++i];
+    } else if (arg == "--mode" && i + 1 < argc) {
+      mode = static_cast<mode_t>(strtol(argv[++i], nullptr, 8));
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = max(1, atoi(argv[++i]));
+    } else if (arg == "--queue" && i + 1 < argc) {
+      queueDepth = max(1, atoi(argv[++i]));
+    } else if (arg == "--max-payload" && i + 1 < argc) {
+      maxPayload = static_cast<size_t>(max(1, atoi(argv[++i])));
+    } else {
+      cerr << "Usage: " << argv[0] << " --config FILE --socket PATH [--mode OCTAL] [--threads N] [--queue N] "
+           << "[--max-payload MB]" << endl;
+      return 1;
+    }
+  }
+  maxPayload <<= 20;
+
+  if (configPath.empty() || socketPath.empty()) {
+    cerr << "--config and --socket are required" << endl;
+    return 1;
+  }
+
+  ifstream configFile(configPath);
+  if (!configFile) {
+    cerr << "Cannot open configuration: " << configPath << endl;
+    return 1;
+  }
+  stringstream configText;
+  configText << configFile.rdbuf();
+
+  char* error = nullptr;
+  barcode_pipeline* pipeline = barcode_pipeline_create(configText.str().c_str(), &error);
+  if (pipeline == nullptr) {
+    cerr << configPath << ": " << Take(error) << endl;
+    return 1;
+  }
+
+  // Signals are taken by sigwait() below; every thread inherits the mask
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  string errorMsg;
+  int listenFd = Listen(socketPath, mode, errorMsg);
+  if (listenFd < 0) {
+    cerr << errorMsg << endl;
+    return 1;
+  }
+
+  BoundedQueue<Request> queue(queueDepth > 0 ? queueDepth : 2 * threads);
+
+  vector<thread> decodeThreads;
+  for (int i = 0; i < threads; i++) {
+    decodeThreads.emplace_back([&] {
+      trace_thread_name("serve");
+      Request request;
+      while (queue.Pop(request)) {
+        SendReply(*request.connection, request.header, Decode(pipeline, request));
+        request = Request();
+      }
+    });
+  }
+
+  thread acceptor([&] {
+    // Out of descriptors the pending connection stays queued and accept4 fails
+    // at once again; a reserve descriptor is given up to accept and close it,
+    // so the client sees the connection drop instead of the daemon spinning
+    int reserve = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    while (true) {
+      int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno == EMFILE || errno == ENFILE) {
+          if (reserve >= 0) {
+            close(reserve);
+            int pending = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (pending >= 0) {
+              close(pending);
+            }
+            reserve = open("/dev/null", O_RDONLY | O_CLOEXEC);
+          }
+          // Give connections in flight time to finish and free descriptors
+          this_thread::sleep_for(chrono::milliseconds(100));
+          continue;
+        }
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        break;
+      }
+      auto connection = make_shared<Connection>();
+      connection->fd = fd;
+      connections++;
+      thread(ReadRequests, connection, ref(queue), maxPayload).detach();
+    }
+  });
+
+  cerr << "Listening on " << socketPath << " with " << threads << " decode threads" << endl;
+
+  int received = 0;
+  sigwait(&signals, &received);
+
+  // Stop taking connections; requests in flight are dropped with the process
+  unlink(socketPath.c_str());
+  cerr << "Served " << served << " requests (" << failed << " failed) on " << connections << " connections" << endl;
+  fflush(stderr);
+  _exit(0);
+}
@@ -1,4 +1,50 @@
+const os = require('os');
+const path = require('path');
+const createPipeline = require('./lib/pipeline');
+const { WorkerPool } = require('./lib/worker-pool');
+const { planAffinity } = require('./lib/affinity');
+const { SlowFrameCapture } = require('./lib/slow-frames');
+const { TrafficRecorder } = require('./lib/recorder');
+const { StripStreams, isStripInput } = require('./lib/strip-stream');
+const { MjpegStreams, isMjpegInput } = require('./lib/mjpeg-stream');
+const metrics = require('./lib/metrics');
+const trace = require('./lib/trace');
+
+// Image ids shared by all nodes, tag the trace spans of one image
+let nextImageId = 1;
+
 module.exports = function(RED) {
+    // Engine metrics of every barcode-reader node, OpenMetrics text
+    RED.httpAdmin.get('/barcode-reader/metrics', RED.auth.needsPermission('barcode-reader.read'),
+        metrics.handler(require('./index.js')));
+
+    // Span tracing: start/stop recording, download or flush the Chrome trace
+    const traceRoute = (action) => async (req, res) => {
+        try {
+            res.json(await action(require('./index.js'), req));
+        } catch (err) {
+            res.status(500).json({ error: err.message });
+        }
+    };
+    RED.httpAdmin.post('/barcode-reader/trace/start', RED.auth.needsPermission('barcode-reader.write'),
+        traceRoute(async (barcode, req) => {
+            await trace.start(barcode, req.query.capacity);
+            return { tracing: true };
+        }));
+    RED.httpAdmin.post('/barcode-reader/trace/stop', RED.auth.needsPermission('barcode-reader.write'),
+        traceRoute(async (barcode) => {
+            await trace.stop(barcode);
+            return { tracing: false };
+        }));
+    RED.httpAdmin.get('/barcode-reader/trace', RED.auth.needsPermission('barcode-reader.read'),
+        traceRoute((barcode) => trace.collect(barcode)));
+    RED.httpAdmin.post('/barcode-reader/trace/flush', RED.auth.needsPermission('barcode-reader.write'),
+        traceRoute(async (barcode) => {
+            const file = path.join(RED.settings.userDir || os.tmpdir(),
+                `barcode-trace-${new Date().toISOString().replace(/[:.]/g, '-')}.json`);
+            return { file: file, events: await trace.flush(barcode, file) };
+        }));
+
     function BarcodeReaderNode(config) {
         RED.nodes.createNode(this, config);
         const node = this;
@@ -12,7 +58,153 @@ module.exports = function(RED) {
             node.warn('Quagga2 not available. Install @ericblade/quagga2 to use Quagga decoder.');
         }
 
+        const pipeline = createPipeline(barcode, Quagga);
+
+        // Worker/process isolation: run the pipeline in a pool of worker threads or processes
+        let workerPool = null;
+        if (config.isolation === 'worker' || config.isolation === 'process') {
+            const workers = parseInt(config.workers, 10) || Math.max(1, os.cpus().length - 1);
+            workerPool = new WorkerPool({
+                size: workers,
+                mode: config.isolation === 'process' ? 'process' : 'thread',
+                barcode: barcode,
+                placements: planAffinity(workers, config.pinning || 'none', config.cpus),
+                onWarn: (message) => node.warn(message),
+                onError: () => node.status({ fill: "red", shape: "ring", text: "Workers failed" })
+            });
+        }
+
+        // Node-level series; block and stage series are recorded natively
+        const metricsLabel = { node: node.name || node.id };
+        const frameSeconds = barcode.metricsHistogram && barcode.metricsHistogram('barcode_frame_seconds', metricsLabel);
+        const frameCount = barcode.metricsCounter && barcode.metricsCounter('barcode_frames', metricsLabel);
+        const frameErrors = barcode.metricsCounter && barcode.metricsCounter('barcode_frame_errors', metricsLabel);
+        metrics.registerNode(node.id, metricsLabel.node, workerPool);
+        if (workerPool) {
+            trace.registerPool(node.id, workerPool);
+        }
+
+        // Optional local endpoint: http://127.0.0.1:<port>/metrics
+        const metricsPort = parseInt(config.metricsPort, 10) || 0;
+        if (metricsPort > 0) {
+            metrics.startServer(barcode, metricsPort, (err) => node.warn(`Metrics endpoint unavailable: ${err.message}`));
+        }
+
+        // Optional slow-frame capture: images slower than slowFrameMs are saved for replay
+        const slowFrameMs = parseFloat(config.slowFrameMs) || 0;
+        const slowFrames = slowFrameMs > 0
+            ? new SlowFrameCapture({
+                directory: config.slowFrameDir ||
+                    path.join(RED.settings.userDir || os.tmpdir(), 'barcode-slow-frames', node.id.replace(/[^\w.-]/g, '_')),
+                thresholdMs: slowFrameMs,
+                quotaBytes: (parseFloat(config.slowFrameQuota) || 500) * 1024 * 1024,
+                onWarn: (message) => node.warn(message)
+            })
+            : null;
+
+        // Optional traffic recording, replayed offline with tools/replay.js
+        let recorder = null;
+        if (config.recordFile) {
+            try {
+                recorder = new TrafficRecorder({
+                    barcode: barcode,
+                    file: path.resolve(RED.settings.userDir || os.tmpdir(), config.recordFile),
+                    maxBytes: (parseFloat(config.recordLimit) || 1024) * 1024 * 1024,
+                    config: config,
+                    node: { id: node.id, name: node.name },
+                    onWarn: (message) => node.warn(message)
+                });
+            } catch (err) {
+                node.warn(`Recording unavailable: ${err.message}`);
+            }
+        }
+
+        // Line-scan strips ({ strip, data, width, ... }) are decoded as they
+        // arrive, in the main process, through a sliding window
+        const stripStreams = barcode.stripOpen ? new StripStreams({ barcode: barcode, config: config }) : null;
+
+        /**
+         * Process a single image in the configured isolation mode, filling
+         * timings with the per-stage breakdown. decoded is the pending
+         * decodeFile() of a page decoded ahead (main thread only).
+         */
+        async function processSingleImage(input, timings, decoded) {
+            const start = process.hrtime.bigint();
+            const image = nextImageId++;
+            const results = workerPool
+                ? await workerPool.run(input, {
+                    id: node.id,
+                    name: node.name,
+                    image: image,
+                    blocks: config.blocks,
+                    executionMode: config.executionMode,
+                    jpegPrescan: config.jpegPrescan
+                }, timings)
+                : await pipeline.processSingleImage(input, config, node, timings, image, decoded);
+
+            const elapsedMs = Number(process.hrtime.bigint() - start) / 1e6;
+            if (frameSeconds) {
+                barcode.metricsObserve(frameSeconds, elapsedMs);
+                barcode.metricsAdd(frameCount);
+            }
+            if (slowFrames) {
+                slowFrames.capture(input, config, timings, elapsedMs, {
+                    node: { id: node.id, name: node.name },
+                    image: image,
+                    results: results.length
+                });
+            }
+            return results;
+        }
+
+        // MJPEG camera streams ({ mjpeg, data }): every frame is scanned
+        // and sent as its own message, frames beyond the queue are dropped
+        const mjpegStreams = barcode.mjpegOpen ? new MjpegStreams({
+            barcode: barcode,
+            metricsLabels: metricsLabel,
+            process: async (frameInput, frame, msg) => {
+                const arrivedAt = process.hrtime.bigint();
+                const performanceKey = node.name || "barcode-reader";
+                const out = {
+                    _msgid: RED.util.generateId(),
+                    topic: msg.topic,
+                    mjpeg: frame,
+                    performance: { [performanceKey]: { startTime: new Date() } }
+                };
+                const timings = {};
+                const results = await processSingleImage(frameInput, timings);
+                if (recorder) {
+                    recorder.record(frameInput, arrivedAt, { msgid: out._msgid, topic: out.topic, index: null }, results);
+                }
+                RED.util.setMessageProperty(out, config.outputValue || "payload", results);
+
+                const elapsed = new Date().getTime() - out.performance[performanceKey].startTime.getTime();
+                Object.assign(out.performance[performanceKey], { milliseconds: elapsed }, timings);
+                node.status({
+                    shape: "dot",
+                    text: `${elapsed} ms, frame ${frame.seq}` + (frame.dropped > 0 ? `, ${frame.dropped} dropped` : '')
+                });
+                node.send(out);
+            },
+            onError: (err, msg) => {
+                node.status({ fill: "red", shape: "ring", text: "Error" });
+                if (frameErrors) {
+                    barcode.metricsAdd(frameErrors);
+                }
+                node.error(err, msg);
+            }
+        }) : null;
+
+        /**
+         * Multi-page image file to scan page by page: { path, pages: true }
+         */
+        function isDocumentInput(input) {
+            return input !== null && typeof input === 'object' && !Array.isArray(input) &&
+                typeof input.path === 'string' && input.pages === true;
+        }
+
         node.on('input', async (msg, send, done) => {
+            const arrivedAt = process.hrtime.bigint();
             try {
                 // Initialize performance tracking
                 msg.performance = msg.performance || {};
@@ -26,20 +218,97 @@ module.exports = function(RED) {
                     throw new Error(`Input path "${inputValue}" not found in msg.`);
                 }
 
+                // Chunks of an MJPEG stream: frames are sent as they are scanned
+                if (isMjpegInput(input)) {
+                    if (!mjpegStreams) {
+                        throw new Error('MJPEG input needs the native addon');
+                    }
+                    mjpegStreams.push(input, msg);
+                    if (done) done();
+                    return;
+                }
+
+                // Strips of a line scan: output the symbols this strip completed
+                if (isStripInput(input)) {
+                    if (!stripStreams) {
+                        throw new Error('Strip input needs the native addon');
+                    }
+                    const strip = await stripStreams.append(input);
+                    strip.warnings.forEach((warning) => node.warn(warning));
+                    RED.util.setMessageProperty(msg, outputValue, strip.results);
+
+                    const stripKey = node.name || "barcode-reader";
+                    const stripElapsed = new Date().getTime() - msg.performance[stripKey].startTime.getTime();
+                    msg.performance[stripKey].milliseconds = stripElapsed;
+                    msg.performance[stripKey].rows = strip.rows;
+                    msg.performance[stripKey].finished = strip.finished;
+                    node.status({
+                        shape: "dot",
+                        text: `${stripElapsed} ms, ${strip.rows} rows`
+                    });
+
+                    send(msg);
+                    if (done) done();
+                    return;
+                }
+
+                // Multi-page documents ({ path, pages: true }) are scanned
+                // like an array of their pages; a page is only decoded when it
+                // is processed, so memory holds the pages in flight, not the document
+                const isDocument = isDocumentInput(input);
+                if (isDocument) {
+                    const pageCount = await barcode.imagePages(input.path);
+                    input = Array.from({ length: pageCount }, (_, page) => ({ path: input.path, page: page }));
+                }
+
                 // Handle array input
                 const isArrayInput = Array.isArray(input);
-                const inputArray = isArrayInput ? input : [input];
+                let inputArray = isArrayInput ? input : [input];
+
+                // Region hints (msg.roi: { x, y, width, height } in pixels, or an
+                // array of them) travel with each encoded image: for a JPEG only
+                // the MCUs covering them are decoded and scanned. An empty list is no hint.
+                const roi = msg.roi ? [].concat(msg.roi) : [];
+                if (roi.length > 0) {
+                    inputArray = inputArray.map(singleInput =>
+                        ArrayBuffer.isView(singleInput) ? { data: singleInput, roi: roi } : singleInput);
+                }
                 const results = [];
+                const timings = inputArray.map(() => ({}));
+
+                // Process each image (concurrently when a worker pool is available)
+                if (workerPool) {
+                    results.push(...await Promise.all(inputArray.map((singleInput, i) => processSingleImage(singleInput, timings[i]))));
+                } else {
+                    // One page look-ahead: the next page is decoded on the
+                    // libuv pool while the blocks scan this one. The pending
+                    // decode lives only here, so a scanned page is released
+                    // and at most two pages are held.
+                    let decoded;
+                    for (let i = 0; i < inputArray.length; i++) {
+                        const current = decoded;
+                        const next = inputArray[i + 1];
+                        decoded = isDocument && next ? barcode.decodeFile(next.path, undefined, next.page) : undefined;
+                        if (decoded) {
+                            // Awaited with the next page; unobserved if this page fails
+                            decoded.catch(() => {});
+                        }
+                        const imageResults = await processSingleImage(inputArray[i], timings[i], current);
+                        results.push(imageResults);
+                    }
+                }
 
-                // Process each image
-                for (const singleInput of inputArray) {
-                    const imageResults = await processSingleImage(singleInput, config, node);
-                    results.push(imageResults);
+                if (recorder) {
+                    inputArray.forEach((singleInput, i) => recorder.record(singleInput, arrivedAt, {
+                        msgid: msg._msgid,
+                        topic: msg.topic,
+                        index: isArrayInput ? i : null
+                    }, results[i]));
                 }
 
                 // Set output based on input type
                 if (isArrayInput) {
-                    // Array input → nested results [[img1_results], [img2_results]]
+                    // Array or document input → nested results [[img1_results], [img2_results]]
                     RED.util.setMessageProperty(msg, outputValue, results);
                 } else {
                     // Single input → flat results [results]
@@ -51,6 +320,13 @@ module.exports = function(RED) {
                 const elapsed = new Date().getTime() - msg.performance[performanceKey].startTime.getTime();
                 msg.performance[performanceKey].milliseconds = elapsed;
 
+                // Stage breakdown: per block for a single image, per image for arrays
+                if (isArrayInput) {
+                    msg.performance[performanceKey].images = timings;
+                } else {
+                    Object.assign(msg.performance[performanceKey], timings[0]);
+                }
+
                 // Show ms under the node in the Editor
                 node.status({
                     shape: "dot",
@@ -61,6 +337,9 @@ module.exports = function(RED) {
                 if (done) done();
             } catch (err) {
                 node.status({ fill: "red", shape: "ring", text: "Error" });
+                if (frameErrors) {
+                    barcode.metricsAdd(frameErrors);
+                }
 
                 if (done) {
                     done(err);
@@ -70,349 +349,30 @@ module.exports = function(RED) {
             }
         });
 
-        /**
-         * Process a single image through all blocks
-         */
-        async function processSingleImage(input, config, node) {
-            // Get image dimensions for relative coordinate conversion
-            const imageDimensions = getImageDimensions(input);
-
-            // Get blocks configuration
-            const blocks = config.blocks || [];
-            const executionMode = config.executionMode || 'parallel';
-
-            if (blocks.length === 0) {
-                node.warn('No decoder blocks configured');
-                return [];
+        node.on('close', async (done) => {
+            metrics.unregisterNode(node.id);
+            trace.unregisterPool(node.id);
+            if (metricsPort > 0) {
+                await metrics.stopServer(metricsPort);
             }
-
-            let allResults = [];
-
-            if (executionMode === 'sequential') {
-                // Sequential: process blocks in order, stop at first success
-                allResults = await processSequential(input, blocks, node, Quagga);
-            } else {
-                // Parallel: process all blocks and merge results
-                allResults = await processParallel(input, blocks, node, Quagga);
+            if (slowFrames) {
+                await slowFrames.close();
             }
-
-            // Deduplicate results
-            const dedupResults = deduplicateResults(allResults);
-
-            // Convert to relative coordinates and final format
-            const finalResults = dedupResults.map(result =>
-                convertToFinalFormat(result, imageDimensions)
-            );
-
-            return finalResults;
-        }
-
-        /**
-         * Process blocks sequentially (early exit on first success)
-         */
-        async function processSequential(input, blocks, node, Quagga) {
-            for (let i = 0; i < blocks.length; i++) {
-                const block = blocks[i];
-
-                try {
-                    const results = await processBlock(input, block, i, node, Quagga);
-
-                    if (results.length > 0) {
-                        // Found results, early exit
-                        return results;
-                    }
-                } catch (err) {
-                    node.warn(`Block ${i} (${block.decoder}) failed: ${err.message}`);
-                }
+            if (recorder) {
+                await recorder.close();
             }
-
-            return [];
-        }
-
-        /**
-         * Process blocks in parallel (merge all results)
-         */
-        async function processParallel(input, blocks, node, Quagga) {
-            const promises = blocks.map((block, index) => {
-                return processBlock(input, block, index, node, Quagga).catch(err => {
-                    node.warn(`Block ${index} (${block.decoder}) failed: ${err.message}`);
-                    return [];
-                });
-            });
-
-            const resultsArrays = await Promise.all(promises);
-            return resultsArrays.flat();
-        }
-
-        /**
-         * Process a single block (preprocessing + decoding)
-         */
-        async function processBlock(input, block, blockIndex, node, Quagga) {
-            // Apply preprocessing
-            const preprocessed = applyPreprocessing(input, block.preprocessing);
-
-            // Decode based on decoder type
-            let rawResults;
-
-            switch (block.decoder) {
-                case 'zbar':
-                    rawResults = decodeWithZBar(preprocessed, block);
-                    break;
-                case 'zxing':
-                    rawResults = decodeWithZXing(preprocessed, block);
-                    break;
-                case 'quagga2':
-                    rawResults = await decodeWithQuagga(preprocessed, block, node, Quagga);
-                    break;
-                default:
-                    throw new Error(`Unknown decoder: ${block.decoder}`);
-            }
-
-            // Add block metadata to results
-            return rawResults.map(result => ({
-                ...result,
-                blockIndex: blockIndex,
-                decoder: block.decoder,
-                preprocessing: block.preprocessing
-            }));
-        }
-
-        /**
-         * Apply preprocessing to image
-         */
-        function applyPreprocessing(input, method) {
-            switch (method) {
-                case 'original':
-                    return barcode.preprocess_original(input);
-                case 'histogram':
-                    return barcode.preprocess_histogram(input);
-                case 'otsu':
-                    return barcode.preprocess_otsu(input);
-                default:
-                    throw new Error(`Unknown preprocessing method: ${method}`);
-            }
-        }
-
-        /**
-         * Decode with ZBar
-         */
-        function decodeWithZBar(preprocessed, block) {
-            const resultJson = barcode.decode_zbar(preprocessed);
-            const parsed = JSON.parse(resultJson);
-
-            if (parsed.error) {
-                throw new Error(parsed.error);
+            if (stripStreams) {
+                stripStreams.close();
             }
-
-            return parsed.results || [];
-        }
-
-        /**
-         * Decode with ZXing
-         */
-        function decodeWithZXing(preprocessed, block) {
-            const tryHarder = block.options?.tryHarder || false;
-            const resultJson = barcode.decode_zxing(preprocessed, tryHarder);
-            const parsed = JSON.parse(resultJson);
-
-            if (parsed.error) {
-                throw new Error(parsed.error);
+            if (mjpegStreams) {
+                mjpegStreams.close();
             }
-
-            return parsed.results || [];
-        }
-
-        /**
-         * Decode with Quagga2
-         */
-        async function decodeWithQuagga(preprocessed, block, node, Quagga) {
-            if (!Quagga) {
-                throw new Error('Quagga2 is not installed');
+            if (workerPool) {
+                await workerPool.close();
+                workerPool = null;
             }
-
-            return new Promise(async (resolve, reject) => {
-                try {
-                    const jpeg = require('jpeg-js');
-
-                    // Convert grayscale Buffer to RGBA for jpeg-js
-                    // Preprocessed data is grayscale (1 channel), jpeg-js needs RGBA (4 channels)
-                    const rgbaData = Buffer.alloc(preprocessed.width * preprocessed.height * 4);
-                    for (let i = 0; i < preprocessed.data.length; i++) {
-                        const gray = preprocessed.data[i];
-                        rgbaData[i * 4] = gray;     // R
-                        rgbaData[i * 4 + 1] = gray; // G
-                        rgbaData[i * 4 + 2] = gray; // B
-                        rgbaData[i * 4 + 3] = 255;  // A (fully opaque)
-                    }
-
-                    // Encode to JPEG (quality 85 is good balance for barcodes)
-                    const jpegData = jpeg.encode({
-                        data: rgbaData,
-                        width: preprocessed.width,
-                        height: preprocessed.height
-                    }, 85);
-
-                    // Convert to base64 data URI
-                    const base64 = jpegData.data.toString('base64');
-                    const dataUri = `data:image/jpeg;base64,${base64}`;
-
-                    Quagga.decodeSingle({
-                        src: dataUri,  // Now using proper data URI format
-                        numOfWorkers: 0,
-                        decoder: {
-                            readers: [
-                                "code_128_reader",   // CODE 128 (logistics, shipping)
-                                "ean_reader",        // EAN-13 (retail products)
-                                "ean_8_reader",      // EAN-8 (small items)
-                                "upc_reader",        // UPC-A (North America retail)
-                                "upc_e_reader",      // UPC-E (small packages)
-                                "code_39_reader",    // CODE 39 (automotive, DoD)
-                                "codabar_reader"     // CODABAR (libraries, blood banks)
-                            ]
-                        }
-                    }, (result) => {
-                        if (result && result.codeResult) {
-                            const boxes = result.boxes || [];
-                            let points = { x1: 0, y1: 0, x2: 0, y2: 0, x3: 0, y3: 0, x4: 0, y4: 0 };
-
-                            // Extract corner points if available
-                            if (boxes.length > 0 && boxes[0].length >= 4) {
-                                const box = boxes[0];
-                                points = {
-                                    x1: box[0][0], y1: box[0][1],
-                                    x2: box[1][0], y2: box[1][1],
-                                    x3: box[2][0], y3: box[2][1],
-                                    x4: box[3][0], y4: box[3][1]
-                                };
-                            }
-
-                            resolve([{
-                                type: result.codeResult.format,
-                                data: result.codeResult.code,
-                                points: points
-                            }]);
-                        } else {
-                            resolve([]);
-                        }
-                    });
-                } catch (err) {
-                    reject(err);
-                }
-            });
-        }
-
-        /**
-         * Deduplicate results by barcode value only
-         * When duplicates exist, keep detection from lowest blockIndex
-         */
-        function deduplicateResults(results) {
-            const map = new Map();
-
-            for (const result of results) {
-                const key = result.data;  // Use only barcode value for deduplication
-                const detectionString = `${result.decoder}_${result.preprocessing}`;
-
-                if (map.has(key)) {
-                    const existing = map.get(key);
-
-                    // Add detection string if not already present
-                    if (!existing.detectedBy.includes(detectionString)) {
-                        existing.detectedBy.push(detectionString);
-                    }
-
-                    // If new result has lower blockIndex, replace base detection
-                    if (result.blockIndex < existing.blockIndex) {
-                        map.set(key, {
-                            ...result,
-                            blockIndex: result.blockIndex,
-                            detectedBy: existing.detectedBy
-                        });
-                    }
-                } else {
-                    map.set(key, {
-                        ...result,
-                        detectedBy: [detectionString]
-                    });
-                }
-            }
-
-            return Array.from(map.values());
-        }
-
-        /**
-         * Convert result to final format with relative coordinates
-         */
-        function convertToFinalFormat(result, imageDimensions) {
-            const { width, height } = imageDimensions;
-            const points = result.points;
-
-            // Convert absolute pixel coordinates to relative (0-1)
-            const corners = [
-                { x: points.x2 / width, y: points.y2 / height },
-                { x: points.x3 / width, y: points.y3 / height },
-                { x: points.x4 / width, y: points.y4 / height },
-                { x: points.x1 / width, y: points.y1 / height }
-            ];
-
-            // Calculate center, size, and angle
-            const absoluteCorners = [
-                points.x2, points.y2,
-                points.x3, points.y3,
-                points.x4, points.y4,
-                points.x1, points.y1
-            ];
-            const [center, size, angle] = getRotation(absoluteCorners);
-
-            return {
-                format: result.type,
-                value: result.data,
-                box: {
-                    angle: angle,
-                    center: {
-                        x: center[0] / width,
-                        y: center[1] / height
-                    },
-                    size: {
-                        width: size[0] / width,
-                        height: size[1] / height
-                    }
-                },
-                corners: corners,
-                detectedBy: result.detectedBy
-            };
-        }
-
-        /**
-         * Get image dimensions from input
-         */
-        function getImageDimensions(input) {
-            if (input.width && input.height) {
-                return { width: input.width, height: input.height };
-            }
-
-            // Fallback for buffer inputs (try to decode)
-            try {
-                const converted = barcode.convertToMat(input);
-                return { width: converted.width, height: converted.height };
-            } catch (err) {
-                throw new Error('Could not determine image dimensions');
-            }
-        }
-
-        /**
-         * Calculate rotation, center, and size from corner points
-         */
-        function getRotation(l) {
-            const center = [(l[0] + l[4]) / 2, (l[1] + l[5]) / 2];
-            const diffs = [l[0] - l[6], l[1] - l[7]];
-            const rotation = -Math.atan(diffs[0] / diffs[1]) * 180 / Math.PI;
-
-            const sizeY = Math.sqrt((l[6] - l[0])**2 + (l[7] - l[1])**2);
-            const sizeX = Math.sqrt((l[2] - l[0])**2 + (l[3] - l[1])**2);
-            const size = [sizeX, sizeY];
-
-            return [center, size, rotation];
-        }
+            done();
+        });
     }
 
     RED.nodes.registerType("barcode-reader", BarcodeReaderNode);
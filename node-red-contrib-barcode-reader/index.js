@@ -8,8 +8,55 @@ module.exports = {
   // New decoder primitives
   decode_zbar: barcode.decode_zbar,
   decode_zxing: barcode.decode_zxing,
+  decode_block: barcode.decode_block,
+  decodeFile: barcode.decodeFile,
+  imagePages: barcode.imagePages,
+  decodeFrame: barcode.decodeFrame,
   // Preprocessing functions
   preprocess_original: barcode.preprocess_original,
   preprocess_histogram: barcode.preprocess_histogram,
-  preprocess_otsu: barcode.preprocess_otsu
+  preprocess_otsu: barcode.preprocess_otsu,
+  // Shared-memory input
+  shmRelease: barcode.shmRelease,
+  shmCreate: barcode.shmCreate,
+  shmUnlink: barcode.shmUnlink,
+  // Traffic capture
+  recordOpen: barcode.recordOpen,
+  recordAppend: barcode.recordAppend,
+  recordClose: barcode.recordClose,
+  recordRead: barcode.recordRead,
+  // Packed corpus
+  packCreate: barcode.packCreate,
+  packAdd: barcode.packAdd,
+  packFinish: barcode.packFinish,
+  packRead: barcode.packRead,
+  // Partial JPEG decoding
+  jpegPrescan: barcode.jpegPrescan,
+  jpegDecodeRegions: barcode.jpegDecodeRegions,
+  // MJPEG streams
+  mjpegOpen: barcode.mjpegOpen,
+  mjpegPush: barcode.mjpegPush,
+  mjpegDiscarded: barcode.mjpegDiscarded,
+  // Streaming strip scan
+  stripOpen: barcode.stripOpen,
+  stripAppend: barcode.stripAppend,
+  stripFinish: barcode.stripFinish,
+  // CPU placement
+  setAffinity: barcode.setAffinity,
+  getAffinity: barcode.getAffinity,
+  // Metrics registry
+  metricsBlock: barcode.metricsBlock,
+  metricsCounter: barcode.metricsCounter,
+  metricsHistogram: barcode.metricsHistogram,
+  metricsAdd: barcode.metricsAdd,
+  metricsObserve: barcode.metricsObserve,
+  metricsSnapshot: barcode.metricsSnapshot,
+  // Span tracing
+  traceStart: barcode.traceStart,
+  traceStop: barcode.traceStop,
+  traceEnabled: barcode.traceEnabled,
+  traceNow: barcode.traceNow,
+  traceSpan: barcode.traceSpan,
+  traceThreadName: barcode.traceThreadName,
+  traceEvents: barcode.traceEvents
 };
@@ -0,0 +1,94 @@
+/**
+ * CPU/NUMA placement plan for the decode worker pool.
+ *
+ * Pinning modes:
+ * - 'none': workers float over the allowed CPUs
+ * - 'numa': workers are spread round-robin over NUMA nodes and pinned to the
+ *   CPUs of their node; their allocations are then first-touched on that node
+ * - 'core': every worker is pinned to a single CPU
+ */
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const NODE_SYSFS = '/sys/devices/system/node';
+
+/**
+ * Parse a Linux CPU list such as "0-7,16-23"
+ */
+function parseCpuList(text) {
+    const cpus = [];
+    for (const part of String(text || '').split(',')) {
+        const range = part.trim();
+        if (!range) {
+            continue;
+        }
+        const [start, end] = range.split('-').map(n => parseInt(n, 10));
+        if (Number.isNaN(start) || (end !== undefined && Number.isNaN(end))) {
+            throw new Error(`Invalid CPU list: "${text}"`);
+        }
+        for (let cpu = start; cpu <= (end === undefined ? start : end); cpu++) {
+            cpus.push(cpu);
+        }
+    }
+    return cpus;
+}
+
+/**
+ * NUMA nodes with their CPUs, e.g. [{ node: 0, cpus: [0, 1, ...] }, ...].
+ * Falls back to a single node holding every CPU when sysfs is unavailable.
+ */
+function readNumaNodes() {
+    try {
+        const nodes = fs.readdirSync(NODE_SYSFS)
+            .filter(name => /^node\d+$/.test(name))
+            .map(name => ({
+                node: parseInt(name.slice(4), 10),
+                cpus: parseCpuList(fs.readFileSync(path.join(NODE_SYSFS, name, 'cpulist'), 'utf8'))
+            }))
+            .filter(entry => entry.cpus.length > 0)
+            .sort((a, b) => a.node - b.node);
+        if (nodes.length > 0) {
+            return nodes;
+        }
+    } catch (err) {
+        // Not Linux or no sysfs
+    }
+    return [{ node: -1, cpus: os.cpus().map((_, i) => i) }];
+}
+
+/**
+ * Compute the placement of each worker: [{ cpus: [...] | null, numaNode }]
+ *
+ * @param {number} size - Number of workers
+ * @param {string} pinning - 'none', 'numa' or 'core'
+ * @param {string} [cpuList] - Restrict the pool to these CPUs (e.g. "0-7,16-23")
+ */
+function planAffinity(size, pinning, cpuList) {
+    const allowed = cpuList ? new Set(parseCpuList(cpuList)) : null;
+    const nodes = readNumaNodes()
+        .map(entry => ({ node: entry.node, cpus: allowed ? entry.cpus.filter(cpu => allowed.has(cpu)) : entry.cpus }))
+        .filter(entry => entry.cpus.length > 0);
+
+    if (nodes.length === 0) {
+        throw new Error(`No usable CPUs in "${cpuList}"`);
+    }
+
+    const plan = [];
+    for (let i = 0; i < size; i++) {
+        if (pinning === 'numa') {
+            const entry = nodes[i % nodes.length];
+            plan.push({ cpus: entry.cpus, numaNode: entry.node });
+        } else if (pinning === 'core') {
+            // Fill nodes one core at a time so neighbouring workers share a node
+            const all = nodes.flatMap(entry => entry.cpus.map(cpu => ({ cpu, node: entry.node })));
+            const pick = all[i % all.length];
+            plan.push({ cpus: [pick.cpu], numaNode: pick.node });
+        } else {
+            plan.push({ cpus: allowed ? nodes.flatMap(entry => entry.cpus) : null, numaNode: -1 });
+        }
+    }
+    return plan;
+}
+
+module.exports = { parseCpuList, readNumaNodes, planAffinity };
@@ -206,4 +206,28 @@ function loadAddon() {
   );
 }
 
-module.exports = loadAddon();
+/**
+ * Node-API cannot read a bare SharedArrayBuffer, so wrap it (or an image
+ * object's data) in a Uint8Array view. The view shares memory, no copy is made.
+ */
+function wrapSharedArrayBuffer(input) {
+  if (input instanceof SharedArrayBuffer) {
+    return new Uint8Array(input);
+  }
+  if (input && input.data instanceof SharedArrayBuffer) {
+    return { ...input, data: new Uint8Array(input.data) };
+  }
+  return input;
+}
+
+function withSharedArrayBufferSupport(addon) {
+  const wrapped = {};
+  for (const [name, value] of Object.entries(addon)) {
+    wrapped[name] = typeof value === 'function'
+      ? (input, ...args) => value(wrapSharedArrayBuffer(input), ...args)
+      : value;
+  }
+  return wrapped;
+}
+
+module.exports = withSharedArrayBufferSupport(loadAddon());
@@ -0,0 +1,107 @@
+/**
+ * Entry point of the decode workers used by lib/worker-pool.js.
+ *
+ * Runs either as a worker thread (worker isolation) or as a forked child
+ * process (process isolation). Each worker loads its own instance of the
+ * native addon and runs the block pipeline for the jobs it receives. Pixel
+ * data arrives as transferred (or shared) ArrayBuffers, or as shared-memory
+ * descriptors, and is never copied again here.
+ */
+const { parentPort, workerData, threadId } = require('worker_threads');
+
+const send = parentPort
+    ? (message) => parentPort.postMessage(message)
+    : (message) => process.send(message);
+const port = parentPort || process;
+
+if (!parentPort) {
+    // Child process: exit together with the parent
+    process.on('disconnect', () => process.exit(0));
+}
+
+const barcode = require('../index.js');
+const createPipeline = require('./pipeline');
+
+let Quagga = null;
+try {
+    Quagga = require('@ericblade/quagga2');
+} catch (err) {
+    // Quagga blocks will report that the decoder is not installed
+}
+
+const pipeline = createPipeline(barcode, Quagga);
+
+if (barcode.traceThreadName) {
+    barcode.traceThreadName(parentPort ? `decode worker ${threadId}` : `decode process ${process.pid}`);
+}
+
+/**
+ * Control commands from WorkerPool.control() (process mode), returns the reply
+ */
+function control(command) {
+    switch (command.name) {
+        case 'metrics':
+            return barcode.metricsSnapshot ? barcode.metricsSnapshot() : [];
+        case 'traceStart':
+            barcode.traceStart(command.capacity);
+            return true;
+        case 'traceStop':
+            barcode.traceStop();
+            return true;
+        case 'traceEvents':
+            return barcode.traceEvents();
+        default:
+            return undefined;
+    }
+}
+
+// Pin to the CPUs planned by lib/affinity.js before the first allocation,
+// so pixel buffers are first-touched on the local NUMA node
+const placement = parentPort
+    ? workerData && workerData.placement
+    : JSON.parse(process.env.BARCODE_WORKER_PLACEMENT || 'null');
+if (placement && placement.cpus) {
+    try {
+        barcode.setAffinity(placement.cpus, parentPort ? 'thread' : 'process');
+    } catch (err) {
+        send({ type: 'warn', message: `Could not pin decode worker: ${err.message}` });
+    }
+}
+
+/**
+ * Wrap transferred ArrayBuffers back into Buffers
+ */
+function unpackInput(input) {
+    if (input instanceof ArrayBuffer || input instanceof SharedArrayBuffer) {
+        return Buffer.from(input);
+    }
+    if (input && (input.data instanceof ArrayBuffer || input.data instanceof SharedArrayBuffer)) {
+        return { ...input, data: Buffer.from(input.data) };
+    }
+    return input;
+}
+
+port.on('message', async (job) => {
+    if (job.type === 'control') {
+        send({ id: job.id, type: 'control', reply: control(job.command) });
+        return;
+    }
+
+    // Forward warnings to the owning node; id and name label its metrics
+    const node = {
+        id: job.config.id,
+        name: job.config.name,
+        warn: (message) => send({ id: job.id, type: 'warn', message: message })
+    };
+
+    try {
+        const timings = {};
+        const results = await pipeline.processSingleImage(unpackInput(job.input), job.config, node, timings, job.config.image);
+        send({ id: job.id, type: 'result', results: results, timings: timings });
+    } catch (err) {
+        send({ id: job.id, type: 'error', message: err.message });
+    }
+});
+
+// Addon loaded and pinned: the pool resets its restart backoff
+send({ type: 'ready' });
@@ -0,0 +1,204 @@
+/**
+ * Engine metrics in the OpenMetrics text format.
+ *
+ * Counters and latency histograms live in the native registry
+ * (barcode-engine/src/metrics.cpp) and are recorded without locks from every
+ * thread of the process. Process-mode decode workers have their own registry,
+ * their snapshots are collected over IPC and summed with the local one.
+ * Worker pool gauges (busy/idle workers, queue depth) are read from the
+ * registered pools at scrape time.
+ *
+ * The text is served by the Node-RED admin route /barcode-reader/metrics and,
+ * optionally, by a plain HTTP listener on 127.0.0.1 (see startServer).
+ */
+const http = require('http');
+
+const CONTENT_TYPE = 'application/openmetrics-text; version=1.0.0; charset=utf-8';
+
+const HELP = {
+    barcode_frames: 'Images processed by the node',
+    barcode_frame_errors: 'Messages that failed in the node',
+    barcode_frame_seconds: 'Time to process one image, including queueing',
+    barcode_block_runs: 'Native block runs',
+    barcode_block_errors: 'Native block runs that returned an error',
+    barcode_block_symbols: 'Symbols decoded by a block',
+    barcode_block_stage_seconds: 'Native block stage durations',
+    barcode_shm_cache_lookups: 'Shared-memory mapping cache lookups',
+    barcode_pool_workers: 'Decode workers by state',
+    barcode_pool_queue_depth: 'Images waiting for a free decode worker',
+    barcode_pool_worker_restarts: 'Decode workers replaced after they died'
+};
+
+// Registered nodes: id -> { label, pool }
+const nodes = new Map();
+// Local listeners: port -> { server, users }
+const servers = new Map();
+
+/**
+ * Make a node's worker pool visible to collect()
+ */
+function registerNode(id, label, pool) {
+    nodes.set(id, { label: label, pool: pool });
+}
+
+function unregisterNode(id) {
+    nodes.delete(id);
+}
+
+/**
+ * Native series of this process, plus those of every process-mode worker,
+ * plus pool gauges; series with the same name and labels are summed
+ */
+async function collect(barcode) {
+    const snapshots = [barcode.metricsSnapshot ? barcode.metricsSnapshot() : []];
+    const gauges = [];
+
+    for (const { label, pool } of nodes.values()) {
+        if (!pool) {
+            continue;
+        }
+        snapshots.push(...await pool.control({ name: 'metrics' }));
+
+        const stats = pool.stats();
+        gauges.push(
+            { name: 'barcode_pool_workers', type: 'gauge', labels: { node: label, state: 'busy' }, value: stats.busy },
+            { name: 'barcode_pool_workers', type: 'gauge', labels: { node: label, state: 'idle' }, value: stats.idle },
+            { name: 'barcode_pool_queue_depth', type: 'gauge', labels: { node: label }, value: stats.queued },
+            { name: 'barcode_pool_worker_restarts', type: 'counter', labels: { node: label }, value: stats.restarts }
+        );
+    }
+
+    return merge(snapshots.flat()).concat(gauges);
+}
+
+function merge(samples) {
+    const merged = new Map();
+    for (const sample of samples) {
+        const key = sample.name + JSON.stringify(sample.labels);
+        const existing = merged.get(key);
+        if (!existing) {
+            merged.set(key, {
+                ...sample,
+                buckets: sample.buckets && sample.buckets.map(bucket => ({ ...bucket }))
+            });
+        } else if (sample.type === 'counter') {
+            existing.value += sample.value;
+        } else {
+            existing.count += sample.count;
+            existing.sumMs += sample.sumMs;
+            sample.buckets.forEach((bucket, i) => {
+                existing.buckets[i].count += bucket.count;
+            });
+        }
+    }
+    return Array.from(merged.values());
+}
+
+function formatLabels(labels, extra) {
+    const pairs = Object.entries({ ...labels, ...extra }).map(([name, value]) =>
+        `${name}="${String(value).replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\n/g, '\\n')}"`);
+    return pairs.length > 0 ? `{${pairs.join(',')}}` : '';
+}
+
+/**
+ * OpenMetrics exposition of collected samples; histograms are recorded in
+ * milliseconds and exported in seconds
+ */
+function render(samples) {
+    const families = new Map();
+    for (const sample of samples) {
+        if (!families.has(sample.name)) {
+            families.set(sample.name, []);
+        }
+        families.get(sample.name).push(sample);
+    }
+
+    const lines = [];
+    for (const [name, series] of [...families].sort((a, b) => a[0].localeCompare(b[0]))) {
+        const type = series[0].type;
+        lines.push(`# TYPE ${name} ${type}`);
+        if (name.endsWith('_seconds')) {
+            lines.push(`# UNIT ${name} seconds`);
+        }
+        if (HELP[name]) {
+            lines.push(`# HELP ${name} ${HELP[name]}`);
+        }
+
+        for (const sample of series) {
+            if (type === 'histogram') {
+                for (const bucket of sample.buckets) {
+                    lines.push(`${name}_bucket${formatLabels(sample.labels, { le: bucket.le / 1000 })} ${bucket.count}`);
+                }
+                lines.push(`${name}_bucket${formatLabels(sample.labels, { le: '+Inf' })} ${sample.count}`);
+                lines.push(`${name}_count${formatLabels(sample.labels)} ${sample.count}`);
+                lines.push(`${name}_sum${formatLabels(sample.labels)} ${sample.sumMs / 1000}`);
+            } else if (type === 'counter') {
+                lines.push(`${name}_total${formatLabels(sample.labels)} ${sample.value}`);
+            } else {
+                lines.push(`${name}${formatLabels(sample.labels)} ${sample.value}`);
+            }
+        }
+    }
+    lines.push('# EOF');
+    return lines.join('\n') + '\n';
+}
+
+/**
+ * Express/http handler writing the current metrics
+ */
+function handler(barcode) {
+    return async (req, res) => {
+        try {
+            const body = render(await collect(barcode));
+            res.writeHead(200, { 'Content-Type': CONTENT_TYPE });
+            res.end(body);
+        } catch (err) {
+            res.writeHead(500, { 'Content-Type': 'text/plain' });
+            res.end(err.message);
+        }
+    };
+}
+
+/**
+ * Serve GET /metrics on 127.0.0.1:port; nodes configured with the same port
+ * share one listener
+ */
+function startServer(barcode, port, onError) {
+    let entry = servers.get(port);
+    if (!entry) {
+        const serve = handler(barcode);
+        const server = http.createServer((req, res) => {
+            if (req.method === 'GET' && req.url.split('?')[0] === '/metrics') {
+                serve(req, res);
+            } else {
+                res.writeHead(404);
+                res.end();
+            }
+        });
+        server.on('error', onError);
+        server.listen(port, '127.0.0.1');
+        entry = { server: server, users: 0 };
+        servers.set(port, entry);
+    }
+    entry.users++;
+}
+
+function stopServer(port) {
+    const entry = servers.get(port);
+    if (entry && --entry.users === 0) {
+        servers.delete(port);
+        return new Promise(resolve => entry.server.close(() => resolve()));
+    }
+    return Promise.resolve();
+}
+
+module.exports = {
+    CONTENT_TYPE,
+    registerNode,
+    unregisterNode,
+    collect,
+    render,
+    handler,
+    startServer,
+    stopServer
+};
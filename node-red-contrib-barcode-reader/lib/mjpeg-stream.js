@@ -0,0 +1,169 @@
+/**
+ * MJPEG camera streams (multipart/x-mixed-replace over HTTP, or bare
+ * concatenated JPEGs) scanned frame by frame.
+ *
+ * Chunks of the raw stream arrive as messages { mjpeg: "<stream id>", data }
+ * of any size, as read from the socket. The native demuxer (src/mjpeg.cpp)
+ * finds the JPEG frames in them without copying and each frame is queued for
+ * scanning as a reduced grayscale image. When frames arrive faster than they
+ * are scanned, the queue drops frames by policy: "oldest" keeps the freshest
+ * frames (live monitoring), "newest" keeps the frames already waiting.
+ * Drops are counted in the barcode_frames_dropped metric by policy. A stream
+ * that receives no chunk for idleMs (a camera that disconnected without
+ * `end`) is closed, with its demuxer and queue.
+ */
+
+// Frames waiting per stream, besides the one being scanned
+const DEFAULT_QUEUE = 1;
+
+// Streams without a chunk for this long are closed
+const DEFAULT_IDLE_MS = 60000;
+
+/**
+ * Stream chunk message: { mjpeg: "<id>", data }
+ */
+function isMjpegInput(input) {
+    return input !== null && typeof input === 'object' && !ArrayBuffer.isView(input) &&
+        typeof input.mjpeg === 'string';
+}
+
+class MjpegStreams {
+    /**
+     * @param {object} options
+     * @param {object} options.barcode - Native addon (needs mjpegOpen/mjpegPush/mjpegDiscarded)
+     * @param {function} options.process - async (frameInput, frame, context) scanning one frame;
+     *   frameInput is { data, reduce }, frame is { stream, seq, dropped, discarded }
+     * @param {function} [options.onError] - (err, context) for a frame that failed to scan
+     * @param {object} [options.metricsLabels] - Labels of the drop counters (e.g. { node })
+     * @param {number} [options.idleMs] - Close streams idle for this long (default 60 s)
+     */
+    constructor(options) {
+        this.barcode = options.barcode;
+        this.process = options.process;
+        this.onError = options.onError || (() => {});
+        this.metricsLabels = options.metricsLabels || null;
+        this.dropCounters = new Map();
+        this.idleMs = options.idleMs || DEFAULT_IDLE_MS;
+        this.streams = new Map();
+        this.closed = false;
+        this.sweeper = setInterval(() => this.sweep(), Math.max(1000, this.idleMs / 2));
+        this.sweeper.unref();
+    }
+
+    /**
+     * Push one chunk message; the frames it completes are queued for scanning.
+     * Settings (reduce, queue, drop, maxFrameBytes) are taken from the first
+     * chunk of a stream; `end: true` closes the stream once its queue is scanned.
+     *
+     * @param {object} input - { mjpeg, data, reduce, queue, drop, maxFrameBytes, end }
+     * @param {*} context - Passed to options.process with each frame of this chunk
+     * @returns {{frames: number, dropped: number}} frames completed by the chunk,
+     *   frames dropped by the stream so far
+     */
+    push(input, context) {
+        let stream = this.streams.get(input.mjpeg);
+        if (!stream) {
+            stream = {
+                id: input.mjpeg,
+                handle: this.barcode.mjpegOpen(input.maxFrameBytes),
+                reduce: input.reduce || 1,
+                queueSize: Math.max(1, parseInt(input.queue, 10) || DEFAULT_QUEUE),
+                drop: input.drop === 'newest' ? 'newest' : 'oldest',
+                queue: [],
+                running: false,
+                frames: 0,
+                dropped: 0,
+                lastChunk: 0
+            };
+            this.streams.set(input.mjpeg, stream);
+        }
+        stream.lastChunk = Date.now();
+
+        const found = input.data ? this.barcode.mjpegPush(stream.handle, input.data) : [];
+        for (const data of found) {
+            const frame = { data: data, seq: stream.frames++, context: context };
+            if (stream.queue.length >= stream.queueSize) {
+                stream.dropped++;
+                this.countDrop(stream.drop);
+                if (stream.drop === 'newest') {
+                    continue;
+                }
+                stream.queue.shift();
+            }
+            stream.queue.push(frame);
+            // An idle stream takes the frame at once, so only frames behind it queue
+            this.drain(stream);
+        }
+
+        if (input.end) {
+            this.streams.delete(input.mjpeg);
+        }
+        return { frames: found.length, dropped: stream.dropped };
+    }
+
+    /**
+     * Count a dropped frame in barcode_frames_dropped{policy}
+     */
+    countDrop(policy) {
+        if (!this.metricsLabels || !this.barcode.metricsCounter) {
+            return;
+        }
+        let counter = this.dropCounters.get(policy);
+        if (!counter) {
+            counter = this.barcode.metricsCounter('barcode_frames_dropped', { ...this.metricsLabels, policy: policy });
+            this.dropCounters.set(policy, counter);
+        }
+        this.barcode.metricsAdd(counter);
+    }
+
+    /**
+     * Close the streams that received no chunk for idleMs; frames still
+     * queued are scanned first
+     */
+    sweep() {
+        const now = Date.now();
+        for (const [id, stream] of this.streams) {
+            if (now - stream.lastChunk >= this.idleMs) {
+                this.streams.delete(id);
+            }
+        }
+    }
+
+    /**
+     * Scan the queued frames of a stream one at a time
+     */
+    async drain(stream) {
+        if (stream.running) {
+            return;
+        }
+        stream.running = true;
+        while (stream.queue.length > 0 && !this.closed) {
+            const frame = stream.queue.shift();
+            try {
+                await this.process({ data: frame.data, reduce: stream.reduce }, {
+                    stream: stream.id,
+                    seq: frame.seq,
+                    dropped: stream.dropped,
+                    discarded: this.barcode.mjpegDiscarded(stream.handle)
+                }, frame.context);
+            } catch (err) {
+                this.onError(err, frame.context);
+            }
+        }
+        stream.running = false;
+    }
+
+    /**
+     * Drop every stream and the frames still queued
+     */
+    close() {
+        this.closed = true;
+        clearInterval(this.sweeper);
+        for (const stream of this.streams.values()) {
+            stream.queue.length = 0;
+        }
+        this.streams.clear();
+    }
+}
+
+module.exports = { MjpegStreams, isMjpegInput };
@@ -0,0 +1,641 @@
+/**
+ * Block pipeline shared by the Node-RED node and the decode workers.
+ *
+ * The pipeline runs every configured block (preprocessing + decoder) over an
+ * image, deduplicates the detections and converts them to the node's output
+ * format. It only depends on the native addon and, optionally, Quagga2, so it
+ * can run either in the Node-RED main thread or inside a worker thread.
+ *
+ * src/pipeline.cpp mirrors the ZBar/ZXing part (block defaults, sequential
+ * early exit, scale back, deduplication, output format) for barcode_scan,
+ * barcode_serve and the C API; change both together and compare them with
+ * tools/parity.js.
+ */
+const trace = require('./trace');
+
+module.exports = function createPipeline(barcode, Quagga) {
+    // metricsBlock() handles, by node and block configuration
+    const metricsHandles = new Map();
+
+    /**
+     * Process a single image through all blocks
+     *
+     * When a timings object is given, it receives the per-block stage times
+     * (timings.blocks) and the JavaScript stages (fileDecodeMs for file
+     * inputs, frameDecodeMs for camera frames, roiDecodeMs with roiRegions and
+     * roiFallback for hinted regions, prescanMs with prescanRegions and prescanFallback for
+     * pre-scanned JPEGs, dimensionsMs, dedupMs,
+     * conversionMs), all in milliseconds. The optional image id tags the
+     * trace spans of this image. For a file input, decoded may hold its
+     * decodeFile() promise when the page was decoded ahead.
+     */
+    async function processSingleImage(input, config, node, timings, image, decoded) {
+        const traceStart = trace.now(barcode);
+
+        // Image files ({ path }, or { path, page } for one page of a
+        // multi-page TIFF) are mapped and decoded once on the libuv thread
+        // pool, every block then shares the decoded pixels.
+        let start = process.hrtime.bigint();
+        let fileDecodeMs;
+        let frameDecodeMs;
+        if (isFileInput(input)) {
+            input = await (decoded || barcode.decodeFile(input.path, image, input.page));
+            fileDecodeMs = elapsedMs(start);
+            start = process.hrtime.bigint();
+        } else if (isFrameInput(input)) {
+            // Camera frames ({ data: <JPEG>, reduce }) are decoded once, in
+            // grayscale at reduced resolution, off the event loop
+            input = await barcode.decodeFrame(input.data, input.reduce, image);
+            frameDecodeMs = elapsedMs(start);
+            start = process.hrtime.bigint();
+        }
+
+        // Region hints ({ data, roi }) only apply to encoded JPEGs, other
+        // images, and an empty hint list, are scanned whole
+        let roi = null;
+        if (isRoiInput(input)) {
+            roi = input.roi.length > 0 ? input.roi : null;
+            input = input.data;
+        }
+
+        // Get blocks configuration
+        const blocks = config.blocks || [];
+        const executionMode = config.executionMode || 'parallel';
+
+        if (blocks.length === 0) {
+            node.warn('No decoder blocks configured');
+            return [];
+        }
+
+        let allResults = [];
+        const blockTimings = timings ? [] : null;
+        let imageDimensions = null;
+        let dimensionsMs;
+        let roiTimings;
+        let prescan;
+
+        if (roi && isJpegData(input)) {
+            // Hinted regions: only the MCUs covering them are decoded, in
+            // grayscale, and only they are scanned. Hints are an optimisation:
+            // when they miss the image or libjpeg cannot decode the regions
+            // (CMYK, arithmetic coding, ...), the whole image is scanned.
+            const scan = await barcode.jpegDecodeRegions(input, roi, image).catch(() => null);
+            roiTimings = { roiDecodeMs: elapsedMs(start), roiRegions: scan && scan.regions ? scan.regions.length : 0 };
+            if (roiTimings.roiRegions > 0) {
+                allResults = await scanRegions(scan.regions, blocks, executionMode, node, blockTimings, image);
+                imageDimensions = { width: scan.width, height: scan.height };
+            } else {
+                roiTimings.roiFallback = true;
+            }
+            start = process.hrtime.bigint();
+        } else if (config.jpegPrescan && isJpegData(input)) {
+            // JPEG pre-scan: a 1/8 DC-only preview locates the textured areas
+            // and only those are decoded at full resolution and scanned. When
+            // they hold no symbol, or the pre-scan itself fails, the whole
+            // image is scanned as usual.
+            const scan = await barcode.jpegPrescan(input, image).catch(() => ({ regions: null }));
+            prescan = { prescanMs: elapsedMs(start), prescanRegions: scan.regions ? scan.regions.length : 0 };
+            allResults = await scanRegions(scan.regions || [], blocks, executionMode, node, blockTimings, image);
+            if (allResults.length > 0) {
+                imageDimensions = { width: scan.width, height: scan.height };
+            } else {
+                prescan.prescanFallback = true;
+            }
+            start = process.hrtime.bigint();
+        }
+
+        if (!imageDimensions) {
+            // Get image dimensions for relative coordinate conversion
+            imageDimensions = getImageDimensions(input);
+            dimensionsMs = elapsedMs(start);
+            allResults = await runBlocks(input, blocks, executionMode, node, blockTimings, image);
+        }
+
+        // Deduplicate results
+        start = process.hrtime.bigint();
+        const dedupResults = deduplicateResults(allResults);
+        const dedupMs = elapsedMs(start);
+
+        // Convert to relative coordinates and final format
+        start = process.hrtime.bigint();
+        const finalResults = dedupResults.map(result =>
+            convertToFinalFormat(result, imageDimensions)
+        );
+
+        if (timings) {
+            if (fileDecodeMs !== undefined) {
+                timings.fileDecodeMs = fileDecodeMs;
+            }
+            if (frameDecodeMs !== undefined) {
+                timings.frameDecodeMs = frameDecodeMs;
+            }
+            if (roiTimings) {
+                Object.assign(timings, roiTimings);
+            }
+            if (prescan) {
+                Object.assign(timings, prescan);
+            }
+            if (dimensionsMs !== undefined) {
+                timings.dimensionsMs = dimensionsMs;
+            }
+            timings.blocks = blockTimings.sort((a, b) => (a.region ?? -1) - (b.region ?? -1) || a.block - b.block);
+            timings.dedupMs = dedupMs;
+            timings.conversionMs = elapsedMs(start);
+        }
+
+        trace.span(barcode, 'image', traceStart, { image: image });
+        return finalResults;
+    }
+
+    /**
+     * Run the blocks over one image in the configured execution mode
+     */
+    async function runBlocks(input, blocks, executionMode, node, timings, image) {
+        if (executionMode === 'sequential') {
+            // Sequential: process blocks in order, stop at first success
+            return processSequential(input, blocks, node, Quagga, timings, image);
+        }
+        // Parallel: process all blocks and merge results
+        return processParallel(input, blocks, node, Quagga, timings, image);
+    }
+
+    /**
+     * Run the blocks over decoded regions ({ x, y, image }), points mapped
+     * back to the full image. Block timings are labelled with the region
+     * index, apart from those of a later whole-image scan.
+     */
+    async function scanRegions(regions, blocks, executionMode, node, timings, image) {
+        const results = [];
+        for (const [index, region] of regions.entries()) {
+            const regionTimings = timings ? [] : null;
+            const found = await runBlocks(region.image, blocks, executionMode, node, regionTimings, image);
+            if (timings) {
+                timings.push(...regionTimings.map(entry => ({ ...entry, region: index })));
+            }
+            results.push(...found.map(result => ({
+                ...result,
+                points: offsetPoints(result.points, region.x, region.y)
+            })));
+        }
+        return results;
+    }
+
+    /**
+     * Process blocks sequentially (early exit on first success)
+     */
+    async function processSequential(input, blocks, node, Quagga, timings, image) {
+        for (let i = 0; i < blocks.length; i++) {
+            const block = blocks[i];
+
+            try {
+                const results = await processBlock(input, block, i, node, Quagga, timings, image);
+
+                if (results.length > 0) {
+                    // Found results, early exit
+                    return results;
+                }
+            } catch (err) {
+                node.warn(`Block ${i} (${block.decoder}) failed: ${err.message}`);
+            }
+        }
+
+        return [];
+    }
+
+    /**
+     * Process blocks in parallel (merge all results)
+     */
+    async function processParallel(input, blocks, node, Quagga, timings, image) {
+        const promises = blocks.map((block, index) => {
+            return processBlock(input, block, index, node, Quagga, timings, image).catch(err => {
+                node.warn(`Block ${index} (${block.decoder}) failed: ${err.message}`);
+                return [];
+            });
+        });
+
+        const resultsArrays = await Promise.all(promises);
+        return resultsArrays.flat();
+    }
+
+    /**
+     * Process a single block (preprocessing + decoding)
+     *
+     * If timings is an array, the block's stage times are pushed to it
+     */
+    async function processBlock(input, block, blockIndex, node, Quagga, timings, image) {
+        const start = process.hrtime.bigint();
+        const traceArgs = { image: image, block: blockIndex };
+
+        // Optional downscale, results are mapped back to input coordinates
+        const scale = parseFloat(block.scale) || 1;
+        const scaled = scale > 0 && scale < 1;
+
+        // Decode based on decoder type
+        let decoded;
+
+        switch (block.decoder) {
+            case 'zbar':
+            case 'zxing':
+                decoded = decodeNative(input, block, scaled ? scale : 1, blockMetrics(node, block, blockIndex), traceArgs);
+                break;
+            case 'quagga2': {
+                const traceStart = trace.now(barcode);
+                decoded = await decodeQuaggaBlock(input, block, scaled ? scale : 1, node, Quagga);
+                trace.span(barcode, 'block_quagga2', traceStart, traceArgs);
+                break;
+            }
+            default:
+                throw new Error(`Unknown decoder: ${block.decoder}`);
+        }
+
+        if (timings) {
+            timings.push({
+                block: blockIndex,
+                decoder: block.decoder,
+                preprocessing: block.preprocessing,
+                ...decoded.timings,
+                totalMs: elapsedMs(start)
+            });
+        }
+
+        // Add block metadata to results
+        return decoded.results.map(result => ({
+            ...result,
+            points: scaled ? scalePoints(result.points, 1 / scale) : result.points,
+            blockIndex: blockIndex,
+            decoder: block.decoder,
+            preprocessing: block.preprocessing
+        }));
+    }
+
+    /**
+     * Image file reference: { path[, page] } (binary inputs and bitmaps have no path)
+     */
+    function isFileInput(input) {
+        return input !== null && typeof input === 'object' && !ArrayBuffer.isView(input) &&
+            typeof input.path === 'string';
+    }
+
+    /**
+     * Encoded JPEG in binary data (SOI marker)
+     */
+    function isJpegData(input) {
+        if (!ArrayBuffer.isView(input) || input.byteLength < 3) {
+            return false;
+        }
+        const bytes = new Uint8Array(input.buffer, input.byteOffset, 3);
+        return bytes[0] === 0xFF && bytes[1] === 0xD8 && bytes[2] === 0xFF;
+    }
+
+    /**
+     * Encoded frame to decode reduced: { data, reduce } (bitmaps carry width/height)
+     */
+    function isFrameInput(input) {
+        return input !== null && typeof input === 'object' && !ArrayBuffer.isView(input) &&
+            typeof input.reduce === 'number' && input.data !== undefined && !input.width;
+    }
+
+    /**
+     * Image with region hints: { data, roi: [{ x, y, width, height }] }
+     */
+    function isRoiInput(input) {
+        return input !== null && typeof input === 'object' && !ArrayBuffer.isView(input) &&
+            Array.isArray(input.roi) && input.data !== undefined;
+    }
+
+    /**
+     * Milliseconds since a process.hrtime.bigint() timestamp
+     */
+    function elapsedMs(start) {
+        return Number(process.hrtime.bigint() - start) / 1e6;
+    }
+
+    /**
+     * Multiply every corner coordinate by a factor
+     */
+    function scalePoints(points, factor) {
+        const scaled = {};
+        for (const [key, value] of Object.entries(points)) {
+            scaled[key] = value * factor;
+        }
+        return scaled;
+    }
+
+    /**
+     * Move points found in a region of the image to image coordinates
+     */
+    function offsetPoints(points, dx, dy) {
+        const moved = {};
+        for (const [key, value] of Object.entries(points)) {
+            moved[key] = value + (key[0] === 'x' ? dx : dy);
+        }
+        return moved;
+    }
+
+    /**
+     * Apply preprocessing to image
+     */
+    function applyPreprocessing(input, method) {
+        switch (method) {
+            case 'original':
+                return barcode.preprocess_original(input);
+            case 'histogram':
+                return barcode.preprocess_histogram(input);
+            case 'otsu':
+                return barcode.preprocess_otsu(input);
+            default:
+                throw new Error(`Unknown preprocessing method: ${method}`);
+        }
+    }
+
+    /**
+     * Native decoder options of a ZBar or ZXing block, with defaults filled in
+     */
+    function nativeOptions(block) {
+        const options = block.options || {};
+
+        if (block.decoder === 'zbar') {
+            return {
+                symbologies: options.symbologies || '',
+                density: parseInt(options.density, 10) || 1
+            };
+        }
+
+        const zxingOptions = {
+            tryHarder: options.tryHarder || false,
+            formats: options.formats || '',
+            binarizer: options.binarizer || 'LocalAverage'
+        };
+        if (options.tryRotate !== undefined) {
+            zxingOptions.tryRotate = options.tryRotate;
+        }
+        return zxingOptions;
+    }
+
+    /**
+     * Native metrics handle of a block, labelled with the owning node
+     */
+    function blockMetrics(node, block, blockIndex) {
+        if (!barcode.metricsBlock) {
+            return undefined;
+        }
+
+        const labels = {
+            node: node.name || node.id || 'barcode-reader',
+            block: String(blockIndex),
+            decoder: block.decoder,
+            preprocessing: block.preprocessing || 'original'
+        };
+        const key = Object.values(labels).join('|');
+
+        let handle = metricsHandles.get(key);
+        if (!handle) {
+            handle = barcode.metricsBlock(labels);
+            metricsHandles.set(key, handle);
+        }
+        return handle;
+    }
+
+    /**
+     * Run a ZBar or ZXing block in a single native call (input conversion,
+     * scale, preprocessing and decoder timed with steady_clock)
+     */
+    function decodeNative(input, block, scale, metrics, traceArgs) {
+        const { results, timings } = barcode.decode_block(input, {
+            decoder: block.decoder,
+            preprocessing: block.preprocessing,
+            scale: scale,
+            options: nativeOptions(block)
+        }, metrics, traceArgs);
+
+        const start = process.hrtime.bigint();
+        const parsed = JSON.parse(results);
+
+        if (parsed.error) {
+            throw new Error(parsed.error);
+        }
+
+        timings.parseMs = elapsedMs(start);
+        return { results: parsed.results || [], timings: timings };
+    }
+
+    /**
+     * Run a Quagga2 block, stages timed in JavaScript
+     */
+    async function decodeQuaggaBlock(input, block, scale, node, Quagga) {
+        const timings = {};
+
+        let start = process.hrtime.bigint();
+        const source = scale < 1 ? barcode.resizeImage(input, scale * 100) : input;
+        timings.scaleMs = elapsedMs(start);
+
+        start = process.hrtime.bigint();
+        const preprocessed = applyPreprocessing(source, block.preprocessing);
+        timings.preprocessMs = elapsedMs(start);
+
+        start = process.hrtime.bigint();
+        const results = await decodeWithQuagga(preprocessed, block, node, Quagga);
+        timings.decodeMs = elapsedMs(start);
+
+        return { results: results, timings: timings };
+    }
+
+    /**
+     * Decode with Quagga2
+     */
+    async function decodeWithQuagga(preprocessed, block, node, Quagga) {
+        if (!Quagga) {
+            throw new Error('Quagga2 is not installed');
+        }
+
+        return new Promise(async (resolve, reject) => {
+            try {
+                const jpeg = require('jpeg-js');
+
+                // Convert grayscale Buffer to RGBA for jpeg-js
+                // Preprocessed data is grayscale (1 channel), jpeg-js needs RGBA (4 channels)
+                const rgbaData = Buffer.alloc(preprocessed.width * preprocessed.height * 4);
+                for (let i = 0; i < preprocessed.data.length; i++) {
+                    const gray = preprocessed.data[i];
+                    rgbaData[i * 4] = gray;     // R
+                    rgbaData[i * 4 + 1] = gray; // G
+                    rgbaData[i * 4 + 2] = gray; // B
+                    rgbaData[i * 4 + 3] = 255;  // A (fully opaque)
+                }
+
+                // Encode to JPEG (quality 85 is good balance for barcodes)
+                const jpegData = jpeg.encode({
+                    data: rgbaData,
+                    width: preprocessed.width,
+                    height: preprocessed.height
+                }, 85);
+
+                // Convert to base64 data URI
+                const base64 = jpegData.data.toString('base64');
+                const dataUri = `data:image/jpeg;base64,${base64}`;
+
+                Quagga.decodeSingle({
+                    src: dataUri,  // Now using proper data URI format
+                    numOfWorkers: 0,
+                    decoder: {
+                        readers: [
+                            "code_128_reader",   // CODE 128 (logistics, shipping)
+                            "ean_reader",        // EAN-13 (retail products)
+                            "ean_8_reader",      // EAN-8 (small items)
+                            "upc_reader",        // UPC-A (North America retail)
+                            "upc_e_reader",      // UPC-E (small packages)
+                            "code_39_reader",    // CODE 39 (automotive, DoD)
+                            "codabar_reader"     // CODABAR (libraries, blood banks)
+                        ]
+                    }
+                }, (result) => {
+                    if (result && result.codeResult) {
+                        const boxes = result.boxes || [];
+                        let points = { x1: 0, y1: 0, x2: 0, y2: 0, x3: 0, y3: 0, x4: 0, y4: 0 };
+
+                        // Extract corner points if available
+                        if (boxes.length > 0 && boxes[0].length >= 4) {
+                            const box = boxes[0];
+                            points = {
+                                x1: box[0][0], y1: box[0][1],
+                                x2: box[1][0], y2: box[1][1],
+                                x3: box[2][0], y3: box[2][1],
+                                x4: box[3][0], y4: box[3][1]
+                            };
+                        }
+
+                        resolve([{
+                            type: result.codeResult.format,
+                            data: result.codeResult.code,
+                            points: points
+                        }]);
+                    } else {
+                        resolve([]);
+                    }
+                });
+            } catch (err) {
+                reject(err);
+            }
+        });
+    }
+
+    /**
+     * Deduplicate results by barcode value only
+     * When duplicates exist, keep detection from lowest blockIndex
+     */
+    function deduplicateResults(results) {
+        const map = new Map();
+
+        for (const result of results) {
+            const key = result.data;  // Use only barcode value for deduplication
+            const detectionString = `${result.decoder}_${result.preprocessing}`;
+
+            if (map.has(key)) {
+                const existing = map.get(key);
+
+                // Add detection string if not already present
+                if (!existing.detectedBy.includes(detectionString)) {
+                    existing.detectedBy.push(detectionString);
+                }
+
+                // If new result has lower blockIndex, replace base detection
+                if (result.blockIndex < existing.blockIndex) {
+                    map.set(key, {
+                        ...result,
+                        blockIndex: result.blockIndex,
+                        detectedBy: existing.detectedBy
+                    });
+                }
+            } else {
+                map.set(key, {
+                    ...result,
+                    detectedBy: [detectionString]
+                });
+            }
+        }
+
+        return Array.from(map.values());
+    }
+
+    /**
+     * Convert result to final format with relative coordinates
+     */
+    function convertToFinalFormat(result, imageDimensions) {
+        const { width, height } = imageDimensions;
+        const points = result.points;
+
+        // Convert absolute pixel coordinates to relative (0-1)
+        const corners = [
+            { x: points.x2 / width, y: points.y2 / height },
+            { x: points.x3 / width, y: points.y3 / height },
+            { x: points.x4 / width, y: points.y4 / height },
+            { x: points.x1 / width, y: points.y1 / height }
+        ];
+
+        // Calculate center, size, and angle
+        const absoluteCorners = [
+            points.x2, points.y2,
+            points.x3, points.y3,
+            points.x4, points.y4,
+            points.x1, points.y1
+        ];
+        const [center, size, angle] = getRotation(absoluteCorners);
+
+        return {
+            format: result.type,
+            value: result.data,
+            box: {
+                angle: angle,
+                center: {
+                    x: center[0] / width,
+                    y: center[1] / height
+                },
+                size: {
+                    width: size[0] / width,
+                    height: size[1] / height
+                }
+            },
+            corners: corners,
+            detectedBy: result.detectedBy
+        };
+    }
+
+    /**
+     * Get image dimensions from input
+     */
+    function getImageDimensions(input) {
+        if (input.width && input.height) {
+            return { width: input.width, height: input.height };
+        }
+
+        // Fallback for buffer inputs (try to decode)
+        try {
+            const converted = barcode.convertToMat(input);
+            return { width: converted.width, height: converted.height };
+        } catch (err) {
+            throw new Error('Could not determine image dimensions');
+        }
+    }
+
+    /**
+     * Calculate rotation, center, and size from corner points
+     */
+    function getRotation(l) {
+        const center = [(l[0] + l[4]) / 2, (l[1] + l[5]) / 2];
+        const diffs = [l[0] - l[6], l[1] - l[7]];
+        const rotation = -Math.atan(diffs[0] / diffs[1]) * 180 / Math.PI;
+
+        const sizeY = Math.sqrt((l[6] - l[0])**2 + (l[7] - l[1])**2);
+        const sizeX = Math.sqrt((l[2] - l[0])**2 + (l[3] - l[1])**2);
+        const size = [sizeX, sizeY];
+
+        return [center, size, rotation];
+    }
+    return {
+        processSingleImage,
+        processBlock,
+        deduplicateResults,
+        convertToFinalFormat,
+        getImageDimensions
+    };
+};
@@ -0,0 +1,198 @@
+/**
+ * Traffic recording for offline replay (tools/replay.js).
+ *
+ * Every processed image is appended to a capture file written through a
+ * memory mapping by the native addon (src/record.cpp): the input as received
+ * (encoded bytes or raw pixels), the message metadata, its arrival time and
+ * the results the node produced. The first record of a recording holds the
+ * node configuration. Appending is a copy into the page cache, the kernel
+ * writes it back in the background; a recording stops at its size limit.
+ * Image files ({ path }) are read on the libuv thread pool, not on the event
+ * loop; records behind a pending read wait for it, so the capture keeps
+ * arrival order.
+ */
+const fs = require('fs');
+const { describeInput } = require('./slow-frames');
+
+// Node settings that change what the pipeline produces or how it is scheduled
+const RECORDED_SETTINGS = ['blocks', 'executionMode', 'jpegPrescan', 'isolation', 'workers', 'pinning', 'cpus', 'inputValue', 'outputValue'];
+
+class TrafficRecorder {
+    /**
+     * @param {object} options
+     * @param {object} options.barcode - Native addon (needs recordOpen/recordAppend/recordClose)
+     * @param {string} options.file - Capture file, continued when it already exists
+     * @param {number} [options.maxBytes] - Stop recording at this file size (0: unlimited)
+     * @param {object} options.config - Node configuration
+     * @param {object} [options.node] - { id, name } of the recording node
+     * @param {function} [options.onWarn] - Receives recording warnings (once per cause)
+     */
+    constructor(options) {
+        this.barcode = options.barcode;
+        this.file = options.file;
+        this.onWarn = options.onWarn || (() => {});
+        this.warned = new Set();
+        this.start = process.hrtime.bigint();
+        // Appends waiting for an image file read, in arrival order
+        this.queue = Promise.resolve();
+        this.reads = 0;
+        this.handle = this.barcode.recordOpen(this.file, options.maxBytes || 0);
+
+        const settings = {};
+        for (const key of RECORDED_SETTINGS) {
+            if (options.config[key] !== undefined) {
+                settings[key] = options.config[key];
+            }
+        }
+        this.append('config', {
+            recording: 1,
+            startedAt: new Date().toISOString(),
+            node: options.node || null,
+            config: settings
+        });
+    }
+
+    warnOnce(cause, message) {
+        if (!this.warned.has(cause)) {
+            this.warned.add(cause);
+            this.onWarn(message);
+        }
+    }
+
+    append(kind, meta, bytes) {
+        if (!this.handle) {
+            return false;
+        }
+        try {
+            this.barcode.recordAppend(this.handle, kind, JSON.stringify(meta), bytes);
+            return true;
+        } catch (err) {
+            // Size limit or full disk: keep what was recorded so far
+            this.warnOnce('append', `Recording to ${this.file} stopped: ${err.message}`);
+            this.stop();
+            return false;
+        }
+    }
+
+    /**
+     * Append one processed image
+     *
+     * @param {*} input - Image as received by the node
+     * @param {bigint} arrivedAt - process.hrtime.bigint() when the message arrived
+     * @param {object} message - { msgid, topic, index } of the image
+     * @param {Array} results - What the node output for the image
+     */
+    record(input, arrivedAt, message, results) {
+        if (!this.handle) {
+            return false;
+        }
+
+        const described = describeInput(input);
+        if (!described) {
+            this.warnOnce('input', 'Recording skipped an input that cannot be saved (shared-memory frame, unreadable file or later document page)');
+            return false;
+        }
+
+        const meta = {
+            timeMs: Number(arrivedAt - this.start) / 1e6,
+            msgid: message.msgid,
+            topic: message.topic,
+            index: message.index,
+            input: described.description,
+            results: results
+        };
+        if (!described.path && this.reads === 0) {
+            return this.append('frame', meta, described.bytes);
+        }
+
+        // The file is read off the event loop; an input queued behind a read
+        // is copied, as the caller may reuse its buffer meanwhile
+        const bytes = described.path
+            ? fs.promises.readFile(described.path).catch(() => null)
+            : Buffer.from(described.bytes);
+        this.reads++;
+        this.queue = this.queue
+            .then(() => bytes)
+            .then((data) => {
+                if (data) {
+                    this.append('frame', meta, data);
+                } else {
+                    this.warnOnce('input', 'Recording skipped an input that cannot be saved (shared-memory frame, unreadable file or later document page)');
+                }
+            })
+            .finally(() => {
+                this.reads--;
+            });
+        return true;
+    }
+
+    /**
+     * Write the records still waiting for a file read, then trim the file to
+     * its records and stop recording
+     */
+    close() {
+        return this.queue.then(() => this.stop());
+    }
+
+    /**
+     * Trim the file to its records and stop recording at once
+     */
+    stop() {
+        if (this.handle) {
+            const handle = this.handle;
+            this.handle = null;
+            this.barcode.recordClose(handle);
+        }
+    }
+}
+
+/**
+ * Read a capture file (zero copy: frame data are Buffers over the mapping)
+ *
+ * @returns {{config: object|null, frames: Array<{timeMs, msgid, topic, index, input, results}>}}
+ *   frames in arrival order, `input` rebuilt as the node received it
+ */
+function readRecording(barcode, file) {
+    let config = null;
+    const frames = [];
+    // A continued recording holds one config record per run, each run with
+    // its own clock: later runs are placed after the earlier ones
+    let runOffset = 0;
+    let lastTime = 0;
+
+    for (const record of barcode.recordRead(file)) {
+        const meta = JSON.parse(record.meta);
+        if (record.kind === 'config') {
+            config = config || meta;
+            runOffset = lastTime;
+        } else if (record.kind === 'frame') {
+            const timeMs = runOffset + meta.timeMs;
+            lastTime = Math.max(lastTime, timeMs);
+            frames.push({ ...meta, timeMs: timeMs, input: restoreInput(meta.input, record.data) });
+        }
+    }
+
+    frames.sort((a, b) => a.timeMs - b.timeMs);
+    return { config: config, frames: frames };
+}
+
+/**
+ * Node input from a recorded description and its bytes
+ */
+function restoreInput(description, data) {
+    if (description.roi) {
+        return { data: data, roi: description.roi };
+    }
+    if (description.format !== 'raw') {
+        return data;
+    }
+    const input = { data: data, width: description.width, height: description.height };
+    if (description.colorSpace) {
+        input.colorSpace = description.colorSpace;
+    } else {
+        input.channels = data.length / (description.width * description.height);
+    }
+    return input;
+}
+
+module.exports = { TrafficRecorder, readRecording, restoreInput };
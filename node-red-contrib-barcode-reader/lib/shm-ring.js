@@ -0,0 +1,96 @@
+/**
+ * Shared-memory frame slots for the process isolation mode.
+ *
+ * One POSIX shared-memory segment is split into fixed-size slots. The main
+ * process copies a frame into a free slot and sends the decode process only a
+ * small descriptor ({ shm, offset, ... }); the decode process maps the segment
+ * once and reads the frame in place.
+ */
+const CHANNELS_TO_COLOR_SPACE = { 1: 'GRAY', 3: 'RGB', 4: 'RGBA' };
+
+let nextRingId = 1;
+
+class ShmRing {
+    /**
+     * @param {object} barcode - Native addon (needs shmCreate/shmUnlink)
+     * @param {number} slotCount - Number of frames that can be in flight
+     * @param {number} slotSize - Maximum frame size in bytes
+     * @param {number} [numaNode] - Place the slots on this NUMA node (-1: no preference)
+     */
+    constructor(barcode, slotCount, slotSize, numaNode = -1) {
+        this.barcode = barcode;
+        this.name = `/rp-barcode-${process.pid}-${nextRingId++}`;
+        this.slotSize = slotSize;
+        this.memory = barcode.shmCreate(this.name, slotCount * slotSize, numaNode);
+        this.freeSlots = Array.from({ length: slotCount }, (_, i) => i);
+    }
+
+    /**
+     * Copy an image into a free slot and return { input: descriptor, slot },
+     * or null when the image cannot be placed (no slot, too large, unknown layout)
+     */
+    pack(input) {
+        let bytes = null;
+        let descriptor = null;
+
+        if (input instanceof SharedArrayBuffer || input instanceof ArrayBuffer) {
+            input = new Uint8Array(input);
+        }
+
+        if (ArrayBuffer.isView(input)) {
+            // Encoded image
+            bytes = input;
+            descriptor = { length: input.byteLength };
+        } else if (input && typeof input === 'object' && input.data && input.width && input.height) {
+            // Raw bitmap
+            const data = input.data instanceof SharedArrayBuffer || input.data instanceof ArrayBuffer
+                ? new Uint8Array(input.data)
+                : input.data;
+            if (!ArrayBuffer.isView(data)) {
+                return null;
+            }
+
+            const channels = data.byteLength / (input.width * input.height);
+            const colorSpace = input.colorSpace || CHANNELS_TO_COLOR_SPACE[channels];
+            if (!colorSpace || !Number.isInteger(channels)) {
+                return null;
+            }
+
+            bytes = data;
+            descriptor = {
+                width: input.width,
+                height: input.height,
+                stride: input.width * channels,
+                colorSpace: colorSpace
+            };
+        } else {
+            return null;
+        }
+
+        if (bytes.byteLength > this.slotSize || this.freeSlots.length === 0) {
+            return null;
+        }
+
+        const slot = this.freeSlots.pop();
+        const offset = slot * this.slotSize;
+        this.memory.set(new Uint8Array(bytes.buffer, bytes.byteOffset, bytes.byteLength), offset);
+
+        return {
+            input: { shm: this.name, offset: offset, ...descriptor },
+            slot: slot
+        };
+    }
+
+    release(slot) {
+        if (slot !== undefined && slot !== null) {
+            this.freeSlots.push(slot);
+        }
+    }
+
+    close() {
+        this.barcode.shmUnlink(this.name);
+        this.memory = null;
+    }
+}
+
+module.exports = { ShmRing };
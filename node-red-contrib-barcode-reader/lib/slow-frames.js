@@ -0,0 +1,229 @@
+/**
+ * Slow-frame capture: keeps the images that exceeded a latency threshold,
+ * with the block configuration and stage timings they were processed with.
+ *
+ * Every capture is two files in the capture directory:
+ *   <id>.<jpg|png|bmp|tif|webp|bin>  encoded input as received, or
+ *   <id>.raw                         raw bitmap pixels
+ *   <id>.json                        { capture: 1, input, elapsedMs, config, timings, ... }
+ *
+ * The directory can be passed to the tools as a corpus (tools/lib/corpus.js),
+ * so latency outliers can be replayed offline. Files are written by the libuv
+ * thread pool, never on the event loop, and image file inputs ({ path }) are
+ * copied by it without being read into memory; captures beyond the disk quota
+ * or beyond MAX_PENDING unwritten captures are dropped.
+ */
+const fs = require('fs');
+const path = require('path');
+
+const MAX_PENDING = 8;
+
+const SIGNATURES = [
+    { ext: '.jpg', bytes: [0xff, 0xd8, 0xff] },
+    { ext: '.png', bytes: [0x89, 0x50, 0x4e, 0x47] },
+    { ext: '.bmp', bytes: [0x42, 0x4d] },
+    { ext: '.tif', bytes: [0x49, 0x49, 0x2a, 0x00] },
+    { ext: '.tif', bytes: [0x4d, 0x4d, 0x00, 0x2a] },
+    { ext: '.webp', bytes: [0x52, 0x49, 0x46, 0x46] }
+];
+
+function toBuffer(data) {
+    if (data instanceof ArrayBuffer || data instanceof SharedArrayBuffer) {
+        return Buffer.from(data);
+    }
+    if (ArrayBuffer.isView(data)) {
+        return Buffer.from(data.buffer, data.byteOffset, data.byteLength);
+    }
+    return null;
+}
+
+function encodedExtension(bytes) {
+    const match = SIGNATURES.find(sig => sig.bytes.every((b, i) => bytes[i] === b));
+    return match ? match.ext : '.bin';
+}
+
+/**
+ * Bytes of an input (not copied) with its file extension and description,
+ * or null for inputs that cannot be saved (shared-memory descriptors, pages
+ * after the first of a multi-page file, which replays as its first page).
+ * Image files ({ path }) are not read here: the result holds their path instead
+ * of bytes, for the caller to read or copy off the event loop.
+ */
+function describeInput(input) {
+    if (input && typeof input === 'object' && typeof input.path === 'string' && !ArrayBuffer.isView(input)) {
+        if (input.page > 0) {
+            return null;
+        }
+        return {
+            path: input.path,
+            ext: path.extname(input.path).toLowerCase() || '.bin',
+            description: { format: 'encoded' }
+        };
+    }
+
+    // Camera frame: saved as its JPEG, replayed at full resolution
+    if (input && typeof input === 'object' && typeof input.reduce === 'number' && !input.width) {
+        return describeInput(input.data);
+    }
+
+    // Image with region hints: saved as the image, the hints kept in the description
+    if (input && typeof input === 'object' && Array.isArray(input.roi) && !ArrayBuffer.isView(input)) {
+        const described = describeInput(input.data);
+        if (described) {
+            described.description.roi = input.roi;
+        }
+        return described;
+    }
+
+    const encoded = toBuffer(input);
+    if (encoded) {
+        return {
+            bytes: encoded,
+            ext: encodedExtension(encoded),
+            description: { format: 'encoded' }
+        };
+    }
+
+    if (input && typeof input === 'object' && input.width && input.height && !input.shm) {
+        const data = toBuffer(input.data);
+        if (!data) {
+            return null;
+        }
+        return {
+            bytes: data,
+            ext: '.raw',
+            description: {
+                format: 'raw',
+                width: input.width,
+                height: input.height,
+                colorSpace: input.colorSpace || null
+            }
+        };
+    }
+    return null;
+}
+
+/**
+ * Like describeInput(), with the bytes copied so the caller may reuse its buffer
+ */
+function snapshotInput(input) {
+    const described = describeInput(input);
+    if (described && described.bytes) {
+        described.bytes = Buffer.from(described.bytes);
+    }
+    return described;
+}
+
+class SlowFrameCapture {
+    /**
+     * @param {object} options
+     * @param {string} options.directory - Capture directory (created if missing)
+     * @param {number} options.thresholdMs - Capture images slower than this
+     * @param {number} options.quotaBytes - Stop capturing once the directory holds this much
+     * @param {function} [options.onWarn] - Receives capture warnings (once per cause)
+     */
+    constructor(options) {
+        this.directory = options.directory;
+        this.thresholdMs = options.thresholdMs;
+        this.quotaBytes = options.quotaBytes;
+        this.onWarn = options.onWarn || (() => {});
+        this.usedBytes = 0;
+        this.writes = new Set();
+        this.sequence = 0;
+        this.warned = new Set();
+        this.ready = this.scan().catch((err) => {
+            this.warnOnce('write', `Slow-frame capture directory unavailable: ${err.message}`);
+        });
+    }
+
+    /**
+     * Account for captures left by earlier runs
+     */
+    async scan() {
+        await fs.promises.mkdir(this.directory, { recursive: true });
+        for (const name of await fs.promises.readdir(this.directory)) {
+            const stat = await fs.promises.stat(path.join(this.directory, name));
+            if (stat.isFile()) {
+                this.usedBytes += stat.size;
+            }
+        }
+    }
+
+    warnOnce(cause, message) {
+        if (!this.warned.has(cause)) {
+            this.warned.add(cause);
+            this.onWarn(message);
+        }
+    }
+
+    /**
+     * Save the image when elapsedMs exceeds the threshold. Returns at once,
+     * the files are written in the background.
+     *
+     * @param {*} input - Image as received by the node
+     * @param {object} config - { blocks, executionMode, ... }
+     * @param {object} timings - Stage breakdown of the image
+     * @param {number} elapsedMs - Time the image took
+     * @param {object} [meta] - Extra fields for the metadata file (node id/name, msg id)
+     */
+    capture(input, config, timings, elapsedMs, meta) {
+        if (elapsedMs < this.thresholdMs) {
+            return false;
+        }
+        if (this.writes.size >= MAX_PENDING) {
+            this.warnOnce('pending', 'Slow-frame capture cannot keep up, frames are being skipped');
+            return false;
+        }
+
+        const snapshot = snapshotInput(input);
+        if (!snapshot) {
+            this.warnOnce('input', 'Slow-frame capture skipped an input that cannot be saved (shared-memory frame or later document page)');
+            return false;
+        }
+
+        const id = `${new Date().toISOString().replace(/[:.]/g, '-')}-${String(this.sequence++).padStart(6, '0')}`;
+        const metadata = JSON.stringify({
+            capture: 1,
+            capturedAt: new Date().toISOString(),
+            elapsedMs: elapsedMs,
+            input: { file: id + snapshot.ext, ...snapshot.description },
+            config: { blocks: config.blocks, executionMode: config.executionMode, jpegPrescan: config.jpegPrescan },
+            timings: timings,
+            ...meta
+        }, null, 2);
+
+        const imageFile = path.join(this.directory, id + snapshot.ext);
+        let size = 0;
+        const write = this.ready
+            .then(() => snapshot.path ? fs.promises.stat(snapshot.path).then(stat => stat.size) : snapshot.bytes.byteLength)
+            .then((imageBytes) => {
+                if (this.usedBytes + imageBytes + Buffer.byteLength(metadata) > this.quotaBytes) {
+                    this.warnOnce('quota', `Slow-frame capture quota reached (${this.directory})`);
+                    return;
+                }
+                size = imageBytes + Buffer.byteLength(metadata);
+                this.usedBytes += size;
+                // Image files are copied file to file, never read into the JS heap
+                return (snapshot.path ? fs.promises.copyFile(snapshot.path, imageFile) : fs.promises.writeFile(imageFile, snapshot.bytes))
+                    .then(() => fs.promises.writeFile(path.join(this.directory, id + '.json'), metadata));
+            })
+            .catch((err) => {
+                this.usedBytes -= size;
+                this.warnOnce('write', `Slow-frame capture failed: ${err.message}`);
+            })
+            .finally(() => {
+                this.writes.delete(write);
+            });
+        this.writes.add(write);
+        return true;
+    }
+
+    /**
+     * Wait for the captures still being written
+     */
+    close() {
+        return Promise.all(this.writes);
+    }
+}
+
+module.exports = { SlowFrameCapture, describeInput, snapshotInput };
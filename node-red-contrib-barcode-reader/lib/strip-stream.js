@@ -0,0 +1,142 @@
+/**
+ * Streaming decode of line-scan images too tall to hold as one frame.
+ *
+ * A scan arrives as a series of messages, each carrying a strip of raw rows:
+ * { strip: "<scan id>", data, width, colorSpace, symbolRows, end }. The
+ * native scanner (src/strip.cpp) keeps a window of 2 x symbolRows rows and
+ * decodes it every symbolRows rows, so memory is the window whatever the
+ * length of the scan; a symbol cut by a window boundary is reported once.
+ * Strips of one scan are appended in arrival order on the libuv thread pool.
+ * A scan that receives no strip for idleMs (a camera that disconnected, a
+ * flow that never sends `end`) is dropped with its window, and at most
+ * maxScans scans are open at once.
+ */
+
+const DEFAULT_SYMBOL_ROWS = 1024;
+
+// Scans without a strip for this long are dropped
+const DEFAULT_IDLE_MS = 60000;
+
+// Open scans per node; each holds a window of up to 500 MB
+const DEFAULT_MAX_SCANS = 16;
+
+/**
+ * Strip message: { strip: "<id>", data: Buffer, width }
+ */
+function isStripInput(input) {
+    return input !== null && typeof input === 'object' && !Array.isArray(input) &&
+        typeof input.strip === 'string' && typeof input.width === 'number';
+}
+
+class StripStreams {
+    /**
+     * @param {object} options
+     * @param {object} options.barcode - Native addon (needs stripOpen/stripAppend/stripFinish)
+     * @param {object} options.config - Node configuration ({ blocks, executionMode })
+     * @param {number} [options.idleMs] - Drop scans idle for this long (default 60 s)
+     * @param {number} [options.maxScans] - Open scans allowed at once (default 16)
+     */
+    constructor(options) {
+        this.barcode = options.barcode;
+        this.configJson = JSON.stringify({
+            blocks: options.config.blocks || [],
+            executionMode: options.config.executionMode || 'parallel'
+        });
+        // Open scans by id: { handle, colorSpace, tail (promise of the last append), lastChunk }
+        this.streams = new Map();
+        this.idleMs = options.idleMs || DEFAULT_IDLE_MS;
+        this.maxScans = options.maxScans || DEFAULT_MAX_SCANS;
+        this.sweeper = setInterval(() => this.sweep(), Math.max(1000, this.idleMs / 2));
+        this.sweeper.unref();
+    }
+
+    /**
+     * Append one strip message
+     *
+     * @returns {Promise<{results: Array, warnings: string[], rows: number, finished: boolean}>}
+     *   the symbols completed by this strip, in pixels with y counted from
+     *   the first row of the scan; `rows` is the scan height so far
+     */
+    append(input) {
+        let stream = this.streams.get(input.strip);
+        if (!stream) {
+            if (this.streams.size >= this.maxScans) {
+                this.sweep();
+            }
+            if (this.streams.size >= this.maxScans) {
+                throw new Error(`Too many open strip scans (${this.maxScans}): end a scan before starting another`);
+            }
+            const colorSpace = input.colorSpace || 'GRAY';
+            stream = {
+                handle: this.barcode.stripOpen(this.configJson, {
+                    width: input.width,
+                    colorSpace: colorSpace,
+                    symbolRows: input.symbolRows || DEFAULT_SYMBOL_ROWS
+                }),
+                colorSpace: colorSpace,
+                tail: Promise.resolve(),
+                lastChunk: 0
+            };
+            this.streams.set(input.strip, stream);
+        }
+        stream.lastChunk = Date.now();
+
+        // Strips of a scan are decoded one after the other, in arrival order
+        const run = stream.tail.then(async () => {
+            const data = input.data;
+            const parts = [];
+            if (data && data.length > 0) {
+                if (input.colorSpace && input.colorSpace !== stream.colorSpace) {
+                    throw new Error(`Strip colorSpace ${input.colorSpace} differs from the scan (${stream.colorSpace})`);
+                }
+                parts.push(await this.barcode.stripAppend(stream.handle, data));
+            }
+            if (input.end) {
+                this.streams.delete(input.strip);
+                parts.push(await this.barcode.stripFinish(stream.handle));
+            }
+            return merge(parts, Boolean(input.end));
+        });
+
+        // A failed strip ends its scan; the next strip with this id starts a new one
+        stream.tail = run.catch(() => {
+            if (this.streams.get(input.strip) === stream) {
+                this.streams.delete(input.strip);
+            }
+        });
+        return run;
+    }
+
+    /**
+     * Drop the scans that received no strip for idleMs; their windows are
+     * freed with the handles
+     */
+    sweep() {
+        const now = Date.now();
+        for (const [id, stream] of this.streams) {
+            if (now - stream.lastChunk >= this.idleMs) {
+                this.streams.delete(id);
+            }
+        }
+    }
+
+    /**
+     * Drop every open scan (their windows are freed with the handles)
+     */
+    close() {
+        clearInterval(this.sweeper);
+        this.streams.clear();
+    }
+}
+
+function merge(parts, finished) {
+    const merged = { results: [], warnings: [], rows: 0, finished: finished };
+    for (const part of parts) {
+        merged.results.push(...JSON.parse(part.results));
+        merged.warnings.push(...part.warnings);
+        merged.rows = part.rows;
+    }
+    return merged;
+}
+
+module.exports = { StripStreams, isStripInput };
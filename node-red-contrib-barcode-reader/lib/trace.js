@@ -0,0 +1,91 @@
+/**
+ * Opt-in span tracing in the Chrome trace-event format (chrome://tracing,
+ * https://ui.perfetto.dev).
+ *
+ * The native engine records block stages (input decode, colour conversion,
+ * scale, preprocessing, decoder) into a ring buffer per process, tagged with
+ * the thread, image and block; the JavaScript side adds image, queue-wait and
+ * Quagga2 spans on the same clock. Process-mode workers keep their own ring,
+ * start/stop/collect are forwarded to them over IPC.
+ */
+const fs = require('fs');
+
+const DEFAULT_CAPACITY = 65536;
+
+// Registered worker pools: node id -> pool
+const pools = new Map();
+
+function registerPool(id, pool) {
+    pools.set(id, pool);
+}
+
+function unregisterPool(id) {
+    pools.delete(id);
+}
+
+/**
+ * Span start timestamp, or 0 when tracing is off
+ */
+function now(barcode) {
+    return barcode.traceEnabled && barcode.traceEnabled() ? barcode.traceNow() : 0;
+}
+
+/**
+ * Record a span started with now(); args: { image, block }
+ */
+function span(barcode, name, start, args) {
+    if (start) {
+        barcode.traceSpan(name, start, barcode.traceNow(), args || {});
+    }
+}
+
+async function broadcast(command) {
+    const replies = await Promise.all(Array.from(pools.values(), pool => pool.control(command)));
+    return replies.flat();
+}
+
+/**
+ * Clear the ring buffers and start recording (at most `capacity` spans per process)
+ */
+async function start(barcode, capacity) {
+    capacity = parseInt(capacity, 10) || DEFAULT_CAPACITY;
+    barcode.traceThreadName('node-red');
+    barcode.traceStart(capacity);
+    await broadcast({ name: 'traceStart', capacity: capacity });
+}
+
+async function stop(barcode) {
+    barcode.traceStop();
+    await broadcast({ name: 'traceStop' });
+}
+
+/**
+ * Trace document with the spans of this process and of every decode process
+ */
+async function collect(barcode) {
+    const events = JSON.parse(barcode.traceEvents());
+    for (const reply of await broadcast({ name: 'traceEvents' })) {
+        events.push(...JSON.parse(reply));
+    }
+    return { traceEvents: events, displayTimeUnit: 'ms' };
+}
+
+/**
+ * Write the collected trace to a file, returns the number of events
+ */
+async function flush(barcode, file) {
+    const trace = await collect(barcode);
+    await fs.promises.writeFile(file, JSON.stringify(trace));
+    return trace.traceEvents.length;
+}
+
+module.exports = {
+    registerPool,
+    unregisterPool,
+    now,
+    span,
+    start,
+    stop,
+    collect,
+    flush
+};
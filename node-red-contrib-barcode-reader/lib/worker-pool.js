@@ -0,0 +1,427 @@
+/**
+ * Pool of decode workers for the worker and process isolation modes.
+ *
+ * Jobs are dispatched to idle workers in FIFO order. A worker that dies fails
+ * its current job and is replaced, the Node-RED runtime keeps running.
+ * Workers that keep dying before they are ready (addon fails to load, heap
+ * limits too small, ...) are restarted with exponential backoff; after
+ * RESTART_LIMIT such failures in a row the pool gives up and fails its jobs.
+ *
+ * - 'thread' workers (worker_threads): pixel buffers are copied once into a
+ *   fresh ArrayBuffer and transferred, so postMessage does not clone them
+ *   again; SharedArrayBuffer inputs, and Buffer/TypedArray views
+ *   over one, are shared as-is.
+ * - 'process' workers (child processes): frames are copied once into a
+ *   shared-memory slot (lib/shm-ring.js) and only a descriptor crosses the
+ *   IPC channel. Frames that do not fit a slot are sent over IPC instead.
+ *   A native crash in a decoder only takes down its own process.
+ */
+const path = require('path');
+const { fork } = require('child_process');
+const { Worker } = require('worker_threads');
+const { ShmRing } = require('./shm-ring');
+const trace = require('./trace');
+
+const WORKER_SCRIPT = path.join(__dirname, 'decode-worker.js');
+
+// Fits an 8 MP grayscale or 2 MP RGB frame
+const DEFAULT_SLOT_SIZE = 8 * 1024 * 1024;
+
+// How long a control command (metrics scrape, trace collection) waits for a busy decode process
+const CONTROL_TIMEOUT_MS = 2000;
+
+// Restart backoff: doubles from RESTART_DELAY_MS up to RESTART_MAX_DELAY_MS
+// while workers die before reporting ready
+const RESTART_DELAY_MS = 100;
+const RESTART_MAX_DELAY_MS = 10000;
+const RESTART_LIMIT = 8;
+
+/**
+ * Copy a Buffer/TypedArray into a standalone ArrayBuffer that can be transferred
+ */
+function toTransferable(view, transferList) {
+    const arrayBuffer = new ArrayBuffer(view.byteLength);
+    new Uint8Array(arrayBuffer).set(new Uint8Array(view.buffer, view.byteOffset, view.byteLength));
+    transferList.push(arrayBuffer);
+    return arrayBuffer;
+}
+
+/**
+ * SharedArrayBuffer, or a Buffer/TypedArray view over one
+ */
+function isShared(data) {
+    return data instanceof SharedArrayBuffer || (ArrayBuffer.isView(data) && data.buffer instanceof SharedArrayBuffer);
+}
+
+/**
+ * Prepare an image input for postMessage, returns [message input, transfer list]
+ */
+function packInput(input) {
+    const transferList = [];
+
+    // Shared memory is posted as-is: the worker sees the producer's pixels
+    if (isShared(input)) {
+        return [input, transferList];
+    }
+    if (ArrayBuffer.isView(input)) {
+        return [toTransferable(input, transferList), transferList];
+    }
+    if (input && typeof input === 'object') {
+        if (isShared(input.data)) {
+            return [input, transferList];
+        }
+        if (ArrayBuffer.isView(input.data)) {
+            return [{ ...input, data: toTransferable(input.data, transferList) }, transferList];
+        }
+    }
+    return [input, transferList];
+}
+
+class WorkerPool {
+    /**
+     * @param {object} options
+     * @param {number} options.size - Number of workers
+     * @param {string} [options.mode] - 'thread' (default) or 'process'
+     * @param {function} [options.onWarn] - Receives warnings raised by the pipeline
+     * @param {function} [options.onError] - Receives the error when the pool gives up restarting workers
+     * @param {object} [options.resourceLimits] - Worker heap limits (thread mode)
+     * @param {object} [options.barcode] - Native addon, used to create the frame slots (process mode)
+     *   and to record queue-wait trace spans
+     * @param {number} [options.slotSize] - Largest frame passed through shared memory (process mode)
+     * @param {Array} [options.placements] - Per-worker { cpus, numaNode } from lib/affinity.js
+     */
+    constructor(options) {
+        this.size = Math.max(1, options.size || 1);
+        this.mode = options.mode || 'thread';
+        this.onWarn = options.onWarn || (() => {});
+        this.onError = options.onError || (() => {});
+        this.resourceLimits = options.resourceLimits;
+        this.barcode = options.barcode || null;
+        this.workers = [];
+        this.queue = [];
+        this.nextJobId = 1;
+        this.closed = false;
+        this.placements = options.placements || [];
+        this.rings = new Map();
+        this.restarts = 0;
+        this.failures = 0;
+        this.failed = null;
+        this.controlRequests = new Map();
+        this.nextControlId = 1;
+
+        if (this.mode === 'process' && options.barcode) {
+            this.createRings(options.barcode, options.slotSize || DEFAULT_SLOT_SIZE);
+        }
+
+        for (let i = 0; i < this.size; i++) {
+            this.workers.push(this.spawn(i));
+        }
+    }
+
+    placement(index) {
+        return this.placements[index] || { cpus: null, numaNode: -1 };
+    }
+
+    /**
+     * One frame ring per NUMA node in use, with its memory on that node,
+     * holding one slot per worker of the node
+     */
+    createRings(barcode, slotSize) {
+        const workersPerNode = new Map();
+        for (let i = 0; i < this.size; i++) {
+            const node = this.placement(i).numaNode;
+            workersPerNode.set(node, (workersPerNode.get(node) || 0) + 1);
+        }
+
+        try {
+            for (const [node, count] of workersPerNode) {
+                this.rings.set(node, new ShmRing(barcode, count, slotSize, node));
+            }
+        } catch (err) {
+            this.onWarn(`Shared memory unavailable, frames will be sent over IPC: ${err.message}`);
+            this.closeRings();
+        }
+    }
+
+    closeRings() {
+        for (const ring of this.rings.values()) {
+            ring.close();
+        }
+        this.rings.clear();
+    }
+
+    /**
+     * Start a worker and attach its lifecycle handlers
+     */
+    spawn(index) {
+        const placement = this.placement(index);
+        const slot = {
+            worker: this.mode === 'process'
+                ? fork(WORKER_SCRIPT, [], {
+                    serialization: 'advanced',
+                    env: { ...process.env, BARCODE_WORKER_PLACEMENT: JSON.stringify(placement) }
+                })
+                : new Worker(WORKER_SCRIPT, {
+                    resourceLimits: this.resourceLimits,
+                    workerData: { placement: placement }
+                }),
+            ring: this.rings.get(placement.numaNode) || null,
+            job: null,
+            lastError: null,
+            restartTimer: null
+        };
+
+        slot.worker.on('message', (message) => this.handleMessage(slot, message));
+        slot.worker.on('error', (err) => {
+            slot.lastError = err;
+        });
+        slot.worker.on('exit', (code, signal) => this.handleExit(slot, signal || code));
+
+        return slot;
+    }
+
+    /**
+     * Send a job to a worker, through shared memory when possible
+     */
+    post(slot, job) {
+        if (this.mode === 'process') {
+            const packed = slot.ring ? slot.ring.pack(job.input) : null;
+            job.frameSlot = packed ? packed.slot : null;
+            slot.worker.send({ id: job.id, input: packed ? packed.input : job.input, config: job.config });
+            return;
+        }
+
+        const [input, transferList] = packInput(job.input);
+        slot.worker.postMessage({ id: job.id, input: input, config: job.config }, transferList);
+    }
+
+    /**
+     * Detach the finished job from its worker and free its frame slot
+     */
+    finish(slot) {
+        const job = slot.job;
+        slot.job = null;
+        if (slot.ring && job) {
+            slot.ring.release(job.frameSlot);
+        }
+        return job;
+    }
+
+    handleMessage(slot, message) {
+        if (message.type === 'ready') {
+            // The worker loaded the addon: its next death restarts the backoff
+            this.failures = 0;
+            return;
+        }
+        if (message.type === 'warn') {
+            this.onWarn(message.message);
+            return;
+        }
+        if (message.type === 'control') {
+            const request = this.controlRequests.get(message.id);
+            if (request) {
+                request(message.reply);
+            }
+            return;
+        }
+
+        const job = slot.job;
+        if (!job || message.id !== job.id) {
+            return;
+        }
+
+        this.finish(slot);
+        if (message.type === 'result') {
+            if (job.timings) {
+                Object.assign(job.timings, message.timings, { queueWaitMs: job.queueWaitMs });
+            }
+            job.resolve(message.results);
+        } else {
+            job.reject(new Error(message.message));
+        }
+        this.dispatch();
+    }
+
+    handleExit(slot, code) {
+        const index = this.workers.indexOf(slot);
+        if (index === -1) {
+            return;
+        }
+
+        if (slot.job) {
+            const reason = slot.lastError ? slot.lastError.message : `exit code ${code}`;
+            this.finish(slot).reject(new Error(`Decode worker terminated (${reason})`));
+        }
+
+        if (this.closed || this.failed) {
+            this.workers.splice(index, 1);
+            return;
+        }
+
+        // Replace the dead worker once the backoff expires; until then the
+        // slot has no worker and no job is dispatched to it
+        slot.worker = null;
+        this.failures++;
+        if (this.failures > RESTART_LIMIT) {
+            const reason = slot.lastError ? slot.lastError.message : `exit code ${code}`;
+            this.fail(new Error(`Decode workers keep failing to start (${reason})`));
+            return;
+        }
+        slot.restartTimer = setTimeout(() => {
+            slot.restartTimer = null;
+            const current = this.workers.indexOf(slot);
+            if (current === -1) {
+                return;
+            }
+            this.restarts++;
+            this.workers[current] = this.spawn(current);
+            this.dispatch();
+        }, Math.min(RESTART_DELAY_MS * 2 ** (this.failures - 1), RESTART_MAX_DELAY_MS));
+    }
+
+    /**
+     * Give up on the pool: stop restarting workers and reject queued and
+     * future jobs with err
+     */
+    fail(err) {
+        this.failed = err;
+        for (const slot of this.workers) {
+            clearTimeout(slot.restartTimer);
+        }
+        this.workers = this.workers.filter(slot => slot.worker);
+        for (const job of this.queue.splice(0)) {
+            job.reject(err);
+        }
+        this.onWarn(err.message);
+        this.onError(err);
+    }
+
+    /**
+     * Run the block pipeline for one image on the next idle worker
+     *
+     * @param {object} [timings] - Receives the pipeline stage times of the
+     *   worker and queueWaitMs, the time the job waited for a free worker
+     */
+    run(input, config, timings) {
+        if (this.closed) {
+            return Promise.reject(new Error('Worker pool is closed'));
+        }
+        if (this.failed) {
+            return Promise.reject(this.failed);
+        }
+
+        return new Promise((resolve, reject) => {
+            this.queue.push({
+                id: this.nextJobId++,
+                input,
+                config,
+                timings,
+                queuedAt: process.hrtime.bigint(),
+                traceStart: this.barcode ? trace.now(this.barcode) : 0,
+                resolve,
+                reject
+            });
+            this.dispatch();
+        });
+    }
+
+    /**
+     * Current occupancy: { busy, idle, queued, restarts }
+     */
+    stats() {
+        const busy = this.workers.filter(slot => slot.job || !slot.worker).length;
+        return {
+            busy: busy,
+            idle: this.workers.length - busy,
+            queued: this.queue.length,
+            restarts: this.restarts
+        };
+    }
+
+    /**
+     * Send a control command ({ name, ... }, see decode-worker.js) to every
+     * decode process and resolve with their replies. Worker threads share the
+     * native state of the main process, so thread pools return none.
+     */
+    control(command) {
+        if (this.mode !== 'process' || this.closed) {
+            return Promise.resolve([]);
+        }
+
+        const replies = this.workers.filter(slot => slot.worker).map(slot => new Promise((resolve) => {
+            const id = this.nextControlId++;
+            const timer = setTimeout(() => done(undefined), CONTROL_TIMEOUT_MS);
+            const done = (reply) => {
+                clearTimeout(timer);
+                this.controlRequests.delete(id);
+                resolve(reply);
+            };
+            this.controlRequests.set(id, done);
+
+            try {
+                slot.worker.send({ type: 'control', id: id, command: command });
+            } catch (err) {
+                done(undefined);
+            }
+        }));
+        return Promise.all(replies).then(list => list.filter(reply => reply !== undefined));
+    }
+
+    dispatch() {
+        for (const slot of this.workers) {
+            if (this.queue.length === 0) {
+                return;
+            }
+            if (slot.job || !slot.worker) {
+                continue;
+            }
+
+            const job = this.queue.shift();
+            job.queueWaitMs = Number(process.hrtime.bigint() - job.queuedAt) / 1e6;
+            if (job.traceStart) {
+                trace.span(this.barcode, 'queue_wait', job.traceStart, { image: job.config.image });
+            }
+            slot.job = job;
+
+            try {
+                this.post(slot, job);
+            } catch (err) {
+                this.finish(slot);
+                job.reject(err);
+            }
+        }
+    }
+
+    /**
+     * Fail queued jobs and terminate all workers
+     */
+    async close() {
+        this.closed = true;
+
+        for (const job of this.queue.splice(0)) {
+            job.reject(new Error('Worker pool is closed'));
+        }
+
+        for (const slot of this.workers) {
+            clearTimeout(slot.restartTimer);
+        }
+        await Promise.all(this.workers.filter(slot => slot.worker).map(slot => this.terminate(slot.worker)));
+
+        this.closeRings();
+    }
+
+    terminate(worker) {
+        if (this.mode !== 'process') {
+            return worker.terminate();
+        }
+        if (worker.exitCode !== null || worker.signalCode !== null) {
+            return Promise.resolve();
+        }
+        return new Promise((resolve) => {
+            worker.once('exit', resolve);
+            worker.kill();
+        });
+    }
+}
+
+module.exports = { WorkerPool, packInput };
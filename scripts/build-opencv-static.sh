@@ -33,7 +33,8 @@ cmake -DCMAKE_BUILD_TYPE=Release \
     -DBUILD_PNG=ON \
     -DBUILD_ZLIB=ON \
     -DBUILD_WEBP=ON \
-    -DWITH_TIFF=OFF \
+    -DBUILD_TIFF=ON \
+    -DWITH_TIFF=ON \
     -DWITH_OPENJPEG=OFF \
     -DWITH_JASPER=OFF \
     -DWITH_OPENEXR=OFF \
@@ -83,6 +84,15 @@ cmake --build . --config Release --parallel "${JOBS}"
 echo "Installing OpenCV..."
 cmake --install . --config Release
 
+# The engine calls libjpeg-turbo directly for partial JPEG decodes; its
+# headers must match the bundled static library, which OpenCV does not install
+echo "Installing libjpeg-turbo headers..."
+JPEG_INCLUDE_DIR="${INSTALL_DIR}/include/libjpeg-turbo"
+mkdir -p "${JPEG_INCLUDE_DIR}"
+cp ../3rdparty/libjpeg-turbo/src/jpeglib.h ../3rdparty/libjpeg-turbo/src/jmorecfg.h \
+   ../3rdparty/libjpeg-turbo/src/jerror.h "${JPEG_INCLUDE_DIR}/"
+find 3rdparty/libjpeg-turbo -name jconfig.h -exec cp {} "${JPEG_INCLUDE_DIR}/" \;
+
 echo "=========================================="
 echo "OpenCV ${OPENCV_VERSION} built successfully!"
 echo ""
@@ -0,0 +1,270 @@
+/**
+ * Auto-tuner: writes the fastest barcode-reader configuration that reaches a
+ * target recall on a folder of sample images.
+ *
+ * 1. Discovery: thorough blocks find the symbologies present in the samples
+ *    (and the expected values, when there is no manifest.json).
+ * 2. Every candidate block is measured once per image: preprocessing x scale
+ *    ladder x decoder options (ZXing formats/binarizer/tryHarder, ZBar
+ *    symbologies/density), with formats restricted to those discovered.
+ * 3. A beam search over block orders of up to --max-blocks blocks scores
+ *    sequential and parallel execution from the measurements and keeps the
+ *    cheapest configuration meeting --target.
+ *
+ * Usage: node tools/autotune.js --images DIR [options]
+ *   --target R         Required recall, 0-1 (default: 0.99)
+ *   --max-blocks N     Longest block list (default: 4)
+ *   --scales LIST      Scale ladder in (0, 1] (default: 1,0.75,0.5); scales the
+ *                      editor does not list are shown there as an extra choice
+ *   --beam N           Beam width (default: 16)
+ *   --name NAME        Node name (default: barcode-reader)
+ *   --out FILE         Node config JSON, importable in Node-RED (default: stdout)
+ *   --report FILE      Also write the candidates and scores
+ */
+const crypto = require('crypto');
+const fs = require('fs');
+
+const { loadCorpus } = require('./lib/corpus');
+const evaluate = require('./lib/evaluate');
+
+// Symbology names as reported by ZXing (and written in manifest.json) and ZBar,
+// mapped to the ZBar configuration names
+const ZXING_TO_ZBAR = {
+    'EAN-13': 'ean13', 'EAN-8': 'ean8', 'UPC-A': 'upca', 'UPC-E': 'upce', 'ITF': 'i25',
+    'Codabar': 'codabar', 'Code39': 'code39', 'Code93': 'code93', 'Code128': 'code128',
+    'QRCode': 'qrcode', 'DataBar': 'databar', 'DataBarExpanded': 'databar-exp'
+};
+const ZBAR_TYPES = {
+    'EAN-13': 'ean13', 'EAN-8': 'ean8', 'UPC-A': 'upca', 'UPC-E': 'upce', 'ISBN-10': 'isbn10',
+    'ISBN-13': 'isbn13', 'I2/5': 'i25', 'DataBar': 'databar', 'DataBar-Exp': 'databar-exp',
+    'Codabar': 'codabar', 'CODE-39': 'code39', 'CODE-93': 'code93', 'CODE-128': 'code128',
+    'QR-Code': 'qrcode'
+};
+const ZBAR_TO_ZXING = Object.fromEntries(
+    Object.entries(ZXING_TO_ZBAR).map(([zxing, zbar]) => [zbar, zxing])
+    .concat([['isbn10', 'EAN-13'], ['isbn13', 'EAN-13']])
+);
+// UPC/ISBN are decoded through ZBar's EAN decoder
+const ZBAR_EAN_FAMILY = new Set(['upca', 'upce', 'isbn10', 'isbn13']);
+
+const DISCOVERY_BLOCKS = [
+    { decoder: 'zxing', preprocessing: 'original', options: { tryHarder: true } },
+    { decoder: 'zxing', preprocessing: 'histogram', options: { tryHarder: true } },
+    { decoder: 'zbar', preprocessing: 'original', options: {} },
+    { decoder: 'zbar', preprocessing: 'otsu', options: {} }
+];
+
+function parseArgs(argv) {
+    const args = {
+        images: null, target: '0.99', 'max-blocks': '4', scales: '1,0.75,0.5',
+        beam: '16', name: 'barcode-reader', out: null, report: null
+    };
+    for (let i = 0; i < argv.length; i += 2) {
+        const key = (argv[i] || '').replace(/^--/, '');
+        if (!(key in args) || argv[i + 1] === undefined) {
+            console.error('Usage: node tools/autotune.js --images DIR [--target R] [--max-blocks N] [--scales LIST] ' +
+                '[--beam N] [--name NAME] [--out FILE] [--report FILE]');
+            process.exit(1);
+        }
+        args[key] = argv[i + 1];
+    }
+    if (!args.images) {
+        console.error('--images is required');
+        process.exit(1);
+    }
+    return args;
+}
+
+/**
+ * Formats present in the samples, from the manifest or from the discovery run
+ */
+function discoverFormats(corpus, discovery) {
+    const zxing = new Set();
+    const zbar = new Set();
+
+    for (const item of corpus) {
+        for (const code of item.codes || []) {
+            zxing.add(code.format);
+            if (ZXING_TO_ZBAR[code.format]) {
+                zbar.add(ZXING_TO_ZBAR[code.format]);
+            }
+        }
+    }
+
+    DISCOVERY_BLOCKS.forEach((block, b) => {
+        for (const measurement of discovery[b]) {
+            for (const type of measurement.types) {
+                if (block.decoder === 'zxing') {
+                    zxing.add(type);
+                    if (ZXING_TO_ZBAR[type]) {
+                        zbar.add(ZXING_TO_ZBAR[type]);
+                    }
+                } else if (ZBAR_TYPES[type]) {
+                    zbar.add(ZBAR_TYPES[type]);
+                    zxing.add(ZBAR_TO_ZXING[ZBAR_TYPES[type]]);
+                }
+            }
+        }
+    });
+
+    if ([...zbar].some(name => ZBAR_EAN_FAMILY.has(name))) {
+        zbar.add('ean13');
+    }
+    return { zxing: [...zxing].sort().join(','), zbar: [...zbar].sort().join(',') };
+}
+
+function candidateBlocks(formats, scales) {
+    const blocks = [];
+    for (const scale of scales) {
+        for (const preprocessing of ['original', 'histogram', 'otsu']) {
+            // ZBar cannot read any of the discovered symbologies: no ZBar blocks
+            if (formats.zbar || !formats.zxing) {
+                for (const density of [1, 2]) {
+                    blocks.push({ decoder: 'zbar', preprocessing, scale, options: { symbologies: formats.zbar, density } });
+                }
+            }
+            for (const tryHarder of [false, true]) {
+                for (const binarizer of ['LocalAverage', 'GlobalHistogram']) {
+                    blocks.push({
+                        decoder: 'zxing', preprocessing, scale,
+                        options: { tryHarder, formats: formats.zxing, binarizer }
+                    });
+                }
+            }
+        }
+    }
+    return blocks;
+}
+
+/**
+ * Beam search over block orders; returns the cheapest configuration meeting
+ * the target, or the one with the best recall when none does
+ */
+function search(measurements, reference, target, maxBlocks, beamWidth) {
+    const indices = measurements.map((_, b) => b);
+    const score = (order) => {
+        const sequential = { mode: 'sequential', order, ...evaluate.scoreSequential(measurements, reference, order) };
+        if (order.length === 1) {
+            return [sequential];
+        }
+        return [sequential, { mode: 'parallel', order, ...evaluate.scoreParallel(measurements, reference, order) }];
+    };
+    const better = (a, b) => {
+        const aMeets = a.recall >= target, bMeets = b.recall >= target;
+        if (aMeets !== bMeets) {
+            return aMeets;
+        }
+        return aMeets ? a.meanMs < b.meanMs : (a.recall > b.recall || (a.recall === b.recall && a.meanMs < b.meanMs));
+    };
+
+    let best = null;
+    let beam = [[]];
+    const evaluated = [];
+
+    for (let depth = 1; depth <= maxBlocks && beam.length > 0; depth++) {
+        const expansions = [];
+        for (const order of beam) {
+            for (const b of indices) {
+                if (!order.includes(b)) {
+                    expansions.push(order.concat(b));
+                }
+            }
+        }
+
+        const scored = expansions.flatMap(score);
+        for (const entry of scored) {
+            if (!best || better(entry, best)) {
+                best = entry;
+            }
+        }
+        evaluated.push(...scored);
+
+        // Keep the orders with the best recall, and the cheapest ones already
+        // meeting the target (a later block can only add cost)
+        const sequential = scored.filter(entry => entry.mode === 'sequential');
+        const byRecall = sequential.slice().sort((a, b) => b.recall - a.recall || a.meanMs - b.meanMs);
+        beam = byRecall.filter(entry => entry.recall < target).slice(0, beamWidth).map(entry => entry.order);
+    }
+
+    return { best, evaluated };
+}
+
+function nodeConfig(name, result, blocks) {
+    return [{
+        id: crypto.randomBytes(8).toString('hex'),
+        type: 'barcode-reader',
+        z: '',
+        name: name,
+        inputValue: 'payload',
+        outputValue: 'payload',
+        executionMode: result.mode,
+        isolation: 'none',
+        workers: '',
+        pinning: 'none',
+        cpus: '',
+        blocks: result.order.map(b => blocks[b]),
+        x: 200,
+        y: 100,
+        wires: [[]]
+    }];
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const target = parseFloat(args.target);
+    const barcode = require('../index.js');
+    // Quagga2 is not part of the search: it is slower than ZBar/ZXing on every symbology it reads
+    const Quagga = null;
+
+    const corpus = loadCorpus(args.images);
+    console.error(`Discovery on ${corpus.length} images...`);
+    const discovery = await evaluate.measureBlocks(barcode, Quagga, corpus, DISCOVERY_BLOCKS);
+    const formats = discoverFormats(corpus, discovery);
+    console.error(`Formats: ZXing [${formats.zxing || 'all'}], ZBar [${formats.zbar || 'none'}]`);
+
+    const scales = args.scales.split(',').map(parseFloat).filter(scale => scale > 0 && scale <= 1);
+    const blocks = candidateBlocks(formats, scales);
+    console.error(`Measuring ${blocks.length} candidate blocks...`);
+    const measurements = await evaluate.measureBlocks(barcode, Quagga, corpus, blocks, {
+        onProgress: (done, total) => process.stderr.write(`\r${done}/${total}`)
+    });
+    process.stderr.write('\n');
+
+    const reference = evaluate.referenceValues(corpus, discovery.concat(measurements));
+    const { best, evaluated } = search(measurements, reference, target, parseInt(args['max-blocks'], 10), parseInt(args.beam, 10));
+
+    if (best.recall < target) {
+        console.error(`No configuration reaches ${(target * 100).toFixed(1)}%; best recall is ${(best.recall * 100).toFixed(1)}%`);
+    }
+    console.error(`Selected (${best.mode}, recall ${(best.recall * 100).toFixed(1)}%, ` +
+        `${best.meanMs.toFixed(2)} ms/image): ${best.order.map(b => evaluate.blockLabel(blocks[b])).join(' -> ')}`);
+
+    const json = JSON.stringify(nodeConfig(args.name, best, blocks), null, 2) + '\n';
+    if (args.out) {
+        fs.writeFileSync(args.out, json);
+    } else {
+        process.stdout.write(json);
+    }
+
+    if (args.report) {
+        const toEntry = (entry) => ({
+            mode: entry.mode,
+            blocks: entry.order.map(b => evaluate.blockLabel(blocks[b])),
+            recall: entry.recall,
+            imageRate: entry.imageRate,
+            meanMs: entry.meanMs
+        });
+        fs.writeFileSync(args.report, JSON.stringify({
+            target: target,
+            images: corpus.length,
+            formats: formats,
+            selected: toEntry(best),
+            pareto: evaluate.paretoFrontier(evaluated).map(toEntry)
+        }, null, 2) + '\n');
+    }
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+});
@@ -0,0 +1,115 @@
+/**
+ * Image corpus loader shared by the benchmark and tuning tools.
+ *
+ * A corpus is a directory of images. When it holds a manifest.json written by
+ * barcode_gen_corpus, the ground truth of every image is attached as `codes`;
+ * otherwise `codes` is null. Slow-frame capture directories (written by the
+ * node, see node-red-contrib-barcode-reader/lib/slow-frames.js) are recognised
+ * by their metadata files: raw captures are restored as bitmaps and the
+ * metadata is attached as `capture`.
+ *
+ * A packed corpus file (tools/pack-corpus.js) can be given instead of a
+ * directory: its images are Buffers over the file's memory mapping, so loading
+ * costs no read or copy and benchmarks measure the decoder, not the filesystem.
+ */
+const fs = require('fs');
+const path = require('path');
+
+const { restoreInput } = require('../../node-red-contrib-barcode-reader/lib/recorder');
+
+const IMAGE_EXTENSIONS = new Set(['.png', '.jpg', '.jpeg', '.bmp', '.tif', '.tiff', '.webp']);
+
+/**
+ * Entries of a slow-frame capture directory, oldest first
+ */
+function captureEntries(dir) {
+    return fs.readdirSync(dir)
+        .filter(name => path.extname(name) === '.json')
+        .sort()
+        .map(name => {
+            try {
+                return JSON.parse(fs.readFileSync(path.join(dir, name), 'utf8'));
+            } catch (err) {
+                return null;
+            }
+        })
+        .filter(meta => meta && meta.capture === 1 && fs.existsSync(path.join(dir, meta.input.file)))
+        .map(meta => ({ name: meta.input.file, codes: null, capture: meta }));
+}
+
+/**
+ * Entries of a packed corpus, inputs pointing into its mapping
+ */
+function packEntries(file, barcode) {
+    const pack = barcode.packRead(file);
+    const manifest = JSON.parse(pack.manifest);
+    return manifest.images.map((image, i) => ({ name: image.file, codes: image.codes || null, input: pack.images[i] }));
+}
+
+/**
+ * Load every image of a corpus directory
+ *
+ * @param {string} dir - Corpus directory or packed corpus file
+ * @param {object} [options]
+ * @param {string} [options.format] - 'encoded' (default): image file bytes;
+ *   'raw': decoded once up front into a Rosepetal bitmap, so decoding the file
+ *   format is not part of what is measured (needs options.barcode)
+ * @param {object} [options.barcode] - Native addon (loaded on demand for packed corpora)
+ * @param {number} [options.limit] - Load at most this many images
+ * @returns {Array<{name: string, input: Buffer|object, codes: Array|null, capture?: object}>}
+ */
+function loadCorpus(dir, options = {}) {
+    if (fs.statSync(dir).isFile()) {
+        const barcode = options.barcode || require('../../node-red-contrib-barcode-reader/index.js');
+        let entries = packEntries(dir, barcode);
+        if (options.limit) {
+            entries = entries.slice(0, options.limit);
+        }
+        if (entries.length === 0) {
+            throw new Error(`No images found in ${dir}`);
+        }
+        return entries.map(entry => ({
+            name: entry.name,
+            input: options.format === 'raw' && Buffer.isBuffer(entry.input) ? barcode.convertToMat(entry.input) : entry.input,
+            codes: entry.codes
+        }));
+    }
+
+    const manifestPath = path.join(dir, 'manifest.json');
+    let entries;
+
+    if (fs.existsSync(manifestPath)) {
+        const manifest = JSON.parse(fs.readFileSync(manifestPath, 'utf8'));
+        entries = manifest.images.map(image => ({ name: image.file, codes: image.codes }));
+    } else {
+        entries = captureEntries(dir);
+        if (entries.length === 0) {
+            entries = fs.readdirSync(dir)
+                .filter(name => IMAGE_EXTENSIONS.has(path.extname(name).toLowerCase()))
+                .sort()
+                .map(name => ({ name: name, codes: null }));
+        }
+    }
+
+    if (options.limit) {
+        entries = entries.slice(0, options.limit);
+    }
+    if (entries.length === 0) {
+        throw new Error(`No images found in ${dir}`);
+    }
+
+    return entries.map(entry => {
+        const data = fs.readFileSync(path.join(dir, entry.name));
+        const input = entry.capture && entry.capture.input.format === 'raw'
+            ? restoreInput(entry.capture.input, data)
+            : (options.format === 'raw' ? options.barcode.convertToMat(data) : data);
+
+        const item = { name: entry.name, input: input, codes: entry.codes };
+        if (entry.capture) {
+            item.capture = entry.capture;
+        }
+        return item;
+    });
+}
+
+module.exports = { loadCorpus };
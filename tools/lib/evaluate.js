@@ -0,0 +1,261 @@
+/**
+ * Block evaluation over a corpus, shared by tools/pareto.js and
+ * tools/autotune.js.
+ *
+ * Every candidate block runs once per image; its time and decoded values are
+ * kept in a measurement matrix. Parallel combinations and sequential orders
+ * are then scored from that matrix without decoding again, mirroring how the
+ * node runs them (parallel: all blocks, merged; sequential: stop at the first
+ * block with a result).
+ */
+const createPipeline = require('../../node-red-contrib-barcode-reader/lib/pipeline');
+
+/**
+ * Short human readable name of a block
+ */
+function blockLabel(block) {
+    const options = Object.entries(block.options || {})
+        .filter(([, value]) => value !== false && value !== undefined && value !== '')
+        .map(([key, value]) => value === true ? key : `${key}=${value}`);
+    const scale = block.scale && block.scale !== 1 ? [`x${block.scale}`] : [];
+    return [block.decoder, block.preprocessing, ...scale, ...options].join('/');
+}
+
+/**
+ * Default search space: every decoder/preprocessing pair, ZXing with and
+ * without tryHarder
+ */
+function defaultCandidateBlocks(includeQuagga) {
+    const blocks = [];
+    for (const preprocessing of ['original', 'histogram', 'otsu']) {
+        blocks.push({ decoder: 'zbar', preprocessing, options: {} });
+        blocks.push({ decoder: 'zxing', preprocessing, options: { tryHarder: false } });
+        blocks.push({ decoder: 'zxing', preprocessing, options: { tryHarder: true } });
+        if (includeQuagga) {
+            blocks.push({ decoder: 'quagga2', preprocessing, options: {} });
+        }
+    }
+    return blocks;
+}
+
+/**
+ * Compare a ground-truth text with a decoded value, tolerating the
+ * representations that differ between decoders (UPC-A reported as EAN-13,
+ * Codabar start/stop characters)
+ */
+function textMatches(truth, decoded) {
+    if (truth === decoded) {
+        return true;
+    }
+    if (/^\d+$/.test(truth) && /^\d+$/.test(decoded)) {
+        return `0${truth}` === decoded || truth === `0${decoded}`;
+    }
+    const strip = (text) => text.replace(/^[A-D](.*)[A-D]$/i, '$1');
+    return strip(truth) === strip(decoded);
+}
+
+/**
+ * Run each block on each image
+ *
+ * @returns {Array<Array<{ms: number, values: string[], types: string[], failed: boolean}>>} measurements[block][image]
+ */
+async function measureBlocks(barcode, Quagga, corpus, blocks, options = {}) {
+    const pipeline = createPipeline(barcode, Quagga);
+    const repeat = Math.max(1, options.repeat || 1);
+    const node = { warn: () => {} };
+    const measurements = blocks.map(() => []);
+
+    for (let i = 0; i < corpus.length; i++) {
+        for (let b = 0; b < blocks.length; b++) {
+            let values = [];
+            let types = [];
+            let failed = false;
+            let best = Infinity;
+
+            // Keep the fastest of `repeat` runs to reduce scheduling noise
+            for (let r = 0; r < repeat; r++) {
+                const start = process.hrtime.bigint();
+                try {
+                    const results = await pipeline.processBlock(corpus[i].input, blocks[b], b, node, Quagga);
+                    values = results.map(result => result.data);
+                    types = results.map(result => result.type);
+                } catch (err) {
+                    failed = true;
+                }
+                best = Math.min(best, Number(process.hrtime.bigint() - start) / 1e6);
+            }
+
+            measurements[b].push({ ms: best, values, types, failed });
+        }
+        if (options.onProgress) {
+            options.onProgress(i + 1, corpus.length);
+        }
+    }
+    return measurements;
+}
+
+/**
+ * Expected values per image: the corpus ground truth when available,
+ * otherwise everything any measured block decoded (pseudo ground truth)
+ */
+function referenceValues(corpus, measurements) {
+    return corpus.map((item, i) => {
+        if (item.codes) {
+            return item.codes.map(code => code.text);
+        }
+        const union = new Set();
+        for (const row of measurements) {
+            row[i].values.forEach(value => union.add(value));
+        }
+        return Array.from(union);
+    });
+}
+
+function countMatches(expected, values) {
+    return expected.filter(truth => values.some(value => textMatches(truth, value))).length;
+}
+
+function summarize(expectedTotal, matchedTotal, solvedImages, imageCount, totalMs) {
+    return {
+        recall: expectedTotal ? matchedTotal / expectedTotal : 1,
+        imageRate: imageCount ? solvedImages / imageCount : 1,
+        meanMs: imageCount ? totalMs / imageCount : 0
+    };
+}
+
+/**
+ * Score a parallel combination: all blocks run, values are merged
+ */
+function scoreParallel(measurements, reference, blockIndices) {
+    let expectedTotal = 0, matchedTotal = 0, solved = 0, totalMs = 0;
+
+    reference.forEach((expected, i) => {
+        const values = blockIndices.flatMap(b => measurements[b][i].values);
+        const matched = countMatches(expected, values);
+        expectedTotal += expected.length;
+        matchedTotal += matched;
+        solved += matched === expected.length ? 1 : 0;
+        totalMs += blockIndices.reduce((sum, b) => sum + measurements[b][i].ms, 0);
+    });
+    return summarize(expectedTotal, matchedTotal, solved, reference.length, totalMs);
+}
+
+/**
+ * Score a sequential order: blocks run until one returns a result
+ */
+function scoreSequential(measurements, reference, order) {
+    let expectedTotal = 0, matchedTotal = 0, solved = 0, totalMs = 0;
+
+    reference.forEach((expected, i) => {
+        let values = [];
+        for (const b of order) {
+            totalMs += measurements[b][i].ms;
+            if (measurements[b][i].values.length > 0) {
+                values = measurements[b][i].values;
+                break;
+            }
+        }
+        const matched = countMatches(expected, values);
+        expectedTotal += expected.length;
+        matchedTotal += matched;
+        solved += matched === expected.length ? 1 : 0;
+    });
+    return summarize(expectedTotal, matchedTotal, solved, reference.length, totalMs);
+}
+
+/**
+ * Greedy sequential order: repeatedly append the block that solves the most
+ * images still reaching it per millisecond spent on them. Stops when no
+ * block adds anything.
+ *
+ * @returns {Array<{block: number, cumulative: object}>}
+ */
+function greedySequentialOrder(measurements, reference, candidates) {
+    const order = [];
+    const steps = [];
+    let reaching = reference.map((_, i) => i);
+    const remaining = new Set(candidates);
+
+    while (remaining.size > 0 && reaching.length > 0) {
+        let best = null;
+        let bestScore = 0;
+
+        for (const b of remaining) {
+            let gain = 0, cost = 0;
+            for (const i of reaching) {
+                cost += measurements[b][i].ms;
+                const expected = reference[i];
+                if (expected.length > 0 && countMatches(expected, measurements[b][i].values) === expected.length) {
+                    gain++;
+                }
+            }
+            const score = gain / Math.max(cost, 1e-3);
+            if (gain > 0 && score > bestScore) {
+                best = b;
+                bestScore = score;
+            }
+        }
+
+        if (best === null) {
+            break;
+        }
+
+        order.push(best);
+        remaining.delete(best);
+        reaching = reaching.filter(i => measurements[best][i].values.length === 0);
+        steps.push({ block: best, cumulative: scoreSequential(measurements, reference, order) });
+    }
+    return steps;
+}
+
+/**
+ * All combinations of `indices` with 1..maxSize elements
+ */
+function combinations(indices, maxSize) {
+    const result = [];
+    const walk = (start, current) => {
+        if (current.length > 0) {
+            result.push(current.slice());
+        }
+        if (current.length === maxSize) {
+            return;
+        }
+        for (let i = start; i < indices.length; i++) {
+            current.push(indices[i]);
+            walk(i + 1, current);
+            current.pop();
+        }
+    };
+    walk(0, []);
+    return result;
+}
+
+/**
+ * Entries not dominated by a cheaper entry with equal or better recall,
+ * sorted by cost
+ */
+function paretoFrontier(entries) {
+    const sorted = entries.slice().sort((a, b) => a.meanMs - b.meanMs || b.recall - a.recall);
+    const frontier = [];
+    let bestRecall = -1;
+    for (const entry of sorted) {
+        if (entry.recall > bestRecall) {
+            frontier.push(entry);
+            bestRecall = entry.recall;
+        }
+    }
+    return frontier;
+}
+
+module.exports = {
+    blockLabel,
+    defaultCandidateBlocks,
+    textMatches,
+    measureBlocks,
+    referenceValues,
+    scoreParallel,
+    scoreSequential,
+    greedySequentialOrder,
+    combinations,
+    paretoFrontier
+};
@@ -0,0 +1,301 @@
+/**
+ * End-to-end throughput and latency harness for the barcode-reader node.
+ *
+ * Loads the node in a headless Node-RED runtime (node-red-node-test-helper),
+ * drives it with a corpus at a fixed rate or flat out, and reports for every
+ * block configuration: latency percentiles (node input to downstream node),
+ * throughput, event-loop lag and RSS. Unlike the native micro-benchmarks this
+ * includes the JavaScript pipeline (JSON.parse, dedup, output conversion),
+ * worker-pool hand-off and Node-RED message delivery.
+ *
+ * Usage: node tools/node-harness.js --corpus DIR [options]
+ *   --configs FILE     JSON { name: nodeConfig } of configurations to compare
+ *                      (default: a few representative block setups)
+ *   --rate N           Messages per second (default: 0 = flat out)
+ *   --concurrency N    Messages in flight when running flat out (default: 1)
+ *   --messages N       Measured messages per configuration (default: 200)
+ *   --duration S       Measure for S seconds instead of a message count
+ *   --warmup N         Unmeasured messages first (default: 5)
+ *   --input FORMAT     'encoded' (default) or 'raw' (pre-decoded bitmaps)
+ *   --out FILE         Write the JSON report to FILE instead of stdout
+ */
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { monitorEventLoopDelay } = require('perf_hooks');
+const helper = require('node-red-node-test-helper');
+
+const { loadCorpus } = require('./lib/corpus');
+
+helper.init(require.resolve('node-red'));
+
+const barcodeNode = require('../node-red-contrib-barcode-reader/barcode.js');
+
+const DEFAULT_CONFIGS = {
+    'zbar-original': {
+        blocks: [{ decoder: 'zbar', preprocessing: 'original', options: {} }]
+    },
+    'zxing-original': {
+        blocks: [{ decoder: 'zxing', preprocessing: 'original', options: { tryHarder: false } }]
+    },
+    'sequential-fallback': {
+        executionMode: 'sequential',
+        blocks: [
+            { decoder: 'zbar', preprocessing: 'original', options: {} },
+            { decoder: 'zxing', preprocessing: 'histogram', options: { tryHarder: false } },
+            { decoder: 'zxing', preprocessing: 'otsu', options: { tryHarder: true } }
+        ]
+    },
+    'parallel-all': {
+        executionMode: 'parallel',
+        blocks: [
+            { decoder: 'zbar', preprocessing: 'original', options: {} },
+            { decoder: 'zxing', preprocessing: 'original', options: { tryHarder: true } }
+        ]
+    }
+};
+
+function parseArgs(argv) {
+    const args = {
+        corpus: null, configs: null, rate: 0, concurrency: 1, messages: 200,
+        duration: 0, warmup: 5, input: 'encoded', out: null
+    };
+    const numeric = new Set(['rate', 'concurrency', 'messages', 'duration', 'warmup']);
+
+    for (let i = 0; i < argv.length; i += 2) {
+        const key = (argv[i] || '').replace(/^--/, '');
+        if (!(key in args) || argv[i + 1] === undefined) {
+            console.error('Usage: node tools/node-harness.js --corpus DIR [--configs FILE] [--rate N] ' +
+                '[--concurrency N] [--messages N] [--duration S] [--warmup N] [--input encoded|raw] [--out FILE]');
+            process.exit(1);
+        }
+        args[key] = numeric.has(key) ? parseFloat(argv[i + 1]) : argv[i + 1];
+    }
+    if (!args.corpus) {
+        console.error('--corpus is required');
+        process.exit(1);
+    }
+    return args;
+}
+
+function percentile(sorted, p) {
+    if (sorted.length === 0) {
+        return null;
+    }
+    const rank = Math.ceil(p / 100 * sorted.length) - 1;
+    return sorted[Math.min(sorted.length - 1, Math.max(0, rank))];
+}
+
+function startServer() {
+    return new Promise(resolve => helper.startServer(resolve));
+}
+
+function stopServer() {
+    return new Promise(resolve => helper.stopServer(resolve));
+}
+
+function loadFlow(config) {
+    const flow = [
+        { id: 'reader', type: 'barcode-reader', name: 'reader', wires: [['sink']], ...config },
+        { id: 'sink', type: 'helper' }
+    ];
+    return new Promise((resolve, reject) => {
+        helper.load(barcodeNode, flow, (err) => err ? reject(err) : resolve());
+    });
+}
+
+/**
+ * Feed the node and collect one latency sample per message
+ */
+function drive(reader, sink, corpus, options, measured) {
+    return new Promise((resolve) => {
+        const pending = new Map();
+        const latencies = [];
+        let sent = 0;
+        let completed = 0;
+        let errors = 0;
+        let nextId = 0;
+        let stopSending = false;
+        const startTime = process.hrtime.bigint();
+        const deadline = options.duration > 0 ? Date.now() + options.duration * 1000 : Infinity;
+        const total = options.duration > 0 ? Infinity : measured;
+
+        function finish() {
+            const elapsed = Number(process.hrtime.bigint() - startTime) / 1e9;
+            resolve({ latencies, completed, errors, elapsed });
+        }
+
+        function complete(msg, failed) {
+            const sentAt = pending.get(msg && msg._harnessId);
+            if (sentAt === undefined) {
+                return;
+            }
+            pending.delete(msg._harnessId);
+            completed++;
+            if (failed) {
+                errors++;
+            } else {
+                latencies.push(Number(process.hrtime.bigint() - sentAt) / 1e6);
+            }
+
+            if (!options.rate) {
+                sendNext();
+            }
+            if ((stopSending || sent >= total) && pending.size === 0) {
+                finish();
+            }
+        }
+
+        function sendNext() {
+            if (sent >= total || Date.now() >= deadline) {
+                stopSending = true;
+                return false;
+            }
+            const item = corpus[sent % corpus.length];
+            const id = nextId++;
+            pending.set(id, process.hrtime.bigint());
+            sent++;
+            reader.receive({ payload: item.input, _harnessId: id });
+            return true;
+        }
+
+        sink.on('input', (msg) => complete(msg, false));
+        reader.on('call:error', (call) => complete(call.args[1], true));
+
+        if (options.rate > 0) {
+            // Open loop: keep the schedule even when the node falls behind
+            const interval = 1000 / options.rate;
+            const scheduleStart = Date.now();
+            const tick = () => {
+                if (!sendNext()) {
+                    if (pending.size === 0) {
+                        finish();
+                    }
+                    return;
+                }
+                const delay = scheduleStart + sent * interval - Date.now();
+                setTimeout(tick, Math.max(0, delay));
+            };
+            tick();
+        } else {
+            // Closed loop: keep `concurrency` messages in flight
+            for (let i = 0; i < Math.max(1, options.concurrency); i++) {
+                sendNext();
+            }
+        }
+    });
+}
+
+async function runConfiguration(name, config, corpus, args) {
+    await loadFlow(config);
+    const reader = helper.getNode('reader');
+    const sink = helper.getNode('sink');
+
+    // Warm-up: first-call costs (addon load, worker start, JIT)
+    if (args.warmup > 0) {
+        await drive(reader, sink, corpus, { rate: 0, concurrency: args.concurrency, duration: 0 }, args.warmup);
+        reader.removeAllListeners('call:error');
+        sink.removeAllListeners('input');
+    }
+
+    if (global.gc) {
+        global.gc();
+    }
+
+    const lag = monitorEventLoopDelay({ resolution: 10 });
+    let peakRss = process.memoryUsage().rss;
+    const rssSampler = setInterval(() => {
+        peakRss = Math.max(peakRss, process.memoryUsage().rss);
+    }, 100);
+
+    lag.enable();
+    const run = await drive(reader, sink, corpus, args, args.messages);
+    lag.disable();
+    clearInterval(rssSampler);
+
+    await helper.unload();
+
+    const sorted = run.latencies.slice().sort((a, b) => a - b);
+    const mean = sorted.length ? sorted.reduce((sum, value) => sum + value, 0) / sorted.length : null;
+
+    return {
+        name: name,
+        config: config,
+        messages: run.completed,
+        errors: run.errors,
+        seconds: run.elapsed,
+        throughput: run.completed / run.elapsed,
+        latencyMs: {
+            mean: mean,
+            p50: percentile(sorted, 50),
+            p95: percentile(sorted, 95),
+            p99: percentile(sorted, 99),
+            max: sorted.length ? sorted[sorted.length - 1] : null
+        },
+        eventLoopLagMs: {
+            mean: lag.mean / 1e6,
+            p99: lag.percentile(99) / 1e6,
+            max: lag.max / 1e6
+        },
+        rssMb: {
+            peak: peakRss / 1048576,
+            end: process.memoryUsage().rss / 1048576
+        }
+    };
+}
+
+function printSummary(result) {
+    const f = (value) => value === null ? '-' : value.toFixed(1);
+    console.error(
+        `${result.name.padEnd(24)} ${f(result.throughput).padStart(8)} msg/s  ` +
+        `p50 ${f(result.latencyMs.p50)} p95 ${f(result.latencyMs.p95)} p99 ${f(result.latencyMs.p99)} ms  ` +
+        `lag p99 ${f(result.eventLoopLagMs.p99)} ms  rss ${f(result.rssMb.peak)} MB  errors ${result.errors}`
+    );
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const configs = args.configs ? JSON.parse(fs.readFileSync(args.configs, 'utf8')) : DEFAULT_CONFIGS;
+    const corpus = loadCorpus(args.corpus, {
+        format: args.input,
+        barcode: args.input === 'raw' ? require('../index.js') : null
+    });
+
+    await startServer();
+
+    const results = [];
+    for (const [name, config] of Object.entries(configs)) {
+        const result = await runConfiguration(name, config, corpus, args);
+        printSummary(result);
+        results.push(result);
+    }
+
+    await stopServer();
+
+    const report = {
+        context: {
+            date: new Date().toISOString(),
+            host_name: os.hostname(),
+            num_cpus: os.cpus().length,
+            node_version: process.version,
+            corpus: path.resolve(args.corpus),
+            images: corpus.length,
+            input: args.input,
+            rate: args.rate,
+            concurrency: args.concurrency
+        },
+        configurations: results
+    };
+
+    const json = JSON.stringify(report, null, 2) + '\n';
+    if (args.out) {
+        fs.writeFileSync(args.out, json);
+    } else {
+        process.stdout.write(json);
+    }
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+});
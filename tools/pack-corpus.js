@@ -0,0 +1,86 @@
+/**
+ * Convert an image folder into a packed corpus file.
+ *
+ * The pack holds every image of the corpus in one page-aligned file with an
+ * index and the ground truth of manifest.json (src/pack.h). Benchmarks map it
+ * and iterate the images without reading or copying, and with --input raw or
+ * gray without decoding the file format either.
+ *
+ * Usage: node tools/pack-corpus.js --corpus DIR --out FILE [options]
+ *   --input FORMAT     'encoded' (default): file bytes as they are;
+ *                      'raw': decoded BGR pixels; 'gray': decoded grayscale
+ *   --limit N          Pack at most N images
+ *
+ * Any directory tools/lib/corpus.js loads can be packed, slow-frame capture
+ * directories included.
+ */
+const path = require('path');
+
+const { loadCorpus } = require('./lib/corpus');
+
+const CHANNELS_TO_COLOR_SPACE = { 1: 'GRAY', 3: 'RGB', 4: 'RGBA' };
+
+function parseArgs(argv) {
+    const args = { corpus: null, out: null, input: 'encoded', limit: 0 };
+    for (let i = 0; i < argv.length; i += 2) {
+        const key = (argv[i] || '').replace(/^--/, '');
+        if (!(key in args) || argv[i + 1] === undefined) {
+            console.error('Usage: node tools/pack-corpus.js --corpus DIR --out FILE [--input encoded|raw|gray] [--limit N]');
+            process.exit(1);
+        }
+        args[key] = key === 'limit' ? parseInt(argv[i + 1], 10) : argv[i + 1];
+    }
+    if (!args.corpus || !args.out) {
+        console.error('--corpus and --out are required');
+        process.exit(1);
+    }
+    if (!['encoded', 'raw', 'gray'].includes(args.input)) {
+        console.error(`Unknown --input: ${args.input}`);
+        process.exit(1);
+    }
+    return args;
+}
+
+/**
+ * Image as stored in the pack for the requested format
+ */
+function packInput(barcode, input, format) {
+    if (format === 'gray') {
+        return barcode.preprocess_original(input);
+    }
+    if (format === 'raw') {
+        return barcode.convertToMat(input);
+    }
+    if (Buffer.isBuffer(input) || input.colorSpace) {
+        return input;
+    }
+    // Raw captures without a colour space
+    return { ...input, colorSpace: CHANNELS_TO_COLOR_SPACE[input.channels] };
+}
+
+function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const barcode = require('../index.js');
+    const corpus = loadCorpus(args.corpus, { limit: args.limit || undefined });
+
+    const handle = barcode.packCreate(args.out);
+    let bytes = 0;
+    for (const item of corpus) {
+        const input = packInput(barcode, item.input, args.input);
+        barcode.packAdd(handle, input);
+        bytes += Buffer.isBuffer(input) ? input.length : input.data.length;
+    }
+
+    const manifest = {
+        version: 1,
+        source: path.resolve(args.corpus),
+        input: args.input,
+        createdAt: new Date().toISOString(),
+        images: corpus.map(item => ({ file: item.name, codes: item.codes }))
+    };
+    barcode.packFinish(handle, JSON.stringify(manifest));
+
+    console.error(`Packed ${corpus.length} images (${(bytes / 1048576).toFixed(1)} MB of ${args.input} data) into ${args.out}`);
+}
+
+main();
@@ -0,0 +1,147 @@
+/**
+ * Recall-vs-cost report for block configurations.
+ *
+ * Runs every candidate block over a labelled corpus, then scores every
+ * parallel combination and sequential order of up to --max-blocks blocks and
+ * prints the Pareto frontier (no cheaper configuration reaches the same
+ * recall) and a recommended sequential order.
+ *
+ * Usage: node tools/pareto.js --corpus DIR [options]
+ *   --blocks FILE      JSON array of candidate blocks (default: every
+ *                      decoder/preprocessing pair, ZXing with/without tryHarder)
+ *   --max-blocks N     Largest combination size (default: 2)
+ *   --repeat N         Runs per block and image, fastest kept (default: 1)
+ *   --quagga true      Include Quagga2 blocks in the default candidates
+ *   --input FORMAT     'encoded' (default) or 'raw' (pre-decoded bitmaps)
+ *   --out FILE         Write the JSON report to FILE instead of stdout
+ *
+ * Without a manifest.json in the corpus, everything any candidate decodes is
+ * taken as ground truth, so recall is relative to the union of all blocks.
+ */
+const fs = require('fs');
+const path = require('path');
+
+const { loadCorpus } = require('./lib/corpus');
+const evaluate = require('./lib/evaluate');
+
+function parseArgs(argv) {
+    const args = { corpus: null, blocks: null, 'max-blocks': 2, repeat: 1, quagga: 'false', input: 'encoded', out: null };
+    for (let i = 0; i < argv.length; i += 2) {
+        const key = (argv[i] || '').replace(/^--/, '');
+        if (!(key in args) || argv[i + 1] === undefined) {
+            console.error('Usage: node tools/pareto.js --corpus DIR [--blocks FILE] [--max-blocks N] [--repeat N] ' +
+                '[--quagga true] [--input encoded|raw] [--out FILE]');
+            process.exit(1);
+        }
+        args[key] = argv[i + 1];
+    }
+    if (!args.corpus) {
+        console.error('--corpus is required');
+        process.exit(1);
+    }
+    return args;
+}
+
+function loadQuagga() {
+    try {
+        return require('@ericblade/quagga2');
+    } catch (err) {
+        return null;
+    }
+}
+
+function formatRow(entry) {
+    return `${(entry.recall * 100).toFixed(1).padStart(6)}%  ${entry.meanMs.toFixed(2).padStart(9)} ms  ` +
+        `${entry.mode.padEnd(10)} ${entry.blocks.join(' -> ')}`;
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const barcode = require('../index.js');
+    const Quagga = loadQuagga();
+
+    const blocks = args.blocks
+        ? JSON.parse(fs.readFileSync(args.blocks, 'utf8'))
+        : evaluate.defaultCandidateBlocks(args.quagga === 'true' && Quagga !== null);
+    const labels = blocks.map(evaluate.blockLabel);
+    const corpus = loadCorpus(args.corpus, { format: args.input, barcode });
+    const labelled = corpus.every(item => item.codes !== null);
+
+    console.error(`Measuring ${blocks.length} blocks on ${corpus.length} images...`);
+    const measurements = await evaluate.measureBlocks(barcode, Quagga, corpus, blocks, {
+        repeat: parseInt(args.repeat, 10),
+        onProgress: (done, total) => process.stderr.write(`\r${done}/${total}`)
+    });
+    process.stderr.write('\n');
+
+    const reference = evaluate.referenceValues(corpus, measurements);
+    const indices = blocks.map((_, b) => b);
+
+    // Every parallel combination, and the greedy sequential order of each
+    const entries = [];
+    for (const combination of evaluate.combinations(indices, parseInt(args['max-blocks'], 10))) {
+        entries.push({
+            mode: 'parallel',
+            blocks: combination.map(b => labels[b]),
+            indices: combination,
+            ...evaluate.scoreParallel(measurements, reference, combination)
+        });
+
+        if (combination.length > 1) {
+            const order = evaluate.greedySequentialOrder(measurements, reference, combination).map(step => step.block);
+            if (order.length > 0) {
+                entries.push({
+                    mode: 'sequential',
+                    blocks: order.map(b => labels[b]),
+                    indices: order,
+                    ...evaluate.scoreSequential(measurements, reference, order)
+                });
+            }
+        }
+    }
+
+    const frontier = evaluate.paretoFrontier(entries);
+    const recommended = evaluate.greedySequentialOrder(measurements, reference, indices).map(step => ({
+        block: blocks[step.block],
+        label: labels[step.block],
+        ...step.cumulative
+    }));
+
+    console.error('\nPareto frontier (recall, mean time per image, mode, blocks):');
+    frontier.forEach(entry => console.error(`  ${formatRow(entry)}`));
+    console.error('\nRecommended sequential order (cumulative):');
+    recommended.forEach((step, i) => console.error(
+        `  ${i + 1}. ${step.label.padEnd(32)} ${(step.recall * 100).toFixed(1).padStart(6)}%  ${step.meanMs.toFixed(2).padStart(9)} ms`
+    ));
+
+    const report = {
+        context: {
+            date: new Date().toISOString(),
+            corpus: path.resolve(args.corpus),
+            images: corpus.length,
+            groundTruth: labelled ? 'manifest' : 'union of all blocks',
+            input: args.input
+        },
+        blocks: blocks.map((block, b) => ({
+            block: block,
+            label: labels[b],
+            failures: measurements[b].filter(m => m.failed).length,
+            ...evaluate.scoreParallel(measurements, reference, [b])
+        })),
+        combinations: entries,
+        pareto: frontier,
+        recommendedSequential: recommended
+    };
+
+    const json = JSON.stringify(report, null, 2) + '\n';
+    if (args.out) {
+        fs.writeFileSync(args.out, json);
+    } else {
+        process.stdout.write(json);
+    }
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+});
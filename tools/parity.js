@@ -0,0 +1,176 @@
+/**
+ * Check that the two block pipelines give the same results.
+ *
+ * ZBar and ZXing blocks run in two implementations kept in step by hand:
+ * lib/pipeline.js in the node (block defaults, sequential early exit, scale
+ * back, deduplication, output format) and src/pipeline.cpp in the engine,
+ * used by barcode_scan, barcode_serve and the C API. This tool scans every
+ * image of a corpus directory with both, barcode_scan in a child process and
+ * lib/pipeline.js in this one, and compares the results image by image. Both
+ * decode the files the same way (decode_image_file, or decode_image_page for
+ * TIFF pages), so any difference is in the pipelines.
+ *
+ * Usage: node tools/parity.js --images DIR --config FILE [options]
+ *   --images DIR       Corpus directory (image files, not recursive)
+ *   --config FILE      JSON { blocks, executionMode } with ZBar/ZXing blocks only
+ *   --scanner PATH     barcode_scan binary (default: barcode-engine/build/Release/barcode_scan)
+ *   --out FILE         Write the JSON report to FILE instead of stdout
+ *
+ * Exits with status 2 when any image differs.
+ */
+const fs = require('fs');
+const path = require('path');
+const { spawn } = require('child_process');
+
+const createPipeline = require('../node-red-contrib-barcode-reader/lib/pipeline');
+
+const IMAGE_EXTENSIONS = new Set(['.png', '.jpg', '.jpeg', '.bmp', '.tif', '.tiff', '.webp']);
+const PAGE_EXTENSIONS = new Set(['.tif', '.tiff']);
+
+// Mismatching images listed in the report
+const MAX_LISTED = 20;
+
+function parseArgs(argv) {
+    const args = {
+        images: null,
+        config: null,
+        scanner: path.join(__dirname, '..', 'barcode-engine', 'build', 'Release', 'barcode_scan'),
+        out: null
+    };
+    for (let i = 0; i < argv.length; i += 2) {
+        const key = (argv[i] || '').replace(/^--/, '');
+        if (!(key in args) || argv[i + 1] === undefined) {
+            console.error('Usage: node tools/parity.js --images DIR --config FILE [--scanner PATH] [--out FILE]');
+            process.exit(1);
+        }
+        args[key] = argv[i + 1];
+    }
+    if (!args.images || !args.config) {
+        console.error('--images and --config are required');
+        process.exit(1);
+    }
+    return args;
+}
+
+/**
+ * Results of barcode_scan, by "file#page" ("file#" for single images)
+ */
+function runScanner(scanner, configFile, files) {
+    return new Promise((resolve, reject) => {
+        const child = spawn(scanner, ['--config', configFile, '--list', '-'], { stdio: ['pipe', 'pipe', 'inherit'] });
+        let output = '';
+        child.stdout.setEncoding('utf8');
+        child.stdout.on('data', (chunk) => {
+            output += chunk;
+        });
+        child.on('error', reject);
+        child.on('close', (code) => {
+            // 2: some files could not be read, reported per file
+            if (code !== 0 && code !== 2) {
+                reject(new Error(`${scanner} exited with status ${code}`));
+                return;
+            }
+            const lines = new Map();
+            for (const line of output.split('\n').filter(Boolean)) {
+                const entry = JSON.parse(line);
+                lines.set(`${entry.file}#${entry.page ?? ''}`, entry);
+            }
+            resolve(lines);
+        });
+        child.stdin.end(files.join('\n') + '\n');
+    });
+}
+
+/**
+ * Results of lib/pipeline.js for the same images, keyed like runScanner()
+ */
+async function runNode(barcode, pipeline, config, files) {
+    const results = new Map();
+    for (const file of files) {
+        const warnings = [];
+        const node = { id: 'parity', name: 'parity', warn: (message) => warnings.push(message) };
+
+        let inputs = [{ key: `${file}#`, input: { path: file } }];
+        if (PAGE_EXTENSIONS.has(path.extname(file).toLowerCase())) {
+            // barcode_scan decodes every TIFF page with decode_image_page and
+            // tags the pages only when there are several
+            const pages = await barcode.imagePages(file).catch(() => 1);
+            inputs = Array.from({ length: pages }, (_, page) => ({
+                key: `${file}#${pages > 1 ? page : ''}`,
+                input: { path: file, page: page }
+            }));
+        }
+
+        for (const { key, input } of inputs) {
+            try {
+                results.set(key, { results: await pipeline.processSingleImage(input, config, node, null), warnings: warnings.splice(0) });
+            } catch (err) {
+                results.set(key, { error: err.message });
+            }
+        }
+    }
+    return results;
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const config = JSON.parse(fs.readFileSync(args.config, 'utf8'));
+    if ((config.blocks || []).some(block => block.decoder === 'quagga2')) {
+        throw new Error('Quagga2 blocks run in JavaScript only and cannot be compared');
+    }
+
+    const dir = path.resolve(args.images);
+    const files = fs.readdirSync(dir)
+        .filter(name => IMAGE_EXTENSIONS.has(path.extname(name).toLowerCase()))
+        .sort()
+        .map(name => path.join(dir, name));
+    if (files.length === 0) {
+        throw new Error(`No images found in ${dir}`);
+    }
+
+    const barcode = require('../index.js');
+    const pipeline = createPipeline(barcode, null);
+
+    const native = await runScanner(args.scanner, path.resolve(args.config), files);
+    const node = await runNode(barcode, pipeline, config, files);
+
+    const mismatches = [];
+    let identical = 0;
+    for (const [key, fromNode] of node) {
+        const fromEngine = native.get(key);
+        const same = fromEngine !== undefined &&
+            (fromNode.error !== undefined) === (fromEngine.error !== undefined) &&
+            JSON.stringify(fromNode.results) === JSON.stringify(fromEngine.results);
+        if (same) {
+            identical++;
+        } else if (mismatches.length < MAX_LISTED) {
+            mismatches.push({ image: key.replace(/#$/, ''), node: fromNode, engine: fromEngine || null });
+        }
+    }
+    const differing = node.size - identical;
+
+    const report = {
+        images: path.resolve(args.images),
+        config: config,
+        compared: node.size,
+        identical: identical,
+        differing: differing,
+        mismatches: mismatches
+    };
+    console.error(`${node.size} images: ${identical} identical, ${differing} differing`);
+
+    const json = JSON.stringify(report, null, 2) + '\n';
+    if (args.out) {
+        fs.writeFileSync(args.out, json);
+    } else {
+        process.stdout.write(json);
+    }
+    if (differing > 0) {
+        process.exit(2);
+    }
+}
+
+main().catch((err) => {
+    console.error(err.message);
+    process.exit(1);
+});
@@ -0,0 +1,272 @@
+/**
+ * Replay a traffic recording made with the node's Record setting.
+ *
+ * Feeds every recorded image through the block pipeline, in arrival order,
+ * either back to back or on the recorded schedule, and compares the results
+ * with what the node produced when the traffic was recorded. With the
+ * recorded configuration, any difference means the engine changed behaviour;
+ * with --config, the report shows what a new configuration gains or loses on
+ * real production traffic, next to its latency and throughput.
+ *
+ * Frame data are read from the capture through a memory mapping, so I/O does
+ * not show up in the measurement.
+ *
+ * Usage: node tools/replay.js --capture FILE [options]
+ *   --speed S          'max' (default): back to back; 'recorded': at the
+ *                      recorded arrival times; a number: recorded times
+ *                      divided by S (2 = twice as fast)
+ *   --config FILE      JSON { blocks, executionMode } to replay with instead
+ *                      of the recorded configuration
+ *   --repeat N         Replay the capture N times (default: 1)
+ *   --check true       Exit with status 2 when any result differs
+ *   --out FILE         Write the JSON report to FILE instead of stdout
+ */
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { monitorEventLoopDelay } = require('perf_hooks');
+
+const createPipeline = require('../node-red-contrib-barcode-reader/lib/pipeline');
+const { readRecording } = require('../node-red-contrib-barcode-reader/lib/recorder');
+
+// Mismatching frames listed in the report
+const MAX_LISTED = 20;
+
+function parseArgs(argv) {
+    const args = { capture: null, speed: 'max', config: null, repeat: 1, check: 'false', out: null };
+    for (let i = 0; i < argv.length; i += 2) {
+        const key = (argv[i] || '').replace(/^--/, '');
+        if (!(key in args) || argv[i + 1] === undefined) {
+            console.error('Usage: node tools/replay.js --capture FILE [--speed max|recorded|N] [--config FILE] ' +
+                '[--repeat N] [--check true] [--out FILE]');
+            process.exit(1);
+        }
+        args[key] = argv[i + 1];
+    }
+    if (!args.capture) {
+        console.error('--capture is required');
+        process.exit(1);
+    }
+    args.repeat = Math.max(1, parseInt(args.repeat, 10) || 1);
+    return args;
+}
+
+function loadQuagga() {
+    try {
+        return require('@ericblade/quagga2');
+    } catch (err) {
+        return null;
+    }
+}
+
+function percentile(sorted, p) {
+    if (sorted.length === 0) {
+        return null;
+    }
+    const rank = Math.ceil(p / 100 * sorted.length) - 1;
+    return sorted[Math.min(sorted.length - 1, Math.max(0, rank))];
+}
+
+/**
+ * Decoded symbols of a result list, as sorted "format:value" strings
+ */
+function symbols(results) {
+    return (results || []).map(result => `${result.format}:${result.value}`).sort();
+}
+
+/**
+ * Compare replayed results with the recorded ones
+ */
+function compare(recorded, replayed) {
+    if (JSON.stringify(recorded) === JSON.stringify(replayed)) {
+        return null;
+    }
+
+    const before = symbols(recorded);
+    const after = symbols(replayed);
+    const lost = before.filter(symbol => !after.includes(symbol));
+    const gained = after.filter(symbol => !before.includes(symbol));
+    return {
+        lost: lost,
+        gained: gained,
+        // Same symbols, different corners, angle or detectedBy
+        geometryOnly: lost.length === 0 && gained.length === 0
+    };
+}
+
+/**
+ * Run every frame once. 'max' awaits each frame before the next, otherwise
+ * frames are started on the recorded schedule even when the engine falls
+ * behind, so latency includes the queueing that load would cause.
+ */
+function replay(pipeline, frames, config, speed) {
+    const node = {
+        id: 'replay',
+        name: 'replay',
+        warn: (message) => console.error(`warn: ${message}`)
+    };
+    const outcomes = new Array(frames.length);
+
+    async function run(i, scheduledAt) {
+        const timings = {};
+        try {
+            const results = await pipeline.processSingleImage(frames[i].input, config, node, timings, i + 1);
+            outcomes[i] = { results: results, latencyMs: Number(process.hrtime.bigint() - scheduledAt) / 1e6 };
+        } catch (err) {
+            outcomes[i] = { error: err.message, latencyMs: Number(process.hrtime.bigint() - scheduledAt) / 1e6 };
+        }
+    }
+
+    if (speed === 'max') {
+        return (async () => {
+            for (let i = 0; i < frames.length; i++) {
+                await run(i, process.hrtime.bigint());
+            }
+            return outcomes;
+        })();
+    }
+
+    const factor = speed === 'recorded' ? 1 : parseFloat(speed);
+    if (!(factor > 0)) {
+        throw new Error(`Invalid --speed: ${speed}`);
+    }
+
+    return new Promise((resolve) => {
+        const start = process.hrtime.bigint();
+        const origin = frames.length ? frames[0].timeMs : 0;
+        const running = [];
+        let next = 0;
+
+        const tick = () => {
+            const now = Number(process.hrtime.bigint() - start) / 1e6;
+            while (next < frames.length && (frames[next].timeMs - origin) / factor <= now) {
+                const scheduledAt = start + BigInt(Math.round((frames[next].timeMs - origin) / factor * 1e6));
+                running.push(run(next, scheduledAt));
+                next++;
+            }
+            if (next < frames.length) {
+                setTimeout(tick, Math.max(0, (frames[next].timeMs - origin) / factor - now));
+            } else {
+                Promise.all(running).then(() => resolve(outcomes));
+            }
+        };
+        tick();
+    });
+}
+
+async function main() {
+    const args = parseArgs(process.argv.slice(2));
+    const barcode = require('../index.js');
+    const pipeline = createPipeline(barcode, loadQuagga());
+
+    const recording = readRecording(barcode, args.capture);
+    if (recording.frames.length === 0) {
+        throw new Error(`No frames recorded in ${args.capture}`);
+    }
+
+    const recordedConfig = recording.config ? recording.config.config : {};
+    const config = args.config ? JSON.parse(fs.readFileSync(args.config, 'utf8')) : recordedConfig;
+    if (!config.blocks || config.blocks.length === 0) {
+        throw new Error('No blocks to replay with: the recording has no configuration, pass --config');
+    }
+
+    const lag = monitorEventLoopDelay({ resolution: 10 });
+    const latencies = [];
+    const mismatches = [];
+    let identical = 0;
+    let changed = 0;
+    let errors = 0;
+    let lostTotal = 0;
+    let gainedTotal = 0;
+
+    lag.enable();
+    const start = process.hrtime.bigint();
+    for (let pass = 0; pass < args.repeat; pass++) {
+        const outcomes = await replay(pipeline, recording.frames, config, args.speed);
+
+        outcomes.forEach((outcome, i) => {
+            latencies.push(outcome.latencyMs);
+            if (outcome.error) {
+                errors++;
+                return;
+            }
+            // Compare only the first pass, later passes repeat the same work
+            const difference = pass === 0 ? compare(recording.frames[i].results, outcome.results) : null;
+            if (pass === 0 && !difference) {
+                identical++;
+            }
+            if (difference) {
+                changed++;
+                lostTotal += difference.lost.length;
+                gainedTotal += difference.gained.length;
+                if (mismatches.length < MAX_LISTED) {
+                    mismatches.push({ frame: i, msgid: recording.frames[i].msgid, ...difference });
+                }
+            }
+        });
+    }
+    const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+    lag.disable();
+
+    const sorted = latencies.slice().sort((a, b) => a - b);
+    const frames = latencies.length;
+    const report = {
+        context: {
+            date: new Date().toISOString(),
+            host_name: os.hostname(),
+            num_cpus: os.cpus().length,
+            node_version: process.version,
+            capture: path.resolve(args.capture),
+            recordedAt: recording.config ? recording.config.startedAt : null,
+            frames: recording.frames.length,
+            speed: args.speed,
+            repeat: args.repeat,
+            config: args.config ? path.resolve(args.config) : 'recorded'
+        },
+        config: config,
+        throughput: frames / seconds,
+        seconds: seconds,
+        errors: errors,
+        latencyMs: {
+            mean: sorted.length ? sorted.reduce((sum, value) => sum + value, 0) / sorted.length : null,
+            p50: percentile(sorted, 50),
+            p95: percentile(sorted, 95),
+            p99: percentile(sorted, 99),
+            max: sorted.length ? sorted[sorted.length - 1] : null
+        },
+        eventLoopLagMs: {
+            p99: lag.percentile(99) / 1e6,
+            max: lag.max / 1e6
+        },
+        results: {
+            identical: identical,
+            changed: changed,
+            lostSymbols: lostTotal,
+            gainedSymbols: gainedTotal,
+            mismatches: mismatches
+        }
+    };
+
+    const f = (value) => value === null ? '-' : value.toFixed(1);
+    console.error(
+        `${recording.frames.length} frames x ${args.repeat}: ${f(report.throughput)} img/s  ` +
+        `p50 ${f(report.latencyMs.p50)} p95 ${f(report.latencyMs.p95)} p99 ${f(report.latencyMs.p99)} ms  ` +
+        `changed ${changed} (lost ${lostTotal}, gained ${gainedTotal})  errors ${errors}`
+    );
+
+    const json = JSON.stringify(report, null, 2) + '\n';
+    if (args.out) {
+        fs.writeFileSync(args.out, json);
+    } else {
+        process.stdout.write(json);
+    }
+
+    if (args.check === 'true' && (changed > 0 || errors > 0)) {
+        process.exitCode = 2;
+    }
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+});